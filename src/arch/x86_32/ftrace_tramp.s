@@ -0,0 +1,57 @@
+; /**
+;  * @file ftrace_tramp.s
+;  * @brief Function tracer trampolines
+;  *
+;  * A traced function's entry pad is "call ftrace_entry_tramp". Both
+;  * trampolines keep every register the traced function or its caller may
+;  * still need.
+;  */
+
+[GLOBAL ftrace_entry_tramp]
+[GLOBAL ftrace_return_tramp]
+[EXTERN ftrace_entry]
+[EXTERN ftrace_exit]
+
+FTRACE_PAD_SIZE equ 5               ; see ftrace.h
+
+; /**
+;  * @brief Entry hook
+;  *
+;  * On entry [esp] is the end of the pad and [esp+4] the return address into
+;  * the traced function's caller. Calls ftrace_entry(pad, &return address),
+;  * which may replace that return address by ftrace_return_tramp.
+;  */
+ftrace_entry_tramp:
+    pushad                          ; 32 bytes
+
+    lea eax, [esp+36]               ; the caller's return address slot
+    push eax
+    mov eax, [esp+36]               ; end of the pad
+    sub eax, FTRACE_PAD_SIZE
+    push eax
+    call ftrace_entry
+    add esp, 8
+
+    popad
+    ret                             ; into the traced function
+
+; /**
+;  * @brief Return hook
+;  *
+;  * Reached by the ret of a traced function. ftrace_exit() returns the real
+;  * return address, which replaces the placeholder pushed first. eax and edx
+;  * hold the function's return value.
+;  */
+ftrace_return_tramp:
+    push 0                          ; becomes the real return address
+    push eax
+    push ecx
+    push edx
+
+    call ftrace_exit
+    mov [esp+12], eax
+
+    pop edx
+    pop ecx
+    pop eax
+    ret
@@ -7,6 +7,7 @@
 /******************************************* Includes */
 #include "gdt.h"
 #include "serial_port.h"
+#include "initcall.h"
 
 /******************************************* Static global defines */
  /** @brief Array of GDT entries */
@@ -89,4 +90,16 @@ void gdt_install(void)
 
     /* Load the new GDT and flush segment registers */
     gdt_flush(&gdt_pointer);
-}
\ No newline at end of file
+}
+
+/**
+ * @name gdt_initcall
+ *
+ * @brief Replaces the boot loader's GDT
+ */
+static int gdt_initcall(void)
+{
+    gdt_install();
+    return 0;
+}
+INITCALL_EARLY(gdt_initcall);
@@ -0,0 +1,52 @@
+/**
+ * @file idt_c.c
+ *
+ * @brief C code for setting up the interrupt descriptor table (IDT)
+ */
+
+/******************************************* Includes */
+#include "gdt.h"
+#include "idt.h"
+
+/******************************************* Static global defines */
+/** @brief Array of IDT entries */
+static IDT_ENTRY idt_entries[IDT_ENTRY_COUNT];
+
+/** @brief IDT pointer for LIDT instruction */
+static IDT idt_pointer;
+
+/**
+ * @brief Set up a single interrupt gate
+ * @param num     Vector number
+ * @param handler Address of the stub
+ * @param attr    Gate type and attributes
+ */
+static void idt_set_gate(unsigned int num, unsigned int handler, unsigned char attr)
+{
+    idt_entries[num].offset_low  = handler & 0xFFFF;
+    idt_entries[num].offset_high = (handler >> 16) & 0xFFFF;
+    idt_entries[num].selector    = GDT_KERNEL_CODE_SELECTOR;
+    idt_entries[num].zero        = 0;
+    idt_entries[num].type_attr   = attr;
+}
+
+/**
+ * @brief Initialize and install the Interrupt Descriptor Table
+ *
+ * Vectors 0 - 31 are the CPU exceptions and 32 - 47 the remapped PIC lines.
+ * All of them are interrupt gates, so interrupts are disabled on entry.
+ */
+void idt_install(void)
+{
+    unsigned int i;
+
+    idt_pointer.size = (sizeof(IDT_ENTRY) * IDT_ENTRY_COUNT) - 1;
+    idt_pointer.address = (unsigned int) &idt_entries;
+
+    for (i = 0; i < IDT_NR_VECTORS; i++)
+    {
+        idt_set_gate(i, isr_stub_table[i], IDT_KERNEL_INTERRUPT_GATE);
+    }
+
+    idt_flush(&idt_pointer);
+}
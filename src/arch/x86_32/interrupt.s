@@ -0,0 +1,127 @@
+; /**
+;  * @file interrupt.s
+;  * @brief Interrupt entry stubs and IDT loading
+;  *
+;  * Every vector gets a small stub that pushes a dummy error code (when the
+;  * CPU does not push one) and the vector number, then jumps to isr_common.
+;  * isr_common saves the registers in the INTERRUPT_FRAME layout from idt.h
+;  * and calls interrupt_dispatch() with a pointer to the frame.
+;  */
+
+[GLOBAL idt_flush]
+[GLOBAL isr_stub_table]
+[EXTERN interrupt_dispatch]
+
+; Exceptions where the CPU does not push an error code
+%macro ISR_NOERR 1
+isr_stub_%1:
+    push dword 0                    ; Dummy error code
+    push dword %1                   ; Vector number
+    jmp isr_common
+%endmacro
+
+; Exceptions where the CPU pushes an error code
+%macro ISR_ERR 1
+isr_stub_%1:
+    push dword %1                   ; Vector number
+    jmp isr_common
+%endmacro
+
+section .text
+
+; /**
+;  * @brief Load the IDT
+;  * @param idt_ptr Address of IDT pointer structure (on stack at [esp+4])
+;  */
+idt_flush:
+    mov eax, [esp+4]                ; Load IDT pointer address from stack
+    lidt [eax]                      ; Load the new IDT pointer
+    ret
+
+; CPU exceptions
+ISR_NOERR 0                         ; Divide error
+ISR_NOERR 1                         ; Debug
+ISR_NOERR 2                         ; NMI
+ISR_NOERR 3                         ; Breakpoint
+ISR_NOERR 4                         ; Overflow
+ISR_NOERR 5                         ; Bound range exceeded
+ISR_NOERR 6                         ; Invalid opcode
+ISR_NOERR 7                         ; Device not available
+ISR_ERR   8                         ; Double fault
+ISR_NOERR 9                         ; Coprocessor segment overrun
+ISR_ERR   10                        ; Invalid TSS
+ISR_ERR   11                        ; Segment not present
+ISR_ERR   12                        ; Stack-segment fault
+ISR_ERR   13                        ; General protection fault
+ISR_ERR   14                        ; Page fault
+ISR_NOERR 15                        ; Reserved
+ISR_NOERR 16                        ; x87 floating point
+ISR_ERR   17                        ; Alignment check
+ISR_NOERR 18                        ; Machine check
+ISR_NOERR 19                        ; SIMD floating point
+ISR_NOERR 20                        ; Virtualization
+ISR_ERR   21                        ; Control protection
+ISR_NOERR 22
+ISR_NOERR 23
+ISR_NOERR 24
+ISR_NOERR 25
+ISR_NOERR 26
+ISR_NOERR 27
+ISR_NOERR 28
+ISR_ERR   29                        ; VMM communication
+ISR_ERR   30                        ; Security
+ISR_NOERR 31
+
+; PIC lines 0 - 15, remapped to vectors 32 - 47
+ISR_NOERR 32                        ; IRQ 0
+ISR_NOERR 33                        ; IRQ 1
+ISR_NOERR 34                        ; IRQ 2
+ISR_NOERR 35                        ; IRQ 3
+ISR_NOERR 36                        ; IRQ 4
+ISR_NOERR 37                        ; IRQ 5
+ISR_NOERR 38                        ; IRQ 6
+ISR_NOERR 39                        ; IRQ 7
+ISR_NOERR 40                        ; IRQ 8
+ISR_NOERR 41                        ; IRQ 9
+ISR_NOERR 42                        ; IRQ 10
+ISR_NOERR 43                        ; IRQ 11
+ISR_NOERR 44                        ; IRQ 12
+ISR_NOERR 45                        ; IRQ 13
+ISR_NOERR 46                        ; IRQ 14
+ISR_NOERR 47                        ; IRQ 15
+
+isr_common:
+    pusha                           ; eax, ecx, edx, ebx, esp, ebp, esi, edi
+    push ds
+    push es
+    push fs
+    push gs
+
+    mov ax, 0x10                    ; Kernel data segment
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+
+    cld                             ; C code expects the direction flag clear
+    push esp                        ; INTERRUPT_FRAME * argument
+    call interrupt_dispatch
+    add esp, 4
+
+    pop gs
+    pop fs
+    pop es
+    pop ds
+    popa
+    add esp, 8                      ; Drop vector number and error code
+    iret
+
+section .rodata
+
+; Stub addresses, indexed by vector
+isr_stub_table:
+%assign vec 0
+%rep 48
+    dd isr_stub_%[vec]
+%assign vec vec + 1
+%endrep
@@ -21,4 +21,48 @@ global inb
 inb:
     mov dx, [esp + 4]       ; move the address of the I/O port to the dx register
     in  al, dx              ; read a byte from the I/O port and store it in the al register
-    ret                     ; return the read byte
\ No newline at end of file
+    ret                     ; return the read byte
+
+global outw
+
+; outw - send a word to an I/O port
+; stack: [esp + 8] the data word
+;        [esp + 4] the I/O port
+;        [esp    ] return address
+outw:
+    mov ax, [esp + 8]    ; move the data to be sent into the ax register
+    mov dx, [esp + 4]    ; move the address of the I/O port into the dx register
+    out dx, ax           ; send the data to the I/O port
+    ret                  ; return to the calling function
+
+global inw
+
+; inw - returns a word from the given I/O port
+; stack: [esp + 4] The address of the I/O port
+;        [esp    ] The return address
+inw:
+    mov dx, [esp + 4]       ; move the address of the I/O port to the dx register
+    in  ax, dx              ; read a word from the I/O port and store it in the ax register
+    ret                     ; return the read word
+
+global outl
+
+; outl - send a double word to an I/O port
+; stack: [esp + 8] the data double word
+;        [esp + 4] the I/O port
+;        [esp    ] return address
+outl:
+    mov eax, [esp + 8]   ; move the data to be sent into the eax register
+    mov dx, [esp + 4]    ; move the address of the I/O port into the dx register
+    out dx, eax          ; send the data to the I/O port
+    ret                  ; return to the calling function
+
+global inl
+
+; inl - returns a double word from the given I/O port
+; stack: [esp + 4] The address of the I/O port
+;        [esp    ] The return address
+inl:
+    mov dx, [esp + 4]       ; move the address of the I/O port to the dx register
+    in  eax, dx             ; read a double word from the I/O port and store it in eax
+    ret                     ; return the read double word
@@ -1,8 +1,15 @@
 global loader                 ; the entry symbol for ELF
 
 MAGIC_NUMBER equ 0x1BADB002   ; define the magic number constant
-FLAGS        equ 0x0          ; multiboot flags
-CHECKSUM     equ -MAGIC_NUMBER ; calculate the checksum
+ALIGN_MODS   equ 1<<0         ; load modules on page boundaries
+MEMINFO      equ 1<<1         ; provide the memory map
+VIDEO        equ 1<<2         ; ask for a linear framebuffer
+%ifdef VIDEO_MODE
+FLAGS        equ ALIGN_MODS | MEMINFO | VIDEO ; multiboot flags
+%else
+FLAGS        equ ALIGN_MODS | MEMINFO ; multiboot flags
+%endif
+CHECKSUM     equ -(MAGIC_NUMBER + FLAGS) ; calculate the checksum
                              ; (magic number + checksum + flags should be equal to 0)
 
 ;section .note.GNU-stack noalloc noexec nowrite progbits ; special section for stack
@@ -14,38 +21,40 @@ align 4                     ; the code must be 4 byte aligned
     dd MAGIC_NUMBER         ; write the magic number to the machine code
     dd FLAGS                ; the flags
     dd CHECKSUM             ; and the checksum
+%ifdef VIDEO_MODE
+    dd 0, 0, 0, 0, 0        ; address fields, unused for ELF kernels
+    dd 0                    ; mode type: linear graphics
+    dd VIDEO_WIDTH          ; preferred width in pixels
+    dd VIDEO_HEIGHT         ; preferred height in pixels
+    dd 32                   ; bits per pixel
+%endif
 
 loader:                     ; the loader label (defined as entry point in the linker script)
-    mov esp, kernel_stack + KERNEL_STACK_SIZE   ; point esp to the end (top) of the stack
-
-;    extern sum_of_three      ; declare external function
-
-;    push dword 3            ; arg3
-;    push dword 2            ; arg2
-;    push dword 1            ; arg1
-;    call sum_of_three       ; call the function, result in eax
-;    extern main              ; declare external funct main
-;    call main                ; call main function
-    jmp.sum
+    mov ecx, eax            ; rdtsc clobbers the multiboot magic in eax
+    rdtsc                   ; start of the boot timeline, see initcall.c
+    mov [boot_tsc], eax
+    mov [boot_tsc + 4], edx
+    mov eax, ecx
 
-.sum:
-    extern sum_of_three      ; declare external function
+    mov esp, kernel_stack + KERNEL_STACK_SIZE   ; point esp to the end (top) of the stack
 
-    push dword 3            ; arg3
-    push dword 2            ; arg2
-    push dword 1            ; arg1
-    call sum_of_three       ; call the function, result in eax
-    jmp.main
+    push ebx                ; kmain arg2: multiboot info structure
+    push eax                ; kmain arg1: multiboot magic
 
-.main:
-    extern main              ; declare external funct main
-    call main                ; call main function
+    extern kmain             ; declare external funct kmain
+    call kmain               ; call kmain function
 
 .loop:
     jmp .loop              ; loop forever
 
 
-KERNEL_STACK_SIZE equ 4096   ; size of stack in bytes
+KERNEL_STACK_SIZE equ 16384  ; size of stack in bytes
+
+section .data
+align 8
+global boot_tsc
+boot_tsc:                   ; TSC at the first instruction of the kernel
+    dd 0, 0
 
 section .bss
 align 4                     ; align at 4 bytes
@@ -0,0 +1,230 @@
+/**
+ * @file paging.c
+ *
+ * @brief Implementation of x86 32 bit paging
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "kstring.h"
+#include "pmm.h"
+#include "paging.h"
+
+/******************************************* Defines */
+#define CR0_WP                  0x00010000U  /**< Honour read-only pages in ring 0 */
+#define CR0_PG                  0x80000000U  /**< Paging enable */
+#define CR4_PSE                 0x00000010U  /**< 4 MiB pages */
+
+/******************************************* Macros */
+#define WINDOW_BIT_WORD(n)      ((n) >> 5)
+#define WINDOW_BIT_MASK(n)      (1U << ((n) & 31U))
+
+/******************************************* Static global defines */
+/** The kernel page directory */
+static unsigned int page_directory[PAGE_ENTRIES] __attribute__((aligned(PAGE_SIZE)));
+
+/** Used pages of the remap window */
+static unsigned int window_bitmap[PAGING_WINDOW_PAGES / 32U];
+
+/** Set when PAT entry 1 has been switched to write-combining */
+static int paging_wc;
+
+/******************************************* Functions */
+
+/**
+ * @name paging_invlpg
+ *
+ * @brief Drops a TLB entry
+ */
+static inline void paging_invlpg(unsigned int virt)
+{
+    asm volatile ("invlpg (%0)" :: "r" (virt) : "memory");
+}
+
+/**
+ * @name paging_init_pat
+ *
+ * @brief Turns PAT entry 1 (PWT=1, PCD=0) from write-through into WC
+ *
+ * @par Nothing uses PWT before this, so no existing mapping changes type.
+ * Caches are flushed around the write as the SDM asks for PAT changes.
+ */
+static void paging_init_pat(void)
+{
+    unsigned long long pat;
+
+    if (!(cpuid_edx() & CPUID_EDX_PAT))
+    {
+        return;
+    }
+
+    pat = rdmsr(MSR_PAT);
+    pat &= ~(0xFFULL << 8);
+    pat |= (unsigned long long) PAT_TYPE_WC << 8;
+
+    asm volatile ("wbinvd" ::: "memory");
+    wrmsr(MSR_PAT, pat);
+    asm volatile ("wbinvd" ::: "memory");
+    paging_wc = 1;
+}
+
+void paging_init(unsigned int identity_end)
+{
+    unsigned int addr;
+    unsigned int cr0;
+    unsigned int cr4;
+
+    memset(page_directory, 0, sizeof(page_directory));
+
+    /* Identity map RAM, 4 MiB at a time */
+    identity_end = ALIGN_UP(identity_end, LARGE_PAGE_SIZE);
+    if ((identity_end == 0) || (identity_end > PAGING_WINDOW_START))
+    {
+        identity_end = PAGING_WINDOW_START;
+    }
+    for (addr = 0; addr < identity_end; addr += LARGE_PAGE_SIZE)
+    {
+        page_directory[PAGE_DIR_INDEX(addr)] = addr | PAGE_LARGE | PAGE_RW | PAGE_PRESENT;
+    }
+
+    asm volatile ("mov %%cr4, %0" : "=r" (cr4));
+    asm volatile ("mov %0, %%cr4" :: "r" (cr4 | CR4_PSE));
+    asm volatile ("mov %0, %%cr3" :: "r" (page_directory) : "memory");
+    asm volatile ("mov %%cr0, %0" : "=r" (cr0));
+    asm volatile ("mov %0, %%cr0" :: "r" (cr0 | CR0_PG | CR0_WP) : "memory");
+
+    paging_init_pat();
+}
+
+int paging_map_page(unsigned int virt, unsigned int phys, unsigned int flags)
+{
+    unsigned int *table;
+    unsigned int pde = page_directory[PAGE_DIR_INDEX(virt)];
+
+    if (!(pde & PAGE_PRESENT))
+    {
+        table = pmm_alloc_page();
+        if (table == NULL)
+        {
+            return PAGING_ERR_NOMEM;
+        }
+        memset(table, 0, PAGE_SIZE);
+        pde = (unsigned int) table | PAGE_RW | PAGE_PRESENT;
+        page_directory[PAGE_DIR_INDEX(virt)] = pde;
+    }
+
+    table = (unsigned int *) (pde & PAGE_MASK);
+    table[PAGE_TABLE_INDEX(virt)] = (phys & PAGE_MASK) | flags | PAGE_PRESENT;
+    paging_invlpg(virt);
+    return PAGING_OK;
+}
+
+void paging_unmap_page(unsigned int virt)
+{
+    unsigned int *table;
+    unsigned int pde = page_directory[PAGE_DIR_INDEX(virt)];
+
+    if (!(pde & PAGE_PRESENT) || (pde & PAGE_LARGE))
+    {
+        return;
+    }
+    table = (unsigned int *) (pde & PAGE_MASK);
+    table[PAGE_TABLE_INDEX(virt)] = 0;
+    paging_invlpg(virt);
+}
+
+unsigned int paging_virt_to_phys(unsigned int virt)
+{
+    unsigned int *table;
+    unsigned int pde = page_directory[PAGE_DIR_INDEX(virt)];
+    unsigned int pte;
+
+    if (!(pde & PAGE_PRESENT))
+    {
+        return 0;
+    }
+    if (pde & PAGE_LARGE)
+    {
+        return (pde & ~(LARGE_PAGE_SIZE - 1U)) | (virt & (LARGE_PAGE_SIZE - 1U));
+    }
+    table = (unsigned int *) (pde & PAGE_MASK);
+    pte = table[PAGE_TABLE_INDEX(virt)];
+    if (!(pte & PAGE_PRESENT))
+    {
+        return 0;
+    }
+    return (pte & PAGE_MASK) | (virt & ~PAGE_MASK);
+}
+
+unsigned int paging_alloc_virt(unsigned int pages)
+{
+    unsigned int n;
+    unsigned int run = 0;
+
+    if (pages == 0)
+    {
+        return 0;
+    }
+
+    /* First fit, the window is only used for a few long lived mappings */
+    for (n = 0; n < PAGING_WINDOW_PAGES; n++)
+    {
+        if (window_bitmap[WINDOW_BIT_WORD(n)] & WINDOW_BIT_MASK(n))
+        {
+            run = 0;
+            continue;
+        }
+        if (++run == pages)
+        {
+            for (n = n + 1U - pages; run > 0; run--, n++)
+            {
+                window_bitmap[WINDOW_BIT_WORD(n)] |= WINDOW_BIT_MASK(n);
+            }
+            return PAGING_WINDOW_START + ((n - pages) << PAGE_SHIFT);
+        }
+    }
+    return 0;
+}
+
+void * paging_map_phys(unsigned int phys, unsigned int len, unsigned int flags)
+{
+    unsigned int offset = phys & ~PAGE_MASK;
+    unsigned int pages = ALIGN_UP(offset + len, PAGE_SIZE) >> PAGE_SHIFT;
+    unsigned int virt = paging_alloc_virt(pages);
+    unsigned int i;
+
+    if (virt == 0)
+    {
+        return NULL;
+    }
+    for (i = 0; i < pages; i++)
+    {
+        if (paging_map_page(virt + (i << PAGE_SHIFT),
+                            (phys & PAGE_MASK) + (i << PAGE_SHIFT), flags) != PAGING_OK)
+        {
+            while (i-- > 0)
+            {
+                paging_unmap_page(virt + (i << PAGE_SHIFT));
+            }
+            paging_free_virt(virt, pages);
+            return NULL;
+        }
+    }
+    return (void *) (virt + offset);
+}
+
+int paging_has_wc(void)
+{
+    return paging_wc;
+}
+
+void paging_free_virt(unsigned int virt, unsigned int pages)
+{
+    unsigned int n = (virt - PAGING_WINDOW_START) >> PAGE_SHIFT;
+
+    for (; (pages > 0) && (n < PAGING_WINDOW_PAGES); pages--, n++)
+    {
+        window_bitmap[WINDOW_BIT_WORD(n)] &= ~WINDOW_BIT_MASK(n);
+    }
+}
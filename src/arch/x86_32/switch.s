@@ -0,0 +1,35 @@
+; /**
+;  * @file switch.s
+;  * @brief Kernel thread context switch
+;  *
+;  * Only the registers the cdecl convention makes callee-saved are kept on
+;  * the old stack; everything else was already saved by the C caller.
+;  */
+
+[GLOBAL sched_switch]
+
+; /**
+;  * @brief void sched_switch(unsigned int * prev_esp, unsigned int next_esp)
+;  *
+;  * Pushes ebp, ebx, esi and edi, stores esp in *prev_esp, loads next_esp and
+;  * pops the same registers of the next thread. The ret then continues in
+;  * whatever called sched_switch() on that stack, or in the start routine
+;  * of a new thread (see kthread_create()).
+;  */
+sched_switch:
+    mov eax, [esp+4]                ; prev_esp
+    mov edx, [esp+8]                ; next_esp
+
+    push ebp
+    push ebx
+    push esi
+    push edi
+
+    mov [eax], esp                  ; save the old stack
+    mov esp, edx                    ; and switch to the new one
+
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+    ret
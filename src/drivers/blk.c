@@ -0,0 +1,151 @@
+/**
+ * @file blk.c
+ *
+ * @brief Implementation of the block device registry and synchronous helpers
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "kstring.h"
+#include "softirq.h"
+#include "wait.h"
+#include "rcu.h"
+#include "blk.h"
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+/** Read under RCU, devices are only ever added */
+static BLK_DEVICE *blk_devices;
+
+/**
+ * @struct BLK_WAIT
+ * @brief Shared by a batch of requests waited on by blk_submit_wait()
+ */
+typedef struct _BLK_WAIT
+{
+    volatile unsigned int remaining;  /**< Requests not completed yet */
+    int                   status;     /**< First error seen */
+    COMPLETION            done;       /**< Signalled by the last completion */
+} BLK_WAIT;
+
+/******************************************* Functions */
+void blk_register(BLK_DEVICE * dev)
+{
+    void *head;
+
+    do
+    {
+        head = blk_devices;
+        dev->next = head;
+        wmb();
+    } while (cmpxchg_ptr((void * volatile *) &blk_devices, head, dev) != head);
+}
+
+BLK_DEVICE * blk_find(const char * name)
+{
+    BLK_DEVICE *dev;
+
+    rcu_read_lock();
+    for (dev = rcu_dereference(blk_devices); dev != NULL; dev = rcu_dereference(dev->next))
+    {
+        if (strcmp(dev->name, name) == 0)
+        {
+            break;
+        }
+    }
+    rcu_read_unlock();
+    return dev;
+}
+
+/**
+ * @name blk_wait_done
+ *
+ * @brief Completion callback of blk_submit_wait()
+ */
+static void blk_wait_done(BLK_REQUEST * req, int status)
+{
+    BLK_WAIT *wait = req->priv;
+
+    if ((status != BLK_OK) && (wait->status == BLK_OK))
+    {
+        wait->status = status;
+    }
+    if (--wait->remaining == 0)
+    {
+        complete(&wait->done);
+    }
+}
+
+int blk_submit_wait(BLK_DEVICE * dev, BLK_REQUEST * reqs, unsigned int nr)
+{
+    BLK_WAIT wait;
+    unsigned int flags;
+    unsigned int i;
+    int ret;
+
+    wait.remaining = nr;
+    wait.status = BLK_OK;
+    completion_init(&wait.done);
+
+    for (i = 0; i < nr; i++)
+    {
+        reqs[i].done = blk_wait_done;
+        reqs[i].priv = &wait;
+
+        /* Queue full: start what we have and make room */
+        while ((ret = dev->submit(&reqs[i])) == BLK_ERR_BUSY)
+        {
+            dev->kick();
+            dev->poll();
+        }
+        if (ret != BLK_OK)
+        {
+            /* Account for the ones that never went out, the bottom half may
+             * be counting down the others meanwhile */
+            flags = local_irq_save();
+            wait.remaining -= nr - i;
+            local_irq_restore(flags);
+            if (wait.status == BLK_OK)
+            {
+                wait.status = ret;
+            }
+            break;
+        }
+    }
+    dev->kick();
+
+    if ((dev->flags & BLK_DEV_IRQ) && !irqs_disabled() && !in_interrupt())
+    {
+        if (wait.remaining != 0)
+        {
+            wait_for_completion(&wait.done);
+        }
+        return wait.status;
+    }
+
+    while (wait.remaining != 0)
+    {
+        if (dev->poll() == 0)
+        {
+            cpu_relax();
+        }
+    }
+    return wait.status;
+}
+
+int blk_read(BLK_DEVICE * dev, unsigned long long sector, void * buf, unsigned int len)
+{
+    BLK_REQUEST req;
+
+    memset(&req, 0, sizeof(req));
+    req.op = BLK_OP_READ;
+    req.sector = sector;
+    req.segs[0].buf = buf;
+    req.segs[0].len = len;
+    req.nr_segs = 1;
+    return blk_submit_wait(dev, &req, 1);
+}
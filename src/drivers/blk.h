@@ -0,0 +1,141 @@
+/**
+ * @file blk.h
+ *
+ * @brief Header file for asynchronous block requests
+ */
+#ifndef INCLUDE_BLK_H
+#define INCLUDE_BLK_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** Size of a block device sector */
+#define BLK_SECTOR_SIZE         512U
+/** Maximum number of data segments in one request */
+#define BLK_MAX_SEGS            16U
+
+/* Request operations */
+#define BLK_OP_READ             0U
+#define BLK_OP_WRITE            1U
+#define BLK_OP_FLUSH            4U
+
+/* BLK_DEVICE flags */
+#define BLK_DEV_IRQ             0x1U    /**< Completes requests from interrupts */
+
+/* Completion and submission status */
+#define BLK_OK                  0
+#define BLK_ERR_IO              (-1)    /**< Device reported an error */
+#define BLK_ERR_BUSY            (-2)    /**< Queue full, poll and retry */
+#define BLK_ERR_INVAL           (-3)    /**< Malformed request */
+#define BLK_ERR_NODEV           (-4)    /**< No device present */
+
+/******************************************* Typedefs/structures */
+struct _BLK_REQUEST;
+
+/**
+ * @name BLK_DONE_FN
+ *
+ * @brief Completion callback, called from the driver's poll routine with
+ * interrupts disabled, from a thread or the driver's bottom half
+ *
+ * @param req    The completed request
+ * @param status BLK_OK or BLK_ERR_IO
+ */
+typedef void (*BLK_DONE_FN)(struct _BLK_REQUEST * req, int status);
+
+/**
+ * @struct BLK_SEG
+ * @brief One scatter-gather element of a request
+ */
+typedef struct _BLK_SEG
+{
+    void         *buf;            /**< Data buffer (identity mapped) */
+    unsigned int  len;            /**< Length, a multiple of BLK_SECTOR_SIZE */
+} BLK_SEG;
+
+/**
+ * @struct BLK_REQUEST
+ * @brief An asynchronous block request
+ *
+ * The caller owns the memory and fills in the fields above "driver use".
+ * It must stay untouched until the completion callback has run.
+ */
+typedef struct _BLK_REQUEST
+{
+    unsigned int        op;           /**< BLK_OP_* */
+    unsigned long long  sector;       /**< First sector */
+    BLK_SEG             segs[BLK_MAX_SEGS]; /**< Data segments */
+    unsigned int        nr_segs;      /**< Number of used segments */
+    BLK_DONE_FN         done;         /**< Completion callback */
+    void               *priv;         /**< Owner cookie */
+
+    /* Driver use */
+    unsigned int        hdr[4];       /**< Device request header */
+    unsigned char       status;       /**< Device written status byte */
+    unsigned long long  submit_tsc;   /**< TSC at submission */
+} BLK_REQUEST;
+
+/**
+ * @struct BLK_DEVICE
+ * @brief A block device as seen by filesystems
+ *
+ * Drivers fill this in and hand it to @ref blk_register. The operations
+ * follow the virtio_blk_* semantics: submit queues, kick publishes a batch,
+ * poll reaps completions. A BLK_DEV_IRQ device also reaps them on its own
+ * when the device interrupts, so waiters may sleep instead of polling.
+ */
+typedef struct _BLK_DEVICE
+{
+    const char          *name;        /**< Device name, e.g. "vda" */
+    unsigned long long   capacity;    /**< Size in sectors */
+    unsigned int         flags;       /**< BLK_DEV_* */
+    int                (*submit)(BLK_REQUEST * req);  /**< Queue a request */
+    void               (*kick)(void);                 /**< Start queued requests */
+    unsigned int       (*poll)(void);                 /**< Reap completions */
+    struct _BLK_DEVICE  *next;        /**< Registry link */
+} BLK_DEVICE;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name blk_register
+ *
+ * @brief Adds a device to the block device registry
+ */
+void blk_register(BLK_DEVICE * dev);
+
+/**
+ * @name blk_find
+ *
+ * @brief Looks up a registered device by name
+ *
+ * @return The device, or NULL
+ */
+BLK_DEVICE * blk_find(const char * name);
+
+/**
+ * @name blk_submit_wait
+ *
+ * @brief Submits a batch of requests with one kick and waits until all are done
+ *
+ * @par On a BLK_DEV_IRQ device a thread sleeps until the last completion;
+ * otherwise, or with interrupts disabled, it polls the device. The
+ * requests' done callbacks are replaced.
+ *
+ * @param dev  The device
+ * @param reqs The requests
+ * @param nr   Number of requests
+ * @return     BLK_OK, or the first error
+ */
+int blk_submit_wait(BLK_DEVICE * dev, BLK_REQUEST * reqs, unsigned int nr);
+
+/**
+ * @name blk_read
+ *
+ * @brief Reads len bytes (a multiple of BLK_SECTOR_SIZE) and waits for them
+ *
+ * @return BLK_OK or an error
+ */
+int blk_read(BLK_DEVICE * dev, unsigned long long sector, void * buf, unsigned int len);
+
+#endif /* INCLUDE_BLK_H */
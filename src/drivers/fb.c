@@ -8,6 +8,7 @@
 #include "io.h"
 #include "os_common.h"
 #include "fb.h"
+#include "fbcon.h"
 
 /******************************************* Defines */
 
@@ -17,6 +18,49 @@
 unsigned int current_row = 5;
 unsigned int current_col = 0;
 
+/**
+ * @name fb_cols / fb_rows
+ *
+ * @brief Size of the active console, text mode or graphics, in characters
+ */
+static unsigned int fb_cols(void)
+{
+    return fbcon_active() ? fbcon_cols() : FB_WIDTH;
+}
+
+static unsigned int fb_rows(void)
+{
+    return fbcon_active() ? fbcon_rows() : FB_HEIGHT;
+}
+
+/**
+ * @name fb_put
+ *
+ * @brief Writes a character at a row and column of the active console
+ *
+ * @note The graphics console only draws into its shadow buffer, the caller
+ * flushes once it is done.
+ */
+static void fb_put(unsigned int row, unsigned int col, char c, unsigned char fg,
+                   unsigned char bg)
+{
+    volatile char *fb = (char *) FB_ADDR;
+    unsigned int i;
+
+    if (fbcon_active())
+    {
+        fbcon_putc(row, col, c, fg, bg);
+        return;
+    }
+
+    i = PACK_FRAMEBUF_LOCATION(row, col);
+    if (i < FB_SIZE)
+    {
+        fb[i] = c;
+        fb[i + 1] = PACK_FG_BG(fg, bg);
+    }
+}
+
 /**
  * @name fb_write_cell:
  *
@@ -30,9 +74,6 @@ unsigned int current_col = 0;
  */
 void fb_write_cell(unsigned int i, char c, unsigned char fg, unsigned char bg)
 {
-    /* Framebuffer address */
-    volatile char *fb = (char *) FB_ADDR;
-
     /* Ensure i is within bounds */
     if (i >= FB_SIZE)
     {
@@ -41,8 +82,8 @@ void fb_write_cell(unsigned int i, char c, unsigned char fg, unsigned char bg)
     }
 
     /* Each cell is 2 bytes: character + attributes */
-    fb[i] = c;
-    fb[i + 1] = PACK_FG_BG(fg, bg);
+    fb_put((i / 2U) / FB_WIDTH, (i / 2U) % FB_WIDTH, c, fg, bg);
+    fbcon_flush();
 }
 
 /**
@@ -61,6 +102,12 @@ void fb_write_cell(unsigned int i, char c, unsigned char fg, unsigned char bg)
  */
 void fb_move_cursor(unsigned short pos)
 {
+    /* The graphics console has no hardware cursor */
+    if (fbcon_active())
+    {
+        return;
+    }
+
     outb(FB_COMMAND_PORT, FB_HIGH_BYTE_COMMAND);
     outb(FB_DATA_PORT,    ((pos >> 8) & 0x00FF));
     outb(FB_COMMAND_PORT, FB_LOW_BYTE_COMMAND);
@@ -77,6 +124,12 @@ void scroll_screen(void)
     unsigned int i;
     volatile char *fb = (char *) FB_ADDR;
 
+    if (fbcon_active())
+    {
+        fbcon_scroll(FB_BLACK);
+        return;
+    }
+
     /* copy lines from 1 - FB_HEIGHT to 0 - (FB_HEIGHT - 1) */
     for (i = 0; i < ((FB_HEIGHT - 1) * FB_WIDTH * 2); i++)
     {
@@ -93,6 +146,12 @@ void clear_line(unsigned int row)
 {
     unsigned int i;
 
+    if (fbcon_active())
+    {
+        fbcon_clear_row(row, FB_BLACK);
+        return;
+    }
+
     /* Fill given line with ' ' */
     for (i = 0; i < (FB_WIDTH); i++)
     {
@@ -102,11 +161,28 @@ void clear_line(unsigned int row)
 
 void fb_write(char * buf, unsigned int len, unsigned char fg, unsigned char bg)
 {
+    unsigned int cols = fb_cols();
+    unsigned int rows = fb_rows();
     unsigned int i;
 
     for (i = 0; i < len; i++)
     {
-        if ((buf[i] == '\n') || (buf[i] == '\r') || (buf[i] == '\0'))
+        if (buf[i] == '\b')
+        {
+            /* Step back and blank the previous cell */
+            if (current_col > 0)
+            {
+                current_col--;
+            }
+            else if (current_row > 0)
+            {
+                current_row--;
+                current_col = cols - 1;
+            }
+            fb_put(current_row, current_col, ' ', fg, bg);
+            fb_move_cursor(PACK_CURSOR_LOCATION(current_row, current_col));
+        }
+        else if ((buf[i] == '\n') || (buf[i] == '\r') || (buf[i] == '\0'))
         {
             /* Check if next character has '\r' or '\n' */
             if((buf[i] == '\r') && (i + 1 < len) && (buf[i + 1] == '\n'))
@@ -123,7 +199,7 @@ void fb_write(char * buf, unsigned int len, unsigned char fg, unsigned char bg)
         else
         {
             /* Write character */
-            fb_write_cell(PACK_FRAMEBUF_LOCATION(current_row, current_col), buf[i], fg, bg);
+            fb_put(current_row, current_col, buf[i], fg, bg);
             /* Move cursor */
             fb_move_cursor(PACK_CURSOR_LOCATION(current_row, current_col));
 
@@ -131,21 +207,24 @@ void fb_write(char * buf, unsigned int len, unsigned char fg, unsigned char bg)
             current_col++;
 
             /* If we reach end of the column move to next row */
-            if (current_col >= FB_WIDTH) {
+            if (current_col >= cols) {
                 current_col = 0;
                 current_row++;
             }
         }
 
         /* Check if we are in last row */
-        if (current_row >= FB_HEIGHT)
+        if (current_row >= rows)
         {
             /* Move current row to previous row */
-            current_row = FB_HEIGHT - 1;
+            current_row = rows - 1;
             /* Move rows one step above */
             scroll_screen();
             /* Clear the last line */
-            clear_line(FB_HEIGHT-1);
+            clear_line(rows - 1);
         }
     }
-}
\ No newline at end of file
+
+    /* One copy to the graphics framebuffer for the whole buffer */
+    fbcon_flush();
+}
@@ -0,0 +1,489 @@
+/**
+ * @file fbcon.c
+ *
+ * @brief Implementation of the linear framebuffer graphics console
+ *
+ * @par The kernel does not save SSE registers on interrupts, so every
+ * function that touches them runs with interrupts disabled. That also keeps
+ * a kprintf() from an exception handler from clobbering a blit in progress.
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "kstring.h"
+#include "pmm.h"
+#include "paging.h"
+#include "font8x8.h"
+#include "fbcon.h"
+
+/******************************************* Defines */
+#define CR0_MP                  0x00000002U  /**< Monitor coprocessor */
+#define CR0_EM                  0x00000004U  /**< x87 emulation, must be off for SSE */
+#define CR4_OSFXSR              0x00000200U  /**< OS supports fxsave, enables SSE */
+#define CR4_OSXMMEXCPT          0x00000400U  /**< OS handles SIMD exceptions */
+
+/** Number of VGA text colours */
+#define FBCON_NR_COLORS         16U
+
+/** Each font row covers this many pixel lines */
+#define FBCON_FONT_SCALE        (FBCON_CELL_HEIGHT / FONT8X8_HEIGHT)
+
+/** 32 bit pixels per 16 byte SSE register */
+#define FBCON_PIXELS_PER_VEC    4U
+
+/** Drawn for characters missing from the font */
+#define FBCON_UNKNOWN_CHAR      '?'
+
+/******************************************* Macros */
+
+/******************************************* Typedefs/structures */
+/** Four pixels, may alias the unsigned int buffers they are loaded from */
+typedef int FBCON_V4SI __attribute__((vector_size(16), may_alias));
+typedef long long FBCON_V2DI __attribute__((vector_size(16), may_alias));
+/** Same, for stores to possibly unaligned framebuffer lines */
+typedef int FBCON_V4SI_U __attribute__((vector_size(16), may_alias, aligned(4)));
+
+/**
+ * @struct FBCON
+ * @brief Console state
+ */
+typedef struct _FBCON
+{
+    int            active;            /**< Graphics console in use */
+    int            streaming;         /**< Framebuffer lines are 16 byte aligned */
+    unsigned char *lfb;               /**< Mapped framebuffer */
+    unsigned int   lfb_pitch;         /**< Framebuffer bytes per line */
+    unsigned int  *shadow;            /**< Shadow buffer, cols * 8 pixels wide */
+    unsigned int   stride;            /**< Shadow pixels per line */
+    unsigned int   cols;              /**< Cell columns */
+    unsigned int   rows;              /**< Cell rows */
+    unsigned int   dirty_first;       /**< First cell row to flush */
+    unsigned int   dirty_last;        /**< One past the last cell row to flush */
+    unsigned int   palette[FBCON_NR_COLORS]; /**< FB_* colours as pixels */
+} FBCON;
+
+/******************************************* Static global defines */
+static FBCON fbcon;
+
+static FBCON_STATS fbcon_stats;
+
+/**
+ * For every font row byte, its 8 pixels as all-ones or all-zero masks.
+ * Two SSE registers per byte, 8 KiB in total.
+ */
+static unsigned int fbcon_masks[256][FONT8X8_WIDTH] __attribute__((aligned(16)));
+
+/** The 16 VGA text colours as 8 bit RGB */
+static const unsigned int fbcon_vga_rgb[FBCON_NR_COLORS] =
+{
+    0x000000, 0x0000AA, 0x00AA00, 0x00AAAA, 0xAA0000, 0xAA00AA, 0xAA5500, 0xAAAAAA,
+    0x555555, 0x5555FF, 0x55FF55, 0x55FFFF, 0xFF5555, 0xFF55FF, 0xFFFF55, 0xFFFFFF,
+};
+
+/******************************************* Functions */
+
+/**
+ * @name fbcon_enable_sse
+ *
+ * @brief Turns on SSE if the CPU has SSE2
+ */
+static int fbcon_enable_sse(void)
+{
+    unsigned int cr0;
+    unsigned int cr4;
+
+    if ((cpuid_edx() & (CPUID_EDX_SSE2 | CPUID_EDX_FXSR)) !=
+        (CPUID_EDX_SSE2 | CPUID_EDX_FXSR))
+    {
+        return FBCON_ERR_NOSSE;
+    }
+
+    asm volatile ("mov %%cr0, %0" : "=r" (cr0));
+    asm volatile ("mov %0, %%cr0" :: "r" ((cr0 & ~CR0_EM) | CR0_MP));
+    asm volatile ("mov %%cr4, %0" : "=r" (cr4));
+    asm volatile ("mov %0, %%cr4" :: "r" (cr4 | CR4_OSFXSR | CR4_OSXMMEXCPT));
+    return FBCON_OK;
+}
+
+/**
+ * @name fbcon_color
+ *
+ * @brief Packs an 8 bit per channel colour into the framebuffer's format
+ */
+static unsigned int fbcon_color(unsigned int rgb, const unsigned char * pos,
+                                const unsigned char * size)
+{
+    unsigned int pixel = 0;
+    unsigned int i;
+
+    for (i = 0; i < 3U; i++)
+    {
+        unsigned int channel = (rgb >> (16U - (8U * i))) & 0xFFU;
+
+        if (size[i] < 8U)
+        {
+            channel >>= 8U - size[i];
+        }
+        pixel |= channel << pos[i];
+    }
+    return pixel;
+}
+
+/**
+ * @name fbcon_draw_glyph
+ *
+ * @brief Expands one glyph into a cell of the shadow buffer
+ *
+ * @par Each pixel row is bg ^ ((fg ^ bg) & mask), two registers wide.
+ */
+__attribute__((target("sse2")))
+static void fbcon_draw_glyph(unsigned int * dst, const unsigned char * glyph,
+                             unsigned int fg, unsigned int bg)
+{
+    FBCON_V4SI bgv = { (int) bg, (int) bg, (int) bg, (int) bg };
+    FBCON_V4SI fgv = { (int) fg, (int) fg, (int) fg, (int) fg };
+    FBCON_V4SI diff = fgv ^ bgv;
+    const FBCON_V4SI *mask;
+    FBCON_V4SI *line;
+    unsigned int y;
+
+    for (y = 0; y < FBCON_CELL_HEIGHT; y++)
+    {
+        mask = (const FBCON_V4SI *) fbcon_masks[glyph[y / FBCON_FONT_SCALE]];
+        line = (FBCON_V4SI *) (dst + (y * fbcon.stride));
+        line[0] = bgv ^ (diff & mask[0]);
+        line[1] = bgv ^ (diff & mask[1]);
+    }
+}
+
+/**
+ * @name fbcon_fill
+ *
+ * @brief Fills whole shadow lines with one colour
+ */
+__attribute__((target("sse2")))
+static void fbcon_fill(unsigned int * dst, unsigned int lines, unsigned int pixel)
+{
+    FBCON_V4SI v = { (int) pixel, (int) pixel, (int) pixel, (int) pixel };
+    FBCON_V4SI *p = (FBCON_V4SI *) dst;
+    unsigned int n = (lines * fbcon.stride) / FBCON_PIXELS_PER_VEC;
+    unsigned int i;
+
+    for (i = 0; i < n; i++)
+    {
+        p[i] = v;
+    }
+}
+
+/**
+ * @name fbcon_blit
+ *
+ * @brief Copies shadow lines to the framebuffer
+ *
+ * @par Non-temporal stores skip the cache and fill whole write-combining
+ * buffers, so the copy leaves as full bursts and the cache keeps the
+ * shadow buffer.
+ */
+__attribute__((target("sse2")))
+static void fbcon_blit(unsigned int first, unsigned int lines)
+{
+    const FBCON_V4SI *src;
+    unsigned int vecs = fbcon.stride / FBCON_PIXELS_PER_VEC;
+    unsigned int y;
+    unsigned int i;
+
+    for (y = first; y < first + lines; y++)
+    {
+        src = (const FBCON_V4SI *) (fbcon.shadow + (y * fbcon.stride));
+
+        if (fbcon.streaming)
+        {
+            FBCON_V2DI *dst = (FBCON_V2DI *) (fbcon.lfb + (y * fbcon.lfb_pitch));
+
+            for (i = 0; i < vecs; i++)
+            {
+                __builtin_ia32_movntdq(&dst[i], (FBCON_V2DI) src[i]);
+            }
+        }
+        else
+        {
+            FBCON_V4SI_U *dst = (FBCON_V4SI_U *) (fbcon.lfb + (y * fbcon.lfb_pitch));
+
+            for (i = 0; i < vecs; i++)
+            {
+                dst[i] = src[i];
+            }
+        }
+    }
+
+    /* Drain the write-combining buffers */
+    __builtin_ia32_sfence();
+}
+
+/**
+ * @name fbcon_mark_dirty
+ *
+ * @brief Adds cell rows [first, last) to the region to flush
+ */
+static void fbcon_mark_dirty(unsigned int first, unsigned int last)
+{
+    if (fbcon.dirty_first >= fbcon.dirty_last)
+    {
+        fbcon.dirty_first = first;
+        fbcon.dirty_last = last;
+        return;
+    }
+    if (first < fbcon.dirty_first)
+    {
+        fbcon.dirty_first = first;
+    }
+    if (last > fbcon.dirty_last)
+    {
+        fbcon.dirty_last = last;
+    }
+}
+
+/**
+ * @name fbcon_find_mode
+ *
+ * @brief Reads the framebuffer description left by the boot loader
+ */
+static int fbcon_find_mode(const MULTIBOOT_INFO * mb_info, unsigned int * addr,
+                           unsigned int * pitch, unsigned int * width,
+                           unsigned int * height, unsigned char * pos,
+                           unsigned char * size)
+{
+    const VBE_MODE_INFO *vbe;
+
+    if (mb_info == NULL)
+    {
+        return FBCON_ERR_NOFB;
+    }
+
+    if (mb_info->flags & MULTIBOOT_INFO_FRAMEBUFFER_INFO)
+    {
+        if ((mb_info->framebuffer_type != MULTIBOOT_FRAMEBUFFER_TYPE_RGB) ||
+            (mb_info->framebuffer_bpp != FBCON_BPP) ||
+            (mb_info->framebuffer_addr >> 32))
+        {
+            return FBCON_ERR_FORMAT;
+        }
+        *addr = (unsigned int) mb_info->framebuffer_addr;
+        *pitch = mb_info->framebuffer_pitch;
+        *width = mb_info->framebuffer_width;
+        *height = mb_info->framebuffer_height;
+        pos[0] = mb_info->red_field_position;
+        pos[1] = mb_info->green_field_position;
+        pos[2] = mb_info->blue_field_position;
+        size[0] = mb_info->red_mask_size;
+        size[1] = mb_info->green_mask_size;
+        size[2] = mb_info->blue_mask_size;
+        return FBCON_OK;
+    }
+
+    /* Older loaders only pass the VBE mode information block */
+    if ((mb_info->flags & MULTIBOOT_INFO_VBE_INFO) && (mb_info->vbe_mode_info != 0))
+    {
+        vbe = (const VBE_MODE_INFO *) mb_info->vbe_mode_info;
+        if (!(vbe->attributes & VBE_MODE_ATTR_LINEAR) || (vbe->bpp != FBCON_BPP))
+        {
+            return FBCON_ERR_FORMAT;
+        }
+        *addr = vbe->framebuffer;
+        *pitch = vbe->pitch;
+        *width = vbe->width;
+        *height = vbe->height;
+        pos[0] = vbe->red_position;
+        pos[1] = vbe->green_position;
+        pos[2] = vbe->blue_position;
+        size[0] = vbe->red_mask;
+        size[1] = vbe->green_mask;
+        size[2] = vbe->blue_mask;
+        return FBCON_OK;
+    }
+
+    return FBCON_ERR_NOFB;
+}
+
+int fbcon_init(const MULTIBOOT_INFO * mb_info)
+{
+    unsigned char pos[3];
+    unsigned char size[3];
+    unsigned int addr;
+    unsigned int pitch;
+    unsigned int width;
+    unsigned int height;
+    unsigned int pages;
+    unsigned int flags;
+    unsigned int b;
+    unsigned int i;
+    int ret;
+
+    ret = fbcon_find_mode(mb_info, &addr, &pitch, &width, &height, pos, size);
+    if (ret != FBCON_OK)
+    {
+        return ret;
+    }
+    if ((width < FBCON_CELL_WIDTH) || (height < FBCON_CELL_HEIGHT) ||
+        (pitch < width * (FBCON_BPP / 8U)))
+    {
+        return FBCON_ERR_FORMAT;
+    }
+
+    ret = fbcon_enable_sse();
+    if (ret != FBCON_OK)
+    {
+        return ret;
+    }
+
+    fbcon.cols = width / FBCON_CELL_WIDTH;
+    fbcon.rows = height / FBCON_CELL_HEIGHT;
+    fbcon.stride = fbcon.cols * FBCON_CELL_WIDTH;
+    fbcon.lfb_pitch = pitch;
+
+    /* Page aligned, so every cell is 32 byte aligned */
+    pages = ALIGN_UP(fbcon.stride * height * sizeof(unsigned int), PAGE_SIZE) >> PAGE_SHIFT;
+    fbcon.shadow = pmm_alloc_pages(pages);
+    if (fbcon.shadow == NULL)
+    {
+        return FBCON_ERR_NOMEM;
+    }
+
+    fbcon.lfb = paging_map_phys(addr, pitch * height, PAGE_RW | PAGE_WC);
+    if (fbcon.lfb == NULL)
+    {
+        pmm_free_pages(fbcon.shadow, pages);
+        return FBCON_ERR_NOMEM;
+    }
+    fbcon.streaming = !(((unsigned int) fbcon.lfb | pitch) & 15U);
+
+    for (i = 0; i < FBCON_NR_COLORS; i++)
+    {
+        fbcon.palette[i] = fbcon_color(fbcon_vga_rgb[i], pos, size);
+    }
+    for (b = 0; b < 256U; b++)
+    {
+        for (i = 0; i < FONT8X8_WIDTH; i++)
+        {
+            fbcon_masks[b][i] = ((b >> i) & 1U) ? 0xFFFFFFFFU : 0;
+        }
+    }
+
+    fbcon_stats.width = width;
+    fbcon_stats.height = height;
+    fbcon_stats.write_combining = paging_has_wc();
+
+    flags = local_irq_save();
+    fbcon_fill(fbcon.shadow, fbcon.rows * FBCON_CELL_HEIGHT, fbcon.palette[0]);
+    local_irq_restore(flags);
+    fbcon.active = 1;
+    fbcon_mark_dirty(0, fbcon.rows);
+    fbcon_flush();
+    return FBCON_OK;
+}
+
+int fbcon_active(void)
+{
+    return fbcon.active;
+}
+
+unsigned int fbcon_cols(void)
+{
+    return fbcon.cols;
+}
+
+unsigned int fbcon_rows(void)
+{
+    return fbcon.rows;
+}
+
+void fbcon_putc(unsigned int row, unsigned int col, char c, unsigned char fg,
+                unsigned char bg)
+{
+    unsigned char ch = (unsigned char) c;
+    unsigned int flags;
+
+    if (!fbcon.active || (row >= fbcon.rows) || (col >= fbcon.cols))
+    {
+        return;
+    }
+    if ((ch < FONT8X8_FIRST) || (ch > FONT8X8_LAST))
+    {
+        ch = FBCON_UNKNOWN_CHAR;
+    }
+
+    flags = local_irq_save();
+    fbcon_draw_glyph(fbcon.shadow + (row * FBCON_CELL_HEIGHT * fbcon.stride) +
+                     (col * FBCON_CELL_WIDTH),
+                     font8x8[ch - FONT8X8_FIRST],
+                     fbcon.palette[fg & 0x0FU], fbcon.palette[bg & 0x0FU]);
+    local_irq_restore(flags);
+
+    fbcon_stats.glyphs++;
+    fbcon_mark_dirty(row, row + 1U);
+}
+
+void fbcon_clear_row(unsigned int row, unsigned char bg)
+{
+    unsigned int flags;
+
+    if (!fbcon.active || (row >= fbcon.rows))
+    {
+        return;
+    }
+
+    flags = local_irq_save();
+    fbcon_fill(fbcon.shadow + (row * FBCON_CELL_HEIGHT * fbcon.stride),
+               FBCON_CELL_HEIGHT, fbcon.palette[bg & 0x0FU]);
+    local_irq_restore(flags);
+    fbcon_mark_dirty(row, row + 1U);
+}
+
+void fbcon_scroll(unsigned char bg)
+{
+    unsigned int row_pixels = FBCON_CELL_HEIGHT * fbcon.stride;
+
+    if (!fbcon.active)
+    {
+        return;
+    }
+
+    /* Cached RAM to cached RAM, video memory is only ever written */
+    memmove(fbcon.shadow, fbcon.shadow + row_pixels,
+            (fbcon.rows - 1U) * row_pixels * sizeof(unsigned int));
+    fbcon_clear_row(fbcon.rows - 1U, bg);
+
+    fbcon_stats.scrolls++;
+    fbcon_mark_dirty(0, fbcon.rows);
+}
+
+void fbcon_flush(void)
+{
+    unsigned long long start;
+    unsigned int lines;
+    unsigned int flags;
+
+    if (!fbcon.active || (fbcon.dirty_first >= fbcon.dirty_last))
+    {
+        return;
+    }
+
+    lines = (fbcon.dirty_last - fbcon.dirty_first) * FBCON_CELL_HEIGHT;
+    start = rdtsc();
+    flags = local_irq_save();
+    fbcon_blit(fbcon.dirty_first * FBCON_CELL_HEIGHT, lines);
+    local_irq_restore(flags);
+
+    fbcon_stats.flush_cycles += rdtsc() - start;
+    fbcon_stats.flushes++;
+    fbcon_stats.flushed_bytes += (unsigned long long) lines * fbcon.stride *
+                                 sizeof(unsigned int);
+    fbcon.dirty_first = 0;
+    fbcon.dirty_last = 0;
+}
+
+const FBCON_STATS * fbcon_get_stats(void)
+{
+    return &fbcon_stats;
+}
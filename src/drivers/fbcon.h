@@ -0,0 +1,125 @@
+/**
+ * @file fbcon.h
+ *
+ * @brief Header file for the linear framebuffer graphics console
+ *
+ * @par When the boot loader leaves the machine in a 32 bpp VBE mode the
+ * console is drawn in graphics instead of VGA text mode:
+ * - text is rendered into a shadow buffer in normal cached RAM; each glyph
+ *   row is one byte of the built-in font, expanded with SSE2 through a table
+ *   of pre-rendered 8 pixel masks,
+ * - rows that changed are streamed to the framebuffer with non-temporal
+ *   stores through a write-combining mapping, so video memory is never read,
+ * - scrolling moves the shadow buffer and rewrites the screen from it.
+ *
+ * fb.c calls these functions, so fb_write() and friends work in both modes.
+ */
+#ifndef INCLUDE_FBCON_H
+#define INCLUDE_FBCON_H
+/******************************************* Includes */
+#include "multiboot.h"
+
+/******************************************* Defines */
+/** Character cell size in pixels, font rows are drawn twice */
+#define FBCON_CELL_WIDTH        8U
+#define FBCON_CELL_HEIGHT       16U
+
+/** Only 32 bits per pixel modes are supported */
+#define FBCON_BPP               32U
+
+/* Return codes */
+#define FBCON_OK                0
+#define FBCON_ERR_NOFB          (-1)    /**< No linear framebuffer from the boot loader */
+#define FBCON_ERR_FORMAT        (-2)    /**< Unsupported pixel format */
+#define FBCON_ERR_NOSSE         (-3)    /**< CPU without SSE2 */
+#define FBCON_ERR_NOMEM         (-4)    /**< No memory for the shadow buffer or mapping */
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct FBCON_STATS
+ * @brief Graphics console counters
+ */
+typedef struct _FBCON_STATS
+{
+    unsigned int       width;         /**< Pixels per line */
+    unsigned int       height;        /**< Lines */
+    unsigned int       write_combining; /**< 1 if mapped WC through the PAT */
+    unsigned int       glyphs;        /**< Glyphs rendered */
+    unsigned int       scrolls;       /**< Lines scrolled */
+    unsigned int       flushes;       /**< Shadow to framebuffer copies */
+    unsigned long long flushed_bytes; /**< Bytes written to the framebuffer */
+    unsigned long long flush_cycles;  /**< TSC cycles spent in those copies */
+} FBCON_STATS;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name fbcon_init
+ *
+ * @brief Switches the console to the framebuffer described by the boot loader
+ *
+ * @note Needs pmm and paging to be up.
+ *
+ * @return FBCON_OK, or an error and the console stays in text mode
+ */
+int fbcon_init(const MULTIBOOT_INFO * mb_info);
+
+/**
+ * @name fbcon_active
+ *
+ * @brief Returns 1 if the graphics console is in use
+ */
+int fbcon_active(void);
+
+/**
+ * @name fbcon_cols / fbcon_rows
+ *
+ * @brief Size of the console in character cells
+ */
+unsigned int fbcon_cols(void);
+unsigned int fbcon_rows(void);
+
+/**
+ * @name fbcon_putc
+ *
+ * @brief Draws a character into the shadow buffer
+ *
+ * @param row Cell row
+ * @param col Cell column
+ * @param c   Character, unprintable ones are drawn as '?'
+ * @param fg  Foreground, one of the FB_* colours
+ * @param bg  Background, one of the FB_* colours
+ */
+void fbcon_putc(unsigned int row, unsigned int col, char c, unsigned char fg,
+                unsigned char bg);
+
+/**
+ * @name fbcon_clear_row
+ *
+ * @brief Fills a cell row of the shadow buffer with a colour
+ */
+void fbcon_clear_row(unsigned int row, unsigned char bg);
+
+/**
+ * @name fbcon_scroll
+ *
+ * @brief Moves the shadow buffer up by one cell row, the last row is cleared
+ */
+void fbcon_scroll(unsigned char bg);
+
+/**
+ * @name fbcon_flush
+ *
+ * @brief Copies the rows changed since the last flush to the framebuffer
+ */
+void fbcon_flush(void);
+
+/**
+ * @name fbcon_get_stats
+ *
+ * @brief Returns the counters
+ */
+const FBCON_STATS * fbcon_get_stats(void);
+
+#endif /* INCLUDE_FBCON_H */
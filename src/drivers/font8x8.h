@@ -0,0 +1,27 @@
+/**
+ * @file font8x8.h
+ *
+ * @brief Header file for the built-in 8x8 bitmap font
+ *
+ * @par One byte per glyph row, bit 0 is the leftmost pixel. Only printable
+ * ASCII is included.
+ */
+#ifndef INCLUDE_FONT8X8_H
+#define INCLUDE_FONT8X8_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+#define FONT8X8_WIDTH           8U
+#define FONT8X8_HEIGHT          8U
+/** First and last character in the table */
+#define FONT8X8_FIRST           0x20U
+#define FONT8X8_LAST            0x7EU
+#define FONT8X8_COUNT           (FONT8X8_LAST - FONT8X8_FIRST + 1U)
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/** Glyph rows, indexed by character - FONT8X8_FIRST */
+extern const unsigned char font8x8[FONT8X8_COUNT][FONT8X8_HEIGHT];
+
+#endif /* INCLUDE_FONT8X8_H */
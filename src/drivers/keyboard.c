@@ -0,0 +1,182 @@
+/**
+ * @file keyboard.c
+ *
+ * @brief Implementation of the PS/2 keyboard driver
+ */
+
+/******************************************* Includes */
+#include "io.h"
+#include "os_common.h"
+#include "irq.h"
+#include "input.h"
+#include "keyboard.h"
+#include "initcall.h"
+
+/******************************************* Defines */
+/** Entries in the translation tables */
+#define KEYBOARD_MAP_SIZE           0x3AU
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+/** Scancode set 1 to ASCII, US layout, 0 for keys without a character */
+static const char keyboard_map[KEYBOARD_MAP_SIZE] =
+{
+    0,    27,   '1',  '2',  '3',  '4',  '5',  '6',      /* 0x00 */
+    '7',  '8',  '9',  '0',  '-',  '=',  '\b', '\t',     /* 0x08 */
+    'q',  'w',  'e',  'r',  't',  'y',  'u',  'i',      /* 0x10 */
+    'o',  'p',  '[',  ']',  '\n', 0,    'a',  's',      /* 0x18 */
+    'd',  'f',  'g',  'h',  'j',  'k',  'l',  ';',      /* 0x20 */
+    '\'', '`',  0,    '\\', 'z',  'x',  'c',  'v',      /* 0x28 */
+    'b',  'n',  'm',  ',',  '.',  '/',  0,    '*',      /* 0x30 */
+    0,    ' ',                                          /* 0x38 */
+};
+
+/** Same with shift held */
+static const char keyboard_map_shift[KEYBOARD_MAP_SIZE] =
+{
+    0,    27,   '!',  '@',  '#',  '$',  '%',  '^',      /* 0x00 */
+    '&',  '*',  '(',  ')',  '_',  '+',  '\b', '\t',     /* 0x08 */
+    'Q',  'W',  'E',  'R',  'T',  'Y',  'U',  'I',      /* 0x10 */
+    'O',  'P',  '{',  '}',  '\n', 0,    'A',  'S',      /* 0x18 */
+    'D',  'F',  'G',  'H',  'J',  'K',  'L',  ':',      /* 0x20 */
+    '"',  '~',  0,    '|',  'Z',  'X',  'C',  'V',      /* 0x28 */
+    'B',  'N',  'M',  '<',  '>',  '?',  0,    '*',      /* 0x30 */
+    0,    ' ',                                          /* 0x38 */
+};
+
+/**
+ * @struct KEYBOARD_STATE
+ * @brief Modifier state, only touched by the consumer
+ */
+typedef struct _KEYBOARD_STATE
+{
+    unsigned char shift;              /**< Shift keys held (bit per side) */
+    unsigned char ctrl;               /**< Control held */
+    unsigned char caps;               /**< Caps lock on */
+    unsigned char extended;           /**< Previous byte was the 0xE0 prefix */
+} KEYBOARD_STATE;
+
+static KEYBOARD_STATE keyboard_state;
+
+/******************************************* Functions */
+
+/**
+ * @name keyboard_irq
+ *
+ * @brief IRQ1 handler, queues the raw scancode
+ */
+static void keyboard_irq(unsigned int irq, void * ctx)
+{
+    (void) irq;
+    (void) ctx;
+
+    input_push(INPUT_SRC_KEYBOARD, inb(KEYBOARD_DATA_PORT));
+}
+
+int keyboard_init(void)
+{
+    int ret;
+
+    /* Throw away whatever was typed before we were listening */
+    while (inb(KEYBOARD_STATUS_PORT) & KEYBOARD_STATUS_OUTPUT_FULL)
+    {
+        inb(KEYBOARD_DATA_PORT);
+    }
+
+    ret = irq_register(IRQ_KEYBOARD, keyboard_irq, NULL);
+    if (ret != IRQ_OK)
+    {
+        return ret;
+    }
+    irq_unmask(IRQ_KEYBOARD);
+    return IRQ_OK;
+}
+
+/**
+ * @name keyboard_initcall
+ *
+ * @brief Starts keyboard interrupts, they are delivered once kmain() enables
+ * interrupts
+ *
+ * @return 0, or the irq_register() error
+ */
+static int keyboard_initcall(void)
+{
+    return keyboard_init();
+}
+INITCALL_DEVICE(keyboard_initcall);
+
+int keyboard_decode(unsigned char scancode)
+{
+    KEYBOARD_STATE *st = &keyboard_state;
+    unsigned char release = scancode & KEYBOARD_SC_RELEASE;
+    unsigned char key = scancode & ~KEYBOARD_SC_RELEASE;
+    char c;
+
+    if (scancode == KEYBOARD_SC_EXTENDED)
+    {
+        st->extended = 1;
+        return -1;
+    }
+    if (st->extended)
+    {
+        /* Right control shares the left's code; arrows etc. are ignored */
+        st->extended = 0;
+        if (key == KEYBOARD_SC_LCTRL)
+        {
+            st->ctrl = !release;
+        }
+        return -1;
+    }
+
+    switch (key)
+    {
+    case KEYBOARD_SC_LSHIFT:
+    case KEYBOARD_SC_RSHIFT:
+        if (release)
+        {
+            st->shift &= ~((key == KEYBOARD_SC_LSHIFT) ? 1U : 2U);
+        }
+        else
+        {
+            st->shift |= (key == KEYBOARD_SC_LSHIFT) ? 1U : 2U;
+        }
+        return -1;
+    case KEYBOARD_SC_LCTRL:
+        st->ctrl = !release;
+        return -1;
+    case KEYBOARD_SC_CAPSLOCK:
+        if (!release)
+        {
+            st->caps = !st->caps;
+        }
+        return -1;
+    default:
+        break;
+    }
+
+    if (release || (key >= KEYBOARD_MAP_SIZE))
+    {
+        return -1;
+    }
+
+    c = st->shift ? keyboard_map_shift[key] : keyboard_map[key];
+    if (c == 0)
+    {
+        return -1;
+    }
+    if (st->caps && (c >= 'a') && (c <= 'z'))
+    {
+        c -= 'a' - 'A';
+    }
+    else if (st->caps && (c >= 'A') && (c <= 'Z'))
+    {
+        c += 'a' - 'A';
+    }
+    if (st->ctrl)
+    {
+        return INPUT_CHAR_CTRL(c);
+    }
+    return c;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file keyboard.h
+ *
+ * @brief Header file for the PS/2 keyboard driver
+ *
+ * @par The IRQ1 handler only reads the scancode and queues it on the
+ * keyboard input ring. Translation to characters happens in the consumer
+ * through @ref keyboard_decode, which keeps the modifier state.
+ */
+#ifndef INCLUDE_KEYBOARD_H
+#define INCLUDE_KEYBOARD_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/* PS/2 controller ports */
+#define KEYBOARD_DATA_PORT          0x60
+#define KEYBOARD_STATUS_PORT        0x64
+
+/** Status register: output buffer full */
+#define KEYBOARD_STATUS_OUTPUT_FULL 0x01
+
+/* Scancode set 1 */
+#define KEYBOARD_SC_RELEASE         0x80    /**< Set on key release */
+#define KEYBOARD_SC_EXTENDED        0xE0    /**< Prefix of extended keys */
+#define KEYBOARD_SC_LCTRL           0x1D
+#define KEYBOARD_SC_LSHIFT          0x2A
+#define KEYBOARD_SC_RSHIFT          0x36
+#define KEYBOARD_SC_CAPSLOCK        0x3A
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name keyboard_init
+ *
+ * @brief Drains the controller and enables IRQ1
+ *
+ * @return IRQ_OK, or the error of irq_register()
+ */
+int keyboard_init(void);
+
+/**
+ * @name keyboard_decode
+ *
+ * @brief Translates one scancode (US layout) and updates the modifier state
+ *
+ * @param scancode Scancode set 1 byte
+ * @return         The character, or -1 for releases, modifiers and keys
+ *                 without a character
+ */
+int keyboard_decode(unsigned char scancode);
+
+#endif /* INCLUDE_KEYBOARD_H */
@@ -0,0 +1,93 @@
+/**
+ * @file pci.c
+ *
+ * @brief Implementation of PCI configuration space access
+ */
+
+/******************************************* Includes */
+#include "io.h"
+#include "os_common.h"
+#include "pci.h"
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+
+/******************************************* Functions */
+unsigned int pci_config_read32(const PCI_DEVICE * dev, unsigned char reg)
+{
+    outl(PCI_CONFIG_ADDRESS_PORT,
+         PACK_PCI_CONFIG_ADDRESS(dev->bus, dev->device, dev->function, reg));
+    return inl(PCI_CONFIG_DATA_PORT);
+}
+
+unsigned short pci_config_read16(const PCI_DEVICE * dev, unsigned char reg)
+{
+    unsigned int val = pci_config_read32(dev, reg);
+
+    /* Pick the upper or lower half of the dword */
+    return (unsigned short) (val >> ((reg & 2U) * 8U));
+}
+
+void pci_config_write16(const PCI_DEVICE * dev, unsigned char reg, unsigned short val)
+{
+    outl(PCI_CONFIG_ADDRESS_PORT,
+         PACK_PCI_CONFIG_ADDRESS(dev->bus, dev->device, dev->function, reg));
+    outw(PCI_CONFIG_DATA_PORT + (reg & 2U), val);
+}
+
+int pci_find_device(unsigned short vendor_id, unsigned short device_id, PCI_DEVICE * dev)
+{
+    unsigned int bus;
+    unsigned int slot;
+    unsigned int func;
+    unsigned int id;
+
+    for (bus = 0; bus < PCI_MAX_BUS; bus++)
+    {
+        for (slot = 0; slot < PCI_MAX_DEVICE; slot++)
+        {
+            for (func = 0; func < PCI_MAX_FUNCTION; func++)
+            {
+                dev->bus = bus;
+                dev->device = slot;
+                dev->function = func;
+
+                id = pci_config_read32(dev, PCI_VENDOR_ID);
+                if ((id & 0xFFFFU) == PCI_VENDOR_NONE)
+                {
+                    /* Function 0 missing means the whole slot is empty */
+                    if (func == 0)
+                    {
+                        break;
+                    }
+                    continue;
+                }
+
+                if (((id & 0xFFFFU) == vendor_id) && ((id >> 16) == device_id))
+                {
+                    dev->vendor_id = vendor_id;
+                    dev->device_id = device_id;
+                    dev->irq = pci_config_read32(dev, PCI_INTERRUPT_LINE) & 0xFFU;
+                    return 0;
+                }
+
+                /* Only multi-function devices have functions 1-7 */
+                if ((func == 0) &&
+                    !(pci_config_read32(dev, PCI_HEADER_TYPE & 0xFCU) & 0x00800000U))
+                {
+                    break;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+void pci_enable_device(const PCI_DEVICE * dev)
+{
+    unsigned short cmd = pci_config_read16(dev, PCI_COMMAND);
+
+    cmd |= PCI_COMMAND_IO | PCI_COMMAND_MEMORY | PCI_COMMAND_MASTER;
+    pci_config_write16(dev, PCI_COMMAND, cmd);
+}
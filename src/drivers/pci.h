@@ -0,0 +1,121 @@
+/**
+ * @file pci.h
+ *
+ * @brief Header file for PCI configuration space access
+ */
+#ifndef INCLUDE_PCI_H
+#define INCLUDE_PCI_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/**
+ * @name PCI configuration mechanism #1
+ * @par A dword address written to 0xCF8 selects bus/device/function/register,
+ * the selected register is then read or written through 0xCFC.
+ */
+#define PCI_CONFIG_ADDRESS_PORT     0xCF8
+#define PCI_CONFIG_DATA_PORT        0xCFC
+
+/* Configuration space register offsets */
+#define PCI_VENDOR_ID               0x00
+#define PCI_DEVICE_ID               0x02
+#define PCI_COMMAND                 0x04
+#define PCI_HEADER_TYPE             0x0E
+#define PCI_BAR0                    0x10
+#define PCI_SUBSYSTEM_ID            0x2E
+#define PCI_INTERRUPT_LINE          0x3C
+
+/* Command register bits */
+#define PCI_COMMAND_IO              0x0001
+#define PCI_COMMAND_MEMORY          0x0002
+#define PCI_COMMAND_MASTER          0x0004
+
+/* BAR bits */
+#define PCI_BAR_IO                  0x01U
+#define PCI_BAR_IO_MASK             0xFFFFFFFCU
+#define PCI_BAR_MEM_MASK            0xFFFFFFF0U
+
+/** Value read back from an empty slot */
+#define PCI_VENDOR_NONE             0xFFFF
+
+#define PCI_MAX_BUS                 256U
+#define PCI_MAX_DEVICE              32U
+#define PCI_MAX_FUNCTION            8U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct PCI_DEVICE
+ * @brief Location and identity of a PCI function
+ */
+typedef struct _PCI_DEVICE
+{
+    unsigned char  bus;          /**< Bus number */
+    unsigned char  device;       /**< Device (slot) number */
+    unsigned char  function;     /**< Function number */
+    unsigned char  irq;          /**< Legacy interrupt line */
+    unsigned short vendor_id;    /**< Vendor ID */
+    unsigned short device_id;    /**< Device ID */
+} PCI_DEVICE;
+
+/******************************************* Macros */
+
+/**
+ * @name Pack configuration address
+ *
+ * @par
+ * Bit:     | 31 | 30-24 | 23-16 | 15-11  | 10-8 | 7-0      |
+ * Content: | e  | r     | bus   | device | func | register |
+ */
+#define PACK_PCI_CONFIG_ADDRESS(bus, dev, func, reg)   \
+        ((0x80000000U)                  |              \
+         (((bus) & 0xFFU) << 16U)       |              \
+         (((dev) & 0x1FU) << 11U)       |              \
+         (((func) & 0x07U) << 8U)       |              \
+         ((reg) & 0xFCU))
+
+/******************************************* Protoytes */
+/**
+ * @name pci_config_read32
+ *
+ * @brief Reads a dword from the configuration space of a function
+ *
+ * @param dev The PCI function
+ * @param reg Register offset (dword aligned)
+ * @return    The register value
+ */
+unsigned int pci_config_read32(const PCI_DEVICE * dev, unsigned char reg);
+
+/**
+ * @name pci_config_read16
+ *
+ * @brief Reads a word from the configuration space of a function
+ */
+unsigned short pci_config_read16(const PCI_DEVICE * dev, unsigned char reg);
+
+/**
+ * @name pci_config_write16
+ *
+ * @brief Writes a word to the configuration space of a function
+ */
+void pci_config_write16(const PCI_DEVICE * dev, unsigned char reg, unsigned short val);
+
+/**
+ * @name pci_find_device
+ *
+ * @brief Scans all buses for the first function with the given IDs
+ *
+ * @param vendor_id The vendor ID to match
+ * @param device_id The device ID to match
+ * @param dev       Filled in with the function location on success
+ * @return          0 on success, -1 if no such device
+ */
+int pci_find_device(unsigned short vendor_id, unsigned short device_id, PCI_DEVICE * dev);
+
+/**
+ * @name pci_enable_device
+ *
+ * @brief Enables I/O, memory decoding and bus mastering (DMA) for a function
+ */
+void pci_enable_device(const PCI_DEVICE * dev);
+
+#endif /* INCLUDE_PCI_H */
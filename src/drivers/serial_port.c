@@ -7,12 +7,44 @@
 /******************************************* Includes */
 #include "io.h"
 #include "os_common.h"
+#include "cpu.h"
+#include "irq.h"
+#include "softirq.h"
+#include "input.h"
+#include "wait.h"
 #include "serial_port.h"
+#include "initcall.h"
 
 /******************************************* Defines */
+#define SERIAL_TX_RING_MASK             (SERIAL_TX_RING_SIZE - 1U)
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct SERIAL_TX_RING
+ * @brief COM1 output waiting for the UART, threads produce, the softirq
+ * consumes
+ */
+typedef struct _SERIAL_TX_RING
+{
+    char                  buf[SERIAL_TX_RING_SIZE];
+    volatile unsigned int head;       /**< Next byte to fill */
+    volatile unsigned int tail;       /**< Next byte to send */
+    int                   enabled;    /**< Set by serial_enable_tx_interrupt() */
+} SERIAL_TX_RING;
 
 /******************************************* Macros */
 
+/******************************************* Static global defines */
+static SERIAL_TX_RING serial_tx;
+
+static SERIAL_TX_STATS serial_tx_stats;
+
+/** Writers waiting for room in the ring, or for it to drain */
+static WAIT_QUEUE serial_tx_wait = WAIT_QUEUE_INIT;
+
+/** Shadow of the COM1 interrupt enable register */
+static unsigned char serial_ier;
+
 /******************************************* Functions */
 void serial_configure_baud_rate(unsigned short com, unsigned short divisor)
 {
@@ -42,19 +74,246 @@ void serial_configure_modem(unsigned short com, unsigned char config)
 int serial_is_transmit_fifo_empty(unsigned int com)
 {
     /* checking 5th bit  of line status port */
-    return (inb(SERIAL_LINE_STATUS_PORT(com)) & 0x20U);
+    return (inb(SERIAL_LINE_STATUS_PORT(com)) & SERIAL_LINE_TX_EMPTY);
+}
+
+/**
+ * @name serial_putc_polled
+ *
+ * @brief Spins until the transmitter takes one byte
+ */
+static void serial_putc_polled(unsigned short com, char c)
+{
+    /* wait until FIFO queu is empty */
+    while (!serial_is_transmit_fifo_empty(com)) {};
+
+    /* send data */
+    outb(SERIAL_DATA_PORT(com), c);
+}
+
+/**
+ * @name serial_tx_kick
+ *
+ * @brief Asks for a transmitter empty interrupt, the UART raises it at once
+ * if the FIFO is already empty
+ *
+ * @note Called with interrupts disabled.
+ */
+static void serial_tx_kick(void)
+{
+    if (!(serial_ier & SERIAL_INT_TX_EMPTY))
+    {
+        serial_ier |= SERIAL_INT_TX_EMPTY;
+        outb(SERIAL_INT_ENABLE_PORT(SERIAL_COM1_BASE), serial_ier);
+    }
+}
+
+/**
+ * @name serial_tx_softirq
+ *
+ * @brief SOFTIRQ_SERIAL, refills the transmit FIFO from the ring
+ */
+static void serial_tx_softirq(void)
+{
+    unsigned int flags;
+    unsigned int n;
+
+    /* Keeps a polled writer from an interrupt from getting in between */
+    flags = local_irq_save();
+    if (serial_is_transmit_fifo_empty(SERIAL_COM1_BASE))
+    {
+        for (n = 0; (n < SERIAL_TX_FIFO_SIZE) && (serial_tx.tail != serial_tx.head); n++)
+        {
+            outb(SERIAL_DATA_PORT(SERIAL_COM1_BASE),
+                 serial_tx.buf[serial_tx.tail & SERIAL_TX_RING_MASK]);
+            serial_tx.tail++;
+        }
+        serial_tx_stats.refills++;
+    }
+
+    /* Nothing left, stop the interrupts until the next write */
+    if (serial_tx.tail == serial_tx.head)
+    {
+        serial_ier &= ~SERIAL_INT_TX_EMPTY;
+        outb(SERIAL_INT_ENABLE_PORT(SERIAL_COM1_BASE), serial_ier);
+    }
+    if (waitqueue_active(&serial_tx_wait))
+    {
+        wake_up_all(&serial_tx_wait);
+    }
+    local_irq_restore(flags);
 }
 
 void serial_write(unsigned short com, char * buf, unsigned int len)
 {
+    unsigned int flags;
     unsigned int i;
 
+    flags = local_irq_save();
+    if ((com != SERIAL_COM1_BASE) || !serial_tx.enabled || !(flags & EFLAGS_IF) ||
+        in_interrupt())
+    {
+        /* Whatever is queued goes first */
+        while ((com == SERIAL_COM1_BASE) && (serial_tx.tail != serial_tx.head))
+        {
+            serial_putc_polled(com, serial_tx.buf[serial_tx.tail & SERIAL_TX_RING_MASK]);
+            serial_tx.tail++;
+        }
+        for (i = 0; i < len; i++)
+        {
+            serial_putc_polled(com, buf[i]);
+        }
+        serial_tx_stats.polled += len;
+        local_irq_restore(flags);
+        return;
+    }
+
     for (i = 0; i < len; i++)
     {
-        /* wait until FIFO queu is empty */
-        while (!serial_is_transmit_fifo_empty(com)) {};
+        if (serial_tx.head - serial_tx.tail == SERIAL_TX_RING_SIZE)
+        {
+            /* Full: sleep until the bottom half made room. Console output
+             * comes from an RCU reader, which must not sleep: halt there */
+            serial_tx_stats.full_waits++;
+            serial_tx_kick();
+            if (preempt_count() != 0)
+            {
+                while (serial_tx.head - serial_tx.tail == SERIAL_TX_RING_SIZE)
+                {
+                    cpu_idle();
+                    local_irq_disable();
+                }
+            }
+            else
+            {
+                wait_event(&serial_tx_wait,
+                           serial_tx.head - serial_tx.tail != SERIAL_TX_RING_SIZE);
+            }
+        }
+        serial_tx.buf[serial_tx.head & SERIAL_TX_RING_MASK] = buf[i];
+        serial_tx.head++;
+    }
+    serial_tx_stats.queued += len;
+    serial_tx_kick();
+    local_irq_restore(flags);
+}
 
-        /* send data */
-        outb(SERIAL_DATA_PORT(com), buf[i]);
+/**
+ * @name serial_irq
+ *
+ * @brief IRQ4 handler, queues every byte waiting in the receive FIFO and
+ * leaves transmit refills to SOFTIRQ_SERIAL
+ */
+static void serial_irq(unsigned int irq, void * ctx)
+{
+    unsigned char iid;
+
+    (void) irq;
+    (void) ctx;
+
+    /* Reading the identification acknowledges a transmitter empty
+     * interrupt, the others are cleared by reading their register */
+    while (!((iid = inb(SERIAL_INT_ID_PORT(SERIAL_COM1_BASE))) & SERIAL_IID_NONE))
+    {
+        switch (iid & SERIAL_IID_MASK)
+        {
+        case SERIAL_IID_RX_AVAILABLE:
+        case SERIAL_IID_RX_TIMEOUT:
+            while (inb(SERIAL_LINE_STATUS_PORT(SERIAL_COM1_BASE)) & SERIAL_LINE_DATA_READY)
+            {
+                input_push(INPUT_SRC_SERIAL, inb(SERIAL_DATA_PORT(SERIAL_COM1_BASE)));
+            }
+            break;
+        case SERIAL_IID_TX_EMPTY:
+            softirq_raise(SOFTIRQ_SERIAL);
+            break;
+        case SERIAL_IID_LINE_STATUS:
+            inb(SERIAL_LINE_STATUS_PORT(SERIAL_COM1_BASE));
+            break;
+        default:
+            inb(SERIAL_MODEM_STATUS_PORT(SERIAL_COM1_BASE));
+            break;
+        }
+    }
+}
+
+int serial_enable_rx_interrupt(void)
+{
+    int ret;
+
+    ret = irq_register(IRQ_COM1, serial_irq, NULL);
+    if (ret != IRQ_OK)
+    {
+        return ret;
+    }
+
+    /* Drop stale input, then ask for an interrupt per received byte */
+    while (inb(SERIAL_LINE_STATUS_PORT(SERIAL_COM1_BASE)) & SERIAL_LINE_DATA_READY)
+    {
+        inb(SERIAL_DATA_PORT(SERIAL_COM1_BASE));
     }
-}
\ No newline at end of file
+    serial_ier |= SERIAL_INT_RX_AVAILABLE;
+    outb(SERIAL_INT_ENABLE_PORT(SERIAL_COM1_BASE), serial_ier);
+    irq_unmask(IRQ_COM1);
+    return IRQ_OK;
+}
+
+void serial_enable_tx_interrupt(void)
+{
+    softirq_open(SOFTIRQ_SERIAL, serial_tx_softirq);
+    serial_tx.enabled = 1;
+}
+
+const SERIAL_TX_STATS * serial_get_tx_stats(void)
+{
+    return &serial_tx_stats;
+}
+
+unsigned int serial_tx_pending(void)
+{
+    return serial_tx.head - serial_tx.tail;
+}
+
+void serial_flush(void)
+{
+    unsigned int flags;
+
+    flags = local_irq_save();
+    if (!(flags & EFLAGS_IF) || in_interrupt() || (preempt_count() != 0))
+    {
+        /* Cannot sleep, push it out by hand */
+        while (serial_tx.tail != serial_tx.head)
+        {
+            serial_putc_polled(SERIAL_COM1_BASE,
+                               serial_tx.buf[serial_tx.tail & SERIAL_TX_RING_MASK]);
+            serial_tx.tail++;
+        }
+    }
+    else
+    {
+        wait_event(&serial_tx_wait, serial_tx.tail == serial_tx.head);
+    }
+    local_irq_restore(flags);
+}
+
+/**
+ * @name serial_irq_initcall
+ *
+ * @brief Starts COM1 receive and transmit interrupts
+ *
+ * @return 0, or the irq_register() error, with COM1 left polled
+ */
+static int serial_irq_initcall(void)
+{
+    int ret;
+
+    /* Without the IRQ4 handler nothing would drain the ring, stay polled */
+    ret = serial_enable_rx_interrupt();
+    if (ret != IRQ_OK)
+    {
+        return ret;
+    }
+    serial_enable_tx_interrupt();
+    return 0;
+}
+INITCALL_DEVICE(serial_irq_initcall);
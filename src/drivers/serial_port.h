@@ -17,11 +17,39 @@
 #define SERIAL_COM1_BASE                0x3F8      /* COM1 base port */
 
 #define SERIAL_DATA_PORT(base)          (base)
+#define SERIAL_INT_ENABLE_PORT(base)    (base + 1)
 #define SERIAL_FIFO_COMMAND_PORT(base)  (base + 2)
+#define SERIAL_INT_ID_PORT(base)        (base + 2)  /* Same port, read */
 #define SERIAL_LINE_COMMAND_PORT(base)  (base + 3)
 #define SERIAL_MODEM_COMMAND_PORT(base) (base + 4)
 #define SERIAL_LINE_STATUS_PORT(base)   (base + 5)
 
+/* Interrupt enable register: raise an interrupt when data arrives or
+ * when the transmit FIFO ran empty */
+#define SERIAL_INT_RX_AVAILABLE         0x01
+#define SERIAL_INT_TX_EMPTY             0x02
+
+/* Interrupt identification register */
+#define SERIAL_IID_NONE                 0x01    /* No interrupt pending */
+#define SERIAL_IID_MASK                 0x0E
+#define SERIAL_IID_MODEM                0x00
+#define SERIAL_IID_TX_EMPTY             0x02
+#define SERIAL_IID_RX_AVAILABLE         0x04
+#define SERIAL_IID_LINE_STATUS          0x06
+#define SERIAL_IID_RX_TIMEOUT           0x0C
+
+#define SERIAL_MODEM_STATUS_PORT(base)  (base + 6)
+
+/* Bytes the 16550 transmit FIFO takes once it is empty */
+#define SERIAL_TX_FIFO_SIZE             16U
+
+/* COM1 transmit ring, power of two */
+#define SERIAL_TX_RING_SIZE             2048U
+
+/* Line status register bits */
+#define SERIAL_LINE_DATA_READY          0x01
+#define SERIAL_LINE_TX_EMPTY            0x20
+
 /* The I/O port commands */
 
 /* SERIAL_LINE_ENABLE_DLAB:
@@ -30,6 +58,19 @@
 */
 #define SERIAL_LINE_ENABLE_DLAB         0x80
 
+/******************************************* Typedefs/structures */
+/**
+ * @struct SERIAL_TX_STATS
+ * @brief COM1 transmit counters
+ */
+typedef struct _SERIAL_TX_STATS
+{
+    unsigned int queued;              /**< Bytes put in the transmit ring */
+    unsigned int polled;              /**< Bytes written by spinning on LSR */
+    unsigned int refills;             /**< FIFO refills by the softirq */
+    unsigned int full_waits;          /**< Writers that found the ring full */
+} SERIAL_TX_STATS;
+
 /******************************************* Macros */
 
 /**
@@ -174,9 +215,63 @@ int serial_is_transmit_fifo_empty(unsigned int com);
  *
  * @brief writes a string to the given seral port
  *
+ * @par Once @ref serial_enable_tx_interrupt ran, COM1 output from threads
+ * goes through a ring that the SOFTIRQ_SERIAL bottom half feeds to the UART
+ * FIFO, and the writer only waits when the ring is full. With interrupts
+ * disabled, in interrupt context and on other ports it spins on the line
+ * status register, after flushing the ring so the output stays in order.
+ *
  * @param com the com port to write
  * @param buf the string to write
  * @param len the length of the string
  */
 void serial_write(unsigned short com, char * buf, unsigned int len);
+
+/**
+ * @name serial_enable_rx_interrupt
+ *
+ * @brief Enables the receive interrupt of COM1 on IRQ4
+ *
+ * @par The handler drains the receive FIFO into the serial input ring. The
+ * modem must be configured with AO2 set, otherwise the UART's interrupt
+ * line is not connected to the PIC.
+ *
+ * @return IRQ_OK, or the error of irq_register()
+ */
+int serial_enable_rx_interrupt(void);
+
+/**
+ * @name serial_enable_tx_interrupt
+ *
+ * @brief Switches COM1 output to the interrupt driven ring
+ *
+ * @note Call only once @ref serial_enable_rx_interrupt installed the IRQ4
+ * handler, nothing else drains the ring.
+ */
+void serial_enable_tx_interrupt(void);
+
+/**
+ * @name serial_get_tx_stats
+ *
+ * @brief Returns the COM1 transmit counters
+ */
+const SERIAL_TX_STATS * serial_get_tx_stats(void);
+
+/**
+ * @name serial_tx_pending
+ *
+ * @brief Returns the bytes in the COM1 transmit ring not sent yet
+ */
+unsigned int serial_tx_pending(void);
+
+/**
+ * @name serial_flush
+ *
+ * @brief Returns once the COM1 transmit ring is empty
+ *
+ * @par A thread sleeps until the bottom half sent the last byte; with
+ * interrupts or preemption disabled and in interrupt context the ring is
+ * sent by polling.
+ */
+void serial_flush(void);
 #endif /* INCLUDE_SERIAL_PORT_H */
\ No newline at end of file
@@ -0,0 +1,118 @@
+/**
+ * @file virtio.h
+ *
+ * @brief Header file for the legacy virtio PCI transport and split virtqueues
+ */
+#ifndef INCLUDE_VIRTIO_H
+#define INCLUDE_VIRTIO_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** All virtio devices use the Red Hat / Qumranet vendor ID */
+#define VIRTIO_PCI_VENDOR_ID            0x1AF4
+
+/**
+ * @name Legacy virtio PCI registers
+ * @par Offsets into the I/O space of BAR0. The device specific config follows
+ * at VIRTIO_PCI_CONFIG when MSI-X is disabled.
+ */
+#define VIRTIO_PCI_DEVICE_FEATURES(base)    (base + 0x00)
+#define VIRTIO_PCI_GUEST_FEATURES(base)     (base + 0x04)
+#define VIRTIO_PCI_QUEUE_PFN(base)          (base + 0x08)
+#define VIRTIO_PCI_QUEUE_SIZE(base)         (base + 0x0C)
+#define VIRTIO_PCI_QUEUE_SELECT(base)       (base + 0x0E)
+#define VIRTIO_PCI_QUEUE_NOTIFY(base)       (base + 0x10)
+#define VIRTIO_PCI_STATUS(base)             (base + 0x12)
+#define VIRTIO_PCI_ISR(base)                (base + 0x13)
+#define VIRTIO_PCI_CONFIG(base)             (base + 0x14)
+
+/* Device status bits */
+#define VIRTIO_STATUS_ACKNOWLEDGE       0x01
+#define VIRTIO_STATUS_DRIVER            0x02
+#define VIRTIO_STATUS_DRIVER_OK         0x04
+#define VIRTIO_STATUS_FAILED            0x80
+
+/* ISR status bits, reading the register clears them and the interrupt */
+#define VIRTIO_PCI_ISR_QUEUE            0x01    /**< A used ring was updated */
+#define VIRTIO_PCI_ISR_CONFIG           0x02    /**< Device config changed */
+
+/* Transport feature bits */
+#define VIRTIO_RING_F_INDIRECT_DESC     (1U << 28)
+
+/* Descriptor flags */
+#define VIRTQ_DESC_F_NEXT               0x1     /**< Chain continues via next */
+#define VIRTQ_DESC_F_WRITE              0x2     /**< Device writes the buffer */
+#define VIRTQ_DESC_F_INDIRECT           0x4     /**< Buffer is a descriptor table */
+
+/* Ring flags */
+#define VIRTQ_AVAIL_F_NO_INTERRUPT      0x1     /**< Driver polls, no IRQ wanted */
+#define VIRTQ_USED_F_NO_NOTIFY          0x1     /**< Device polls, skip doorbell */
+
+/** Legacy queues are placed by page frame number */
+#define VIRTIO_PCI_QUEUE_ADDR_SHIFT     12U
+/** Legacy used ring starts on the next page boundary */
+#define VIRTIO_PCI_VRING_ALIGN          4096U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct VIRTQ_DESC
+ * @brief One buffer in a descriptor table
+ */
+typedef struct _VIRTQ_DESC
+{
+    unsigned long long addr;      /**< Guest physical address */
+    unsigned int       len;       /**< Length in bytes */
+    unsigned short     flags;     /**< VIRTQ_DESC_F_* */
+    unsigned short     next;      /**< Next descriptor if F_NEXT is set */
+} __attribute__((packed)) VIRTQ_DESC;
+
+/**
+ * @struct VIRTQ_AVAIL
+ * @brief Driver to device ring of descriptor chain heads
+ */
+typedef struct _VIRTQ_AVAIL
+{
+    unsigned short flags;         /**< VIRTQ_AVAIL_F_* */
+    unsigned short idx;           /**< Free running producer index */
+    unsigned short ring[];        /**< Chain heads, then used_event */
+} __attribute__((packed)) VIRTQ_AVAIL;
+
+/**
+ * @struct VIRTQ_USED_ELEM
+ * @brief One completed descriptor chain
+ */
+typedef struct _VIRTQ_USED_ELEM
+{
+    unsigned int id;              /**< Head of the completed chain */
+    unsigned int len;             /**< Bytes written by the device */
+} __attribute__((packed)) VIRTQ_USED_ELEM;
+
+/**
+ * @struct VIRTQ_USED
+ * @brief Device to driver ring of completed chains
+ */
+typedef struct _VIRTQ_USED
+{
+    unsigned short  flags;        /**< VIRTQ_USED_F_* */
+    unsigned short  idx;          /**< Free running producer index */
+    VIRTQ_USED_ELEM ring[];       /**< Completions, then avail_event */
+} __attribute__((packed)) VIRTQ_USED;
+
+/******************************************* Macros */
+
+/**
+ * @name Size of a legacy split virtqueue
+ *
+ * @par Descriptor table and avail ring, padded to a page, then the used ring.
+ */
+#define VIRTQ_AVAIL_OFFSET(qsz) \
+        (sizeof(VIRTQ_DESC) * (qsz))
+#define VIRTQ_USED_OFFSET(qsz)  \
+        ALIGN_UP(VIRTQ_AVAIL_OFFSET(qsz) + (2U * (3U + (qsz))), VIRTIO_PCI_VRING_ALIGN)
+#define VIRTQ_SIZE(qsz)         \
+        (VIRTQ_USED_OFFSET(qsz) + \
+         ALIGN_UP((2U * 3U) + (sizeof(VIRTQ_USED_ELEM) * (qsz)), VIRTIO_PCI_VRING_ALIGN))
+
+/******************************************* Protoytes */
+
+#endif /* INCLUDE_VIRTIO_H */
@@ -0,0 +1,407 @@
+/**
+ * @file virtio_blk.c
+ *
+ * @brief Implementation of the virtio block device driver
+ *
+ * @par Every request takes exactly one slot of the virtqueue: the ring
+ * descriptor points at a per-slot indirect table holding the request header,
+ * the data segments and the status byte. Submitting only writes the avail
+ * ring; the avail index is published and the doorbell rung once per batch by
+ * virtio_blk_kick(), so a batch of N requests costs one VM exit instead of N.
+ * Completions are reaped from the used ring by virtio_blk_poll(), called by
+ * a waiter or, when the device has a legacy interrupt line, by the
+ * SOFTIRQ_BLK bottom half so waiters can sleep.
+ */
+
+/******************************************* Includes */
+#include "io.h"
+#include "os_common.h"
+#include "cpu.h"
+#include "kstring.h"
+#include "pci.h"
+#include "irq.h"
+#include "softirq.h"
+#include "virtio.h"
+#include "virtio_blk.h"
+
+/******************************************* Defines */
+/** Descriptors in an indirect table: header + data segments + status */
+#define VIRTIO_BLK_INDIRECT_DESCS       (BLK_MAX_SEGS + 2U)
+
+/** Ring memory for the largest queue we accept */
+#define VIRTIO_BLK_RING_MEM_SIZE        VIRTQ_SIZE(VIRTIO_BLK_MAX_QUEUE_SIZE)
+
+/** Sentinel for an empty slot free list */
+#define VIRTIO_BLK_NO_SLOT              0xFFFFU
+
+/******************************************* Macros */
+
+/** Read a ring index the device may update behind our back */
+#define READ_ONCE_U16(x) (*(volatile unsigned short *) &(x))
+
+/******************************************* Static global defines */
+/**
+ * @struct VIRTIO_BLK_DEV
+ * @brief State of the (single) virtio block device
+ */
+typedef struct _VIRTIO_BLK_DEV
+{
+    PCI_DEVICE          pci;          /**< PCI location */
+    unsigned short      iobase;       /**< Legacy register block */
+    unsigned int        irq;          /**< Interrupt line, IRQ_COUNT if polled */
+    unsigned short      qsize;        /**< Virtqueue size (power of two) */
+    unsigned short      nr_slots;     /**< Usable request slots */
+    unsigned short      free_head;    /**< First free slot */
+    unsigned short      avail_idx;    /**< Next avail index, not yet published */
+    unsigned short      last_used;    /**< Last used index we consumed */
+    unsigned int        inflight;     /**< Submitted, not completed */
+    unsigned int        pending;      /**< Submitted, not yet kicked */
+    unsigned long long  capacity;     /**< Size in sectors */
+    VIRTQ_DESC         *desc;         /**< Descriptor table */
+    VIRTQ_AVAIL        *avail;        /**< Avail ring */
+    VIRTQ_USED         *used;         /**< Used ring */
+    VIRTIO_BLK_STATS    stats;        /**< Counters */
+} VIRTIO_BLK_DEV;
+
+static VIRTIO_BLK_DEV vblk;
+
+/** Registry entry, the operations are the virtio_blk_* functions */
+static BLK_DEVICE vblk_blkdev =
+{
+    .name   = "vda",
+    .submit = virtio_blk_submit,
+    .kick   = virtio_blk_kick,
+    .poll   = virtio_blk_poll,
+};
+
+/** Virtqueue memory, legacy devices want it page aligned */
+static unsigned char vblk_ring_mem[VIRTIO_BLK_RING_MEM_SIZE]
+    __attribute__((aligned(VIRTIO_PCI_VRING_ALIGN)));
+
+/** One indirect descriptor table per request slot */
+static VIRTQ_DESC vblk_indirect[VIRTIO_BLK_MAX_INFLIGHT][VIRTIO_BLK_INDIRECT_DESCS]
+    __attribute__((aligned(16)));
+
+/** Request owning each slot */
+static BLK_REQUEST *vblk_slot_req[VIRTIO_BLK_MAX_INFLIGHT];
+
+/** Free list links, indexed by slot */
+static unsigned short vblk_slot_next[VIRTIO_BLK_MAX_INFLIGHT];
+
+/******************************************* Functions */
+
+/**
+ * @name virtio_blk_irq
+ *
+ * @brief Interrupt handler, acknowledges the device and leaves reaping to
+ * SOFTIRQ_BLK
+ */
+static void virtio_blk_irq(unsigned int irq, void * ctx)
+{
+    (void) irq;
+    (void) ctx;
+
+    /* Reading the status acknowledges the interrupt */
+    if (inb(VIRTIO_PCI_ISR(vblk.iobase)) & VIRTIO_PCI_ISR_QUEUE)
+    {
+        vblk.stats.irqs++;
+        softirq_raise(SOFTIRQ_BLK);
+    }
+}
+
+/**
+ * @name virtio_blk_softirq
+ *
+ * @brief SOFTIRQ_BLK, runs the completions
+ */
+static void virtio_blk_softirq(void)
+{
+    virtio_blk_poll();
+}
+
+/**
+ * @name virtio_blk_setup_irq
+ *
+ * @brief Takes the device's interrupt line, the device stays polled if it
+ * has none or the line is taken
+ */
+static void virtio_blk_setup_irq(void)
+{
+    unsigned int line;
+
+    vblk.irq = IRQ_COUNT;
+    line = pci_config_read32(&vblk.pci, PCI_INTERRUPT_LINE) & 0xFFU;
+    if ((line >= IRQ_COUNT) || (irq_register(line, virtio_blk_irq, NULL) != IRQ_OK))
+    {
+        vblk.avail->flags = VIRTQ_AVAIL_F_NO_INTERRUPT;
+        return;
+    }
+    softirq_open(SOFTIRQ_BLK, virtio_blk_softirq);
+    vblk.irq = line;
+    vblk.avail->flags = 0;
+    vblk_blkdev.flags |= BLK_DEV_IRQ;
+}
+
+/**
+ * @name vblk_set_desc
+ *
+ * @brief Fills in a descriptor. The kernel is identity mapped, so the
+ * virtual address is the physical one.
+ */
+static void vblk_set_desc(VIRTQ_DESC * d, const void * buf, unsigned int len,
+                          unsigned short flags, unsigned short next)
+{
+    d->addr  = (unsigned int) buf;
+    d->len   = len;
+    d->flags = flags;
+    d->next  = next;
+}
+
+int virtio_blk_init(void)
+{
+    unsigned int features;
+    unsigned int bar0;
+    unsigned short i;
+
+    if (vblk.qsize != 0)
+    {
+        /* Already set up */
+        return BLK_OK;
+    }
+    memset(&vblk, 0, sizeof(vblk));
+
+    if (pci_find_device(VIRTIO_PCI_VENDOR_ID, VIRTIO_BLK_PCI_DEVICE_ID, &vblk.pci) != 0)
+    {
+        return BLK_ERR_NODEV;
+    }
+
+    bar0 = pci_config_read32(&vblk.pci, PCI_BAR0);
+    if (!(bar0 & PCI_BAR_IO))
+    {
+        return BLK_ERR_NODEV;
+    }
+    vblk.iobase = bar0 & PCI_BAR_IO_MASK;
+    pci_enable_device(&vblk.pci);
+
+    /* Reset, then tell the device we found it and can drive it */
+    outb(VIRTIO_PCI_STATUS(vblk.iobase), 0);
+    outb(VIRTIO_PCI_STATUS(vblk.iobase), VIRTIO_STATUS_ACKNOWLEDGE);
+    outb(VIRTIO_PCI_STATUS(vblk.iobase),
+         VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+
+    /* Indirect descriptors are what keeps one request to one ring slot */
+    features = inl(VIRTIO_PCI_DEVICE_FEATURES(vblk.iobase));
+    if (!(features & VIRTIO_RING_F_INDIRECT_DESC))
+    {
+        outb(VIRTIO_PCI_STATUS(vblk.iobase), VIRTIO_STATUS_FAILED);
+        return BLK_ERR_NODEV;
+    }
+    outl(VIRTIO_PCI_GUEST_FEATURES(vblk.iobase), VIRTIO_RING_F_INDIRECT_DESC);
+
+    /* Request queue 0 */
+    outw(VIRTIO_PCI_QUEUE_SELECT(vblk.iobase), 0);
+    vblk.qsize = inw(VIRTIO_PCI_QUEUE_SIZE(vblk.iobase));
+    if ((vblk.qsize == 0) || (vblk.qsize > VIRTIO_BLK_MAX_QUEUE_SIZE) ||
+        (vblk.qsize & (vblk.qsize - 1U)))
+    {
+        vblk.qsize = 0;
+        outb(VIRTIO_PCI_STATUS(vblk.iobase), VIRTIO_STATUS_FAILED);
+        return BLK_ERR_NODEV;
+    }
+
+    memset(vblk_ring_mem, 0, VIRTQ_SIZE(vblk.qsize));
+    vblk.desc  = (VIRTQ_DESC *) vblk_ring_mem;
+    vblk.avail = (VIRTQ_AVAIL *) (vblk_ring_mem + VIRTQ_AVAIL_OFFSET(vblk.qsize));
+    vblk.used  = (VIRTQ_USED *) (vblk_ring_mem + VIRTQ_USED_OFFSET(vblk.qsize));
+
+    /* Interrupts if we get a line, polling otherwise */
+    virtio_blk_setup_irq();
+
+    /* Ring descriptor i permanently points at indirect table i */
+    vblk.nr_slots = (vblk.qsize < VIRTIO_BLK_MAX_INFLIGHT) ? vblk.qsize
+                                                           : VIRTIO_BLK_MAX_INFLIGHT;
+    for (i = 0; i < vblk.nr_slots; i++)
+    {
+        vblk_set_desc(&vblk.desc[i], vblk_indirect[i], 0, VIRTQ_DESC_F_INDIRECT, 0);
+        vblk_slot_next[i] = (i + 1U < vblk.nr_slots) ? (i + 1U) : VIRTIO_BLK_NO_SLOT;
+    }
+    vblk.free_head = 0;
+
+    outl(VIRTIO_PCI_QUEUE_PFN(vblk.iobase),
+         ((unsigned int) vblk_ring_mem) >> VIRTIO_PCI_QUEUE_ADDR_SHIFT);
+
+    /* Capacity is a 64 bit little endian field at the start of the config */
+    vblk.capacity = inl(VIRTIO_PCI_CONFIG(vblk.iobase)) |
+                    ((unsigned long long) inl(VIRTIO_PCI_CONFIG(vblk.iobase) + 4) << 32);
+
+    outb(VIRTIO_PCI_STATUS(vblk.iobase),
+         VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_DRIVER_OK);
+
+    vblk_blkdev.capacity = vblk.capacity;
+    blk_register(&vblk_blkdev);
+    if (vblk.irq != IRQ_COUNT)
+    {
+        irq_unmask(vblk.irq);
+    }
+    return BLK_OK;
+}
+
+unsigned long long virtio_blk_capacity(void)
+{
+    return vblk.capacity;
+}
+
+int virtio_blk_submit(BLK_REQUEST * req)
+{
+    VIRTQ_DESC *table;
+    unsigned short slot;
+    unsigned int flags;
+    unsigned int i;
+    unsigned short data_flags;
+
+    if (vblk.qsize == 0)
+    {
+        return BLK_ERR_NODEV;
+    }
+    if ((req->nr_segs > BLK_MAX_SEGS) || (req->done == NULL))
+    {
+        return BLK_ERR_INVAL;
+    }
+
+    switch (req->op)
+    {
+    case BLK_OP_READ:
+        req->hdr[0] = VIRTIO_BLK_T_IN;
+        data_flags = VIRTQ_DESC_F_WRITE;
+        break;
+    case BLK_OP_WRITE:
+        req->hdr[0] = VIRTIO_BLK_T_OUT;
+        data_flags = 0;
+        break;
+    case BLK_OP_FLUSH:
+        req->hdr[0] = VIRTIO_BLK_T_FLUSH;
+        data_flags = 0;
+        break;
+    default:
+        return BLK_ERR_INVAL;
+    }
+
+    /* The bottom half frees slots and may submit from callbacks */
+    flags = local_irq_save();
+    slot = vblk.free_head;
+    if (slot == VIRTIO_BLK_NO_SLOT)
+    {
+        local_irq_restore(flags);
+        return BLK_ERR_BUSY;
+    }
+    vblk.free_head = vblk_slot_next[slot];
+
+    req->hdr[1] = 0;
+    req->hdr[2] = (unsigned int) req->sector;
+    req->hdr[3] = (unsigned int) (req->sector >> 32);
+    req->status = 0xFF;
+
+    /* Header, data segments, status byte: all in the slot's indirect table */
+    table = vblk_indirect[slot];
+    vblk_set_desc(&table[0], req->hdr, sizeof(req->hdr), VIRTQ_DESC_F_NEXT, 1);
+    for (i = 0; i < req->nr_segs; i++)
+    {
+        vblk_set_desc(&table[i + 1U], req->segs[i].buf, req->segs[i].len,
+                      data_flags | VIRTQ_DESC_F_NEXT, i + 2U);
+    }
+    vblk_set_desc(&table[i + 1U], &req->status, 1, VIRTQ_DESC_F_WRITE, 0);
+    vblk.desc[slot].len = (req->nr_segs + 2U) * sizeof(VIRTQ_DESC);
+
+    vblk_slot_req[slot] = req;
+    req->submit_tsc = rdtsc();
+
+    /* Fill the avail slot, the index is published by virtio_blk_kick() */
+    vblk.avail->ring[vblk.avail_idx & (vblk.qsize - 1U)] = slot;
+    vblk.avail_idx++;
+    vblk.pending++;
+    vblk.inflight++;
+    vblk.stats.submitted++;
+    local_irq_restore(flags);
+    return BLK_OK;
+}
+
+void virtio_blk_kick(void)
+{
+    unsigned int flags;
+
+    flags = local_irq_save();
+    if (vblk.pending == 0)
+    {
+        local_irq_restore(flags);
+        return;
+    }
+
+    /* Descriptors and ring entries must be visible before the index */
+    wmb();
+    vblk.avail->idx = vblk.avail_idx;
+    vblk.pending = 0;
+
+    /* The index store must be visible before we look at the device's flag */
+    mb();
+    if (READ_ONCE_U16(vblk.used->flags) & VIRTQ_USED_F_NO_NOTIFY)
+    {
+        vblk.stats.kicks_skipped++;
+    }
+    else
+    {
+        outw(VIRTIO_PCI_QUEUE_NOTIFY(vblk.iobase), 0);
+        vblk.stats.kicks++;
+    }
+    local_irq_restore(flags);
+}
+
+unsigned int virtio_blk_poll(void)
+{
+    VIRTQ_USED_ELEM *elem;
+    BLK_REQUEST *req;
+    unsigned short slot;
+    unsigned int reaped = 0;
+    unsigned int flags;
+
+    if (vblk.qsize == 0)
+    {
+        return 0;
+    }
+
+    /* A waiter and the bottom half may both poll */
+    flags = local_irq_save();
+
+    while (vblk.last_used != READ_ONCE_U16(vblk.used->idx))
+    {
+        /* Don't read the element before we have seen the index */
+        rmb();
+        elem = &vblk.used->ring[vblk.last_used & (vblk.qsize - 1U)];
+        slot = (unsigned short) elem->id;
+        vblk.last_used++;
+
+        req = vblk_slot_req[slot];
+        vblk_slot_req[slot] = NULL;
+        vblk_slot_next[slot] = vblk.free_head;
+        vblk.free_head = slot;
+        vblk.inflight--;
+        vblk.stats.completed++;
+        reaped++;
+
+        req->done(req, (req->status == VIRTIO_BLK_S_OK) ? BLK_OK : BLK_ERR_IO);
+    }
+
+    /* Resubmissions from the callbacks go out with a single doorbell */
+    virtio_blk_kick();
+    local_irq_restore(flags);
+    return reaped;
+}
+
+unsigned int virtio_blk_inflight(void)
+{
+    return vblk.inflight;
+}
+
+const VIRTIO_BLK_STATS * virtio_blk_get_stats(void)
+{
+    return &vblk.stats;
+}
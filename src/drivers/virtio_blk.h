@@ -0,0 +1,114 @@
+/**
+ * @file virtio_blk.h
+ *
+ * @brief Header file for the virtio block device driver
+ */
+#ifndef INCLUDE_VIRTIO_BLK_H
+#define INCLUDE_VIRTIO_BLK_H
+/******************************************* Includes */
+#include "blk.h"
+
+/******************************************* Defines */
+/** Transitional (legacy) virtio-blk PCI device ID */
+#define VIRTIO_BLK_PCI_DEVICE_ID        0x1001
+
+/** Requests that can be in flight at once, each takes one ring slot */
+#define VIRTIO_BLK_MAX_INFLIGHT         64U
+/** Largest virtqueue we have ring memory for */
+#define VIRTIO_BLK_MAX_QUEUE_SIZE       1024U
+
+/* Device request types */
+#define VIRTIO_BLK_T_IN                 0U
+#define VIRTIO_BLK_T_OUT                1U
+#define VIRTIO_BLK_T_FLUSH              4U
+
+/* Device status byte */
+#define VIRTIO_BLK_S_OK                 0U
+#define VIRTIO_BLK_S_IOERR              1U
+#define VIRTIO_BLK_S_UNSUPP             2U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct VIRTIO_BLK_STATS
+ * @brief Driver counters
+ */
+typedef struct _VIRTIO_BLK_STATS
+{
+    unsigned int submitted;       /**< Requests queued */
+    unsigned int completed;       /**< Requests reaped */
+    unsigned int kicks;           /**< Doorbell writes */
+    unsigned int kicks_skipped;   /**< Batches the device told us not to ring */
+    unsigned int irqs;            /**< Used ring interrupts */
+} VIRTIO_BLK_STATS;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name virtio_blk_init
+ *
+ * @brief Finds the first virtio-blk PCI device and sets up its request queue
+ *
+ * @par The device is registered with the block layer as "vda". Calling this
+ * again once the device is up does nothing.
+ *
+ * @return BLK_OK, or BLK_ERR_NODEV if there is no usable device
+ */
+int virtio_blk_init(void);
+
+/**
+ * @name virtio_blk_capacity
+ *
+ * @brief Returns the device size in BLK_SECTOR_SIZE sectors (0 if absent)
+ */
+unsigned long long virtio_blk_capacity(void);
+
+/**
+ * @name virtio_blk_submit
+ *
+ * @brief Queues a request without blocking and without notifying the device
+ *
+ * @note The request is only seen by the device after @ref virtio_blk_kick,
+ * so a batch of submits costs a single doorbell write (one VM exit).
+ *
+ * @param req The request, see @ref BLK_REQUEST
+ * @return    BLK_OK, BLK_ERR_BUSY if the queue is full or BLK_ERR_INVAL
+ */
+int virtio_blk_submit(BLK_REQUEST * req);
+
+/**
+ * @name virtio_blk_kick
+ *
+ * @brief Publishes all submitted requests and rings the doorbell once
+ */
+void virtio_blk_kick(void);
+
+/**
+ * @name virtio_blk_poll
+ *
+ * @brief Reaps completed requests and runs their callbacks
+ *
+ * @par Callbacks run with interrupts disabled. Requests submitted from a
+ * callback are kicked before returning. With the device's interrupt in use
+ * the bottom half reaps as well, so a poller must not take a 0 return for
+ * "nothing completed since I submitted".
+ *
+ * @return Number of requests completed
+ */
+unsigned int virtio_blk_poll(void);
+
+/**
+ * @name virtio_blk_inflight
+ *
+ * @brief Returns the number of submitted but not yet completed requests
+ */
+unsigned int virtio_blk_inflight(void);
+
+/**
+ * @name virtio_blk_get_stats
+ *
+ * @brief Returns the driver counters
+ */
+const VIRTIO_BLK_STATS * virtio_blk_get_stats(void);
+
+#endif /* INCLUDE_VIRTIO_BLK_H */
@@ -0,0 +1,440 @@
+/**
+ * @file ext2.c
+ *
+ * @brief Implementation of the read-only ext2 filesystem
+ *
+ * @par Directories and files are both read through the VFS page cache, so a
+ * directory block is fetched from the device once and then searched in
+ * memory. readpage() maps all blocks of a page first, merges physically
+ * contiguous blocks into one request and submits the whole page as a single
+ * batch.
+ *
+ * Block reads may sleep. The scratch block and the indirect block cache are
+ * shared by all readers, so they are only used under the superblock lock,
+ * which the VFS holds across readpage().
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "kstring.h"
+#include "kmalloc.h"
+#include "pmm.h"
+#include "blk.h"
+#include "vfs.h"
+#include "ext2.h"
+
+/******************************************* Defines */
+/** Block map levels with a cached indirect block each */
+#define EXT2_IND_LEVELS             3U
+
+/** No block cached at a level */
+#define EXT2_NO_BLOCK               0U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct EXT2_FS
+ * @brief Per mount state
+ */
+typedef struct _EXT2_FS
+{
+    BLK_DEVICE      *dev;                 /**< Device we read from */
+    unsigned int     block_size;          /**< Bytes per block */
+    unsigned int     sectors_per_block;   /**< Device sectors per block */
+    unsigned int     inodes_per_group;    /**< From the superblock */
+    unsigned int     inode_size;          /**< On-disk inode size */
+    unsigned int     groups;              /**< Number of block groups */
+    EXT2_GROUP_DESC *gdt;                 /**< Group descriptor table */
+    /* Shared by all readers, used under the superblock lock */
+    unsigned char   *scratch;             /**< One block for inode table reads */
+    unsigned int     ind_block[EXT2_IND_LEVELS];  /**< Cached indirect block numbers */
+    unsigned int    *ind_data[EXT2_IND_LEVELS];   /**< ... and their contents */
+} EXT2_FS;
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+static int ext2_lookup(INODE * dir, const char * name, unsigned int len, INODE ** out);
+static int ext2_readpage(INODE * inode, unsigned int index, void * page);
+static int ext2_mount(SUPER_BLOCK * sb, void * data);
+
+static const INODE_OPS ext2_inode_ops =
+{
+    .lookup   = ext2_lookup,
+    .readpage = ext2_readpage,
+};
+
+static FS_TYPE ext2_fs_type =
+{
+    .name  = "ext2",
+    .mount = ext2_mount,
+};
+
+/******************************************* Functions */
+
+/**
+ * @name ext2_read_block
+ *
+ * @brief Reads one filesystem block
+ */
+static int ext2_read_block(EXT2_FS * fs, unsigned int block, void * buf)
+{
+    return blk_read(fs->dev, (unsigned long long) block * fs->sectors_per_block,
+                    buf, fs->block_size);
+}
+
+/**
+ * @name ext2_indirect
+ *
+ * @brief Returns entry idx of an indirect block, caching one block per level
+ */
+static unsigned int ext2_indirect(EXT2_FS * fs, unsigned int level, unsigned int block,
+                                  unsigned int idx)
+{
+    if (block == EXT2_NO_BLOCK)
+    {
+        return EXT2_NO_BLOCK;
+    }
+    if (fs->ind_block[level] != block)
+    {
+        if (ext2_read_block(fs, block, fs->ind_data[level]) != BLK_OK)
+        {
+            fs->ind_block[level] = EXT2_NO_BLOCK;
+            return EXT2_NO_BLOCK;
+        }
+        fs->ind_block[level] = block;
+    }
+    return fs->ind_data[level][idx];
+}
+
+/**
+ * @name ext2_bmap
+ *
+ * @brief Maps a file block to a device block (0 for a hole)
+ */
+static unsigned int ext2_bmap(EXT2_FS * fs, const EXT2_INODE * ei, unsigned int lblock)
+{
+    unsigned int ppb = fs->block_size / sizeof(unsigned int);
+    unsigned int block;
+
+    if (lblock < EXT2_NDIR_BLOCKS)
+    {
+        return ei->i_block[lblock];
+    }
+    lblock -= EXT2_NDIR_BLOCKS;
+
+    if (lblock < ppb)
+    {
+        return ext2_indirect(fs, 0, ei->i_block[EXT2_IND_BLOCK], lblock);
+    }
+    lblock -= ppb;
+
+    if (lblock < ppb * ppb)
+    {
+        block = ext2_indirect(fs, 1, ei->i_block[EXT2_DIND_BLOCK], lblock / ppb);
+        return ext2_indirect(fs, 0, block, lblock % ppb);
+    }
+    lblock -= ppb * ppb;
+
+    block = ext2_indirect(fs, 2, ei->i_block[EXT2_TIND_BLOCK], lblock / (ppb * ppb));
+    block = ext2_indirect(fs, 1, block, (lblock / ppb) % ppb);
+    return ext2_indirect(fs, 0, block, lblock % ppb);
+}
+
+/**
+ * @name ext2_read_inode
+ *
+ * @brief Reads an inode from the inode table
+ */
+static int ext2_read_inode(EXT2_FS * fs, unsigned int ino, EXT2_INODE * out)
+{
+    unsigned int group;
+    unsigned int offset;
+
+    if ((ino == 0) || ((ino - 1U) / fs->inodes_per_group >= fs->groups))
+    {
+        return VFS_ERR_INVAL;
+    }
+    group = (ino - 1U) / fs->inodes_per_group;
+    offset = ((ino - 1U) % fs->inodes_per_group) * fs->inode_size;
+
+    if (ext2_read_block(fs, fs->gdt[group].bg_inode_table + (offset / fs->block_size),
+                        fs->scratch) != BLK_OK)
+    {
+        return VFS_ERR_IO;
+    }
+    memcpy(out, fs->scratch + (offset % fs->block_size), sizeof(*out));
+    return VFS_OK;
+}
+
+/**
+ * @name ext2_iget
+ *
+ * @brief Reads an inode and wraps it in a VFS inode
+ *
+ * @return VFS_OK, VFS_ERR_NOENT for a type we do not support, or the error
+ */
+static int ext2_iget(SUPER_BLOCK * sb, unsigned int ino, INODE ** out)
+{
+    EXT2_INODE *ei = kmalloc(sizeof(*ei));
+    INODE *inode;
+    unsigned int mode;
+    int ret;
+
+    if (ei == NULL)
+    {
+        return VFS_ERR_NOMEM;
+    }
+    /* Lookups run without the superblock lock, scratch needs it */
+    mutex_lock(&sb->lock);
+    ret = ext2_read_inode(sb->priv, ino, ei);
+    mutex_unlock(&sb->lock);
+    if (ret != VFS_OK)
+    {
+        kfree(ei);
+        return ret;
+    }
+
+    switch (ei->i_mode & EXT2_S_IFMT)
+    {
+    case EXT2_S_IFDIR:
+        mode = VFS_MODE_DIR;
+        break;
+    case EXT2_S_IFREG:
+        mode = VFS_MODE_FILE;
+        break;
+    default:
+        /* Symlinks and devices are not supported */
+        kfree(ei);
+        return VFS_ERR_NOENT;
+    }
+
+    inode = vfs_new_inode(sb, ino, mode, ei->i_size, &ext2_inode_ops);
+    if (inode == NULL)
+    {
+        kfree(ei);
+        return VFS_ERR_NOMEM;
+    }
+    inode->priv = ei;
+    *out = inode;
+    return VFS_OK;
+}
+
+/**
+ * @name ext2_lookup
+ *
+ * @brief VFS lookup: linear search of the directory's cached pages
+ */
+static int ext2_lookup(INODE * dir, const char * name, unsigned int len, INODE ** out)
+{
+    EXT2_DIR_ENTRY *de;
+    unsigned char *page;
+    unsigned int index;
+    unsigned int offset;
+    unsigned int end;
+
+    for (index = 0; (index << PAGE_SHIFT) < dir->size; index++)
+    {
+        page = vfs_get_page(dir, index);
+        if (page == NULL)
+        {
+            return VFS_ERR_IO;
+        }
+
+        end = dir->size - (index << PAGE_SHIFT);
+        if (end > PAGE_SIZE)
+        {
+            end = PAGE_SIZE;
+        }
+
+        for (offset = 0; offset + sizeof(*de) <= end; offset += de->rec_len)
+        {
+            de = (EXT2_DIR_ENTRY *) (page + offset);
+            if (de->rec_len < sizeof(*de))
+            {
+                /* Corrupt directory, don't loop forever */
+                return VFS_ERR_IO;
+            }
+            if ((de->inode != 0) && (de->name_len == len) &&
+                (memcmp(de->name, name, len) == 0))
+            {
+                return ext2_iget(dir->sb, de->inode, out);
+            }
+        }
+    }
+    return VFS_ERR_NOENT;
+}
+
+/**
+ * @name ext2_readpage
+ *
+ * @brief VFS readpage: one batch of merged block requests per page
+ */
+static int ext2_readpage(INODE * inode, unsigned int index, void * page)
+{
+    EXT2_FS *fs = inode->sb->priv;
+    BLK_REQUEST reqs[PAGE_SIZE / 1024U];
+    unsigned char *buf = page;
+    unsigned int blocks_per_page = PAGE_SIZE / fs->block_size;
+    unsigned int first = index * blocks_per_page;
+    unsigned int prev = EXT2_NO_BLOCK;
+    unsigned int block;
+    unsigned int nr = 0;
+    unsigned int i;
+
+    for (i = 0; i < blocks_per_page; i++)
+    {
+        block = EXT2_NO_BLOCK;
+        if ((first + i) * fs->block_size < inode->size)
+        {
+            block = ext2_bmap(fs, inode->priv, first + i);
+        }
+
+        if (block == EXT2_NO_BLOCK)
+        {
+            /* Hole or past the end of the file */
+            memset(buf + (i * fs->block_size), 0, fs->block_size);
+            prev = EXT2_NO_BLOCK;
+            continue;
+        }
+
+        if ((prev != EXT2_NO_BLOCK) && (block == prev + 1U))
+        {
+            /* Physically follows the previous block: grow that request */
+            reqs[nr - 1U].segs[0].len += fs->block_size;
+        }
+        else
+        {
+            memset(&reqs[nr], 0, sizeof(reqs[nr]));
+            reqs[nr].op = BLK_OP_READ;
+            reqs[nr].sector = (unsigned long long) block * fs->sectors_per_block;
+            reqs[nr].segs[0].buf = buf + (i * fs->block_size);
+            reqs[nr].segs[0].len = fs->block_size;
+            reqs[nr].nr_segs = 1;
+            nr++;
+        }
+        prev = block;
+    }
+
+    if ((nr != 0) && (blk_submit_wait(fs->dev, reqs, nr) != BLK_OK))
+    {
+        return VFS_ERR_IO;
+    }
+
+    /* The last block may run past the end of the file */
+    if (((index + 1U) << PAGE_SHIFT) > inode->size)
+    {
+        i = (inode->size > (index << PAGE_SHIFT)) ? (inode->size - (index << PAGE_SHIFT)) : 0;
+        memset(buf + i, 0, PAGE_SIZE - i);
+    }
+    return VFS_OK;
+}
+
+/**
+ * @name ext2_mount
+ *
+ * @brief VFS mount: reads the superblock and group descriptors
+ */
+static int ext2_mount(SUPER_BLOCK * sb, void * data)
+{
+    EXT2_SUPERBLOCK *es;
+    EXT2_FS *fs;
+    unsigned int gdt_size;
+    unsigned int i;
+    int ret = VFS_ERR_INVAL;
+
+    if (data == NULL)
+    {
+        return VFS_ERR_INVAL;
+    }
+
+    fs = kzalloc(sizeof(*fs));
+    es = kmalloc(EXT2_SUPERBLOCK_SIZE);
+    if ((fs == NULL) || (es == NULL))
+    {
+        kfree(fs);
+        kfree(es);
+        return VFS_ERR_NOMEM;
+    }
+    fs->dev = data;
+
+    if (blk_read(fs->dev, EXT2_SUPERBLOCK_OFFSET / BLK_SECTOR_SIZE, es,
+                 EXT2_SUPERBLOCK_SIZE) != BLK_OK)
+    {
+        ret = VFS_ERR_IO;
+        goto fail;
+    }
+
+    /* Blocks bigger than a page would not fit readpage() */
+    if ((es->s_magic != EXT2_SUPER_MAGIC) || (es->s_log_block_size > 2U) ||
+        (es->s_feature_incompat & ~EXT2_FEATURE_INCOMPAT_FILETYPE) ||
+        (es->s_inodes_per_group == 0) || (es->s_blocks_per_group == 0))
+    {
+        goto fail;
+    }
+
+    fs->block_size = 1024U << es->s_log_block_size;
+    fs->sectors_per_block = fs->block_size / BLK_SECTOR_SIZE;
+    fs->inodes_per_group = es->s_inodes_per_group;
+    fs->inode_size = (es->s_rev_level == 0) ? sizeof(EXT2_INODE) : es->s_inode_size;
+    fs->groups = (es->s_blocks_count - es->s_first_data_block + es->s_blocks_per_group - 1U) /
+                 es->s_blocks_per_group;
+
+    /* The group descriptors start in the block after the superblock */
+    gdt_size = ALIGN_UP(fs->groups * sizeof(EXT2_GROUP_DESC), fs->block_size);
+    fs->gdt = kmalloc(gdt_size);
+    fs->scratch = kmalloc(fs->block_size);
+    if ((fs->gdt == NULL) || (fs->scratch == NULL))
+    {
+        ret = VFS_ERR_NOMEM;
+        goto fail;
+    }
+    if (blk_read(fs->dev,
+                 (unsigned long long) (es->s_first_data_block + 1U) * fs->sectors_per_block,
+                 fs->gdt, gdt_size) != BLK_OK)
+    {
+        ret = VFS_ERR_IO;
+        goto fail;
+    }
+
+    for (i = 0; i < EXT2_IND_LEVELS; i++)
+    {
+        fs->ind_data[i] = kmalloc(fs->block_size);
+        if (fs->ind_data[i] == NULL)
+        {
+            ret = VFS_ERR_NOMEM;
+            goto fail;
+        }
+    }
+
+    sb->priv = fs;
+    ret = ext2_iget(sb, EXT2_ROOT_INO, &sb->root);
+    if ((ret == VFS_OK) && (sb->root->mode != VFS_MODE_DIR))
+    {
+        ret = VFS_ERR_IO;
+    }
+    if (ret != VFS_OK)
+    {
+        sb->root = NULL;
+        goto fail;
+    }
+
+    kfree(es);
+    return VFS_OK;
+
+fail:
+    for (i = 0; i < EXT2_IND_LEVELS; i++)
+    {
+        kfree(fs->ind_data[i]);
+    }
+    kfree(fs->gdt);
+    kfree(fs->scratch);
+    kfree(fs);
+    kfree(es);
+    sb->priv = NULL;
+    return ret;
+}
+
+void ext2_register_vfs(void)
+{
+    vfs_register_fs(&ext2_fs_type);
+}
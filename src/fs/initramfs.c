@@ -0,0 +1,373 @@
+/**
+ * @file initramfs.c
+ *
+ * @brief Implementation of the initial RAM filesystem
+ *
+ * @par The archive stays where GRUB loaded it. Lookups hash the path and walk
+ * a bucket chain threaded through the entry table itself, reads hand out
+ * pointers into the module, so neither mounting nor reading copies or
+ * allocates anything. File data is page aligned, so the VFS page cache holds
+ * the module's own pages too.
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "kstring.h"
+#include "kmalloc.h"
+#include "pmm.h"
+#include "vfs.h"
+#include "initramfs.h"
+
+/******************************************* Defines */
+/**
+ * File inode numbers are entry index + 1. A directory's is this bit plus
+ * the archive offset of the '/' ending it in the first path below it, 0 for
+ * the root: the two ranges cannot meet and no two directories share a '/'.
+ */
+#define INITRAMFS_DIR_INO_BIT       0x80000000U
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+/** Start of the mounted archive, NULL if none */
+static unsigned char *irfs_base;
+
+/** Entry table of the mounted archive */
+static INITRAMFS_ENTRY *irfs_entries;
+
+/** Number of entries */
+static unsigned int irfs_count;
+
+/** First entry of each hash bucket */
+static unsigned int irfs_buckets[INITRAMFS_HASH_BUCKETS];
+
+static int initramfs_vfs_lookup(INODE * dir, const char * name, unsigned int len,
+                                INODE ** out);
+static int initramfs_vfs_readpage(INODE * inode, unsigned int index, void * page);
+static void * initramfs_vfs_getpage(INODE * inode, unsigned int index);
+static int initramfs_vfs_mount(SUPER_BLOCK * sb, void * data);
+
+static const INODE_OPS initramfs_inode_ops =
+{
+    .lookup   = initramfs_vfs_lookup,
+    .readpage = initramfs_vfs_readpage,
+    .getpage  = initramfs_vfs_getpage,
+};
+
+static FS_TYPE initramfs_fs_type =
+{
+    .name  = "initramfs",
+    .mount = initramfs_vfs_mount,
+};
+
+/******************************************* Functions */
+int initramfs_mount(void * base, unsigned int size)
+{
+    INITRAMFS_HEADER *hdr = base;
+    INITRAMFS_ENTRY *entry;
+    unsigned int table_end;
+    unsigned int bucket;
+    unsigned int i;
+
+    irfs_base = NULL;
+    irfs_count = 0;
+
+    if ((size < sizeof(*hdr)) || (hdr->magic != INITRAMFS_MAGIC) ||
+        (hdr->version != INITRAMFS_VERSION) || (hdr->total_size > size) ||
+        (hdr->total_size & (INITRAMFS_DATA_ALIGN - 1U)) ||
+        (hdr->total_size & INITRAMFS_DIR_INO_BIT))
+    {
+        return INITRAMFS_ERR_FORMAT;
+    }
+
+    table_end = sizeof(*hdr) + (hdr->nr_entries * sizeof(INITRAMFS_ENTRY));
+    if ((hdr->nr_entries > (size / sizeof(INITRAMFS_ENTRY))) ||
+        (table_end > hdr->total_size))
+    {
+        return INITRAMFS_ERR_FORMAT;
+    }
+
+    for (i = 0; i < INITRAMFS_HASH_BUCKETS; i++)
+    {
+        irfs_buckets[i] = INITRAMFS_NO_ENTRY;
+    }
+
+    /* Push every entry on its bucket, the hashes were computed by mkinitrd */
+    entry = (INITRAMFS_ENTRY *) (hdr + 1);
+    for (i = 0; i < hdr->nr_entries; i++)
+    {
+        /* The name and its NUL lie inside the archive, checked without
+         * overflowing, and the paths are sorted for initramfs_find_dir() */
+        if ((entry[i].name_offset >= hdr->total_size) ||
+            (entry[i].name_len >= hdr->total_size - entry[i].name_offset) ||
+            (((unsigned char *) base)[entry[i].name_offset + entry[i].name_len] != '\0') ||
+            ((i != 0) && (strcmp((char *) base + entry[i - 1U].name_offset,
+                                 (char *) base + entry[i].name_offset) >= 0)) ||
+            (entry[i].data_offset + entry[i].data_len > hdr->total_size) ||
+            (entry[i].data_offset + entry[i].data_len < entry[i].data_offset) ||
+            (entry[i].data_offset & (INITRAMFS_DATA_ALIGN - 1U)))
+        {
+            return INITRAMFS_ERR_FORMAT;
+        }
+
+        bucket = entry[i].hash & (INITRAMFS_HASH_BUCKETS - 1U);
+        entry[i].next = irfs_buckets[bucket];
+        irfs_buckets[bucket] = i;
+    }
+
+    irfs_base = base;
+    irfs_entries = entry;
+    irfs_count = hdr->nr_entries;
+    return INITRAMFS_OK;
+}
+
+/**
+ * @name initramfs_find
+ *
+ * @brief Hash lookup of a path without leading '/'
+ *
+ * @return The entry index, or INITRAMFS_NO_ENTRY
+ */
+static unsigned int initramfs_find(const char * path, unsigned int path_len)
+{
+    INITRAMFS_ENTRY *entry;
+    unsigned int hash = initramfs_hash(path, path_len);
+    unsigned int idx;
+
+    for (idx = irfs_buckets[hash & (INITRAMFS_HASH_BUCKETS - 1U)];
+         idx != INITRAMFS_NO_ENTRY;
+         idx = entry->next)
+    {
+        entry = &irfs_entries[idx];
+
+        /* Full hash first, names are only compared on a real match */
+        if ((entry->hash == hash) && (entry->name_len == path_len) &&
+            (memcmp(irfs_base + entry->name_offset, path, path_len) == 0))
+        {
+            return idx;
+        }
+    }
+    return INITRAMFS_NO_ENTRY;
+}
+
+/**
+ * @name initramfs_find_dir
+ *
+ * @brief Binary search of the sorted paths for the first one starting with
+ * prefix, which ends in '/'
+ *
+ * @return The entry index, or INITRAMFS_NO_ENTRY if prefix is no directory
+ */
+static unsigned int initramfs_find_dir(const char * prefix, unsigned int prefix_len)
+{
+    unsigned int lo = 0;
+    unsigned int hi = irfs_count;
+    unsigned int mid;
+
+    /* First path not sorting before prefix */
+    while (lo < hi)
+    {
+        mid = lo + ((hi - lo) / 2U);
+        if (strcmp(initramfs_entry_name(mid), prefix) < 0)
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    if ((lo < irfs_count) && (strncmp(initramfs_entry_name(lo), prefix, prefix_len) == 0))
+    {
+        return lo;
+    }
+    return INITRAMFS_NO_ENTRY;
+}
+
+int initramfs_lookup(const char * path, const void ** data, unsigned int * len)
+{
+    unsigned int idx;
+
+    if (irfs_base == NULL)
+    {
+        return INITRAMFS_ERR_NOENT;
+    }
+
+    while (*path == '/')
+    {
+        path++;
+    }
+    idx = initramfs_find(path, strlen(path));
+    if (idx == INITRAMFS_NO_ENTRY)
+    {
+        return INITRAMFS_ERR_NOENT;
+    }
+    *data = irfs_base + irfs_entries[idx].data_offset;
+    *len = irfs_entries[idx].data_len;
+    return INITRAMFS_OK;
+}
+
+unsigned int initramfs_entry_count(void)
+{
+    return irfs_count;
+}
+
+const char * initramfs_entry_name(unsigned int idx)
+{
+    if (idx >= irfs_count)
+    {
+        return NULL;
+    }
+    return (const char *) irfs_base + irfs_entries[idx].name_offset;
+}
+
+/**
+ * @name initramfs_vfs_lookup
+ *
+ * @brief VFS lookup: a file if the path is in the archive, a directory if
+ * some path starts with it, both found without a scan of the entries
+ *
+ * @par A directory inode's priv is its path prefix ("" or "etc/"), a file
+ * inode's priv points at its data inside the module.
+ */
+static int initramfs_vfs_lookup(INODE * dir, const char * name, unsigned int len,
+                                INODE ** out)
+{
+    const char *prefix = dir->priv;
+    unsigned int prefix_len = strlen(prefix);
+    INITRAMFS_ENTRY *entry;
+    INODE *inode = NULL;
+    char *path;
+    unsigned int idx;
+    int ret;
+
+    /* Room for prefix + name + '/' + NUL */
+    path = kmalloc(prefix_len + len + 2U);
+    if (path == NULL)
+    {
+        return VFS_ERR_NOMEM;
+    }
+    memcpy(path, prefix, prefix_len);
+    memcpy(path + prefix_len, name, len);
+    path[prefix_len + len] = '\0';
+
+    idx = initramfs_find(path, prefix_len + len);
+    if (idx != INITRAMFS_NO_ENTRY)
+    {
+        entry = &irfs_entries[idx];
+        inode = vfs_new_inode(dir->sb, idx + 1U, VFS_MODE_FILE, entry->data_len,
+                              &initramfs_inode_ops);
+        kfree(path);
+        if (inode == NULL)
+        {
+            return VFS_ERR_NOMEM;
+        }
+        inode->priv = irfs_base + entry->data_offset;
+        *out = inode;
+        return VFS_OK;
+    }
+
+    /* Not a file, is it a directory prefix of one? */
+    path[prefix_len + len] = '/';
+    path[prefix_len + len + 1U] = '\0';
+    ret = VFS_ERR_NOENT;
+    idx = initramfs_find_dir(path, prefix_len + len + 1U);
+    if (idx != INITRAMFS_NO_ENTRY)
+    {
+        inode = vfs_new_inode(dir->sb,
+                              INITRAMFS_DIR_INO_BIT |
+                              (irfs_entries[idx].name_offset + prefix_len + len),
+                              VFS_MODE_DIR, 0, &initramfs_inode_ops);
+        ret = (inode != NULL) ? VFS_OK : VFS_ERR_NOMEM;
+    }
+
+    if (inode != NULL)
+    {
+        /* The directory keeps the path as its prefix */
+        inode->priv = path;
+        *out = inode;
+    }
+    else
+    {
+        kfree(path);
+    }
+    return ret;
+}
+
+/**
+ * @name initramfs_vfs_readpage
+ *
+ * @brief VFS readpage: copies from the module, zero fills past the end
+ *
+ * @note Only used when getpage cannot hand out the module page itself.
+ */
+static int initramfs_vfs_readpage(INODE * inode, unsigned int index, void * page)
+{
+    unsigned int offset = index << PAGE_SHIFT;
+    unsigned int len = 0;
+
+    if ((inode->mode != VFS_MODE_FILE) || (offset >= inode->size))
+    {
+        memset(page, 0, PAGE_SIZE);
+        return VFS_OK;
+    }
+
+    len = inode->size - offset;
+    if (len > PAGE_SIZE)
+    {
+        len = PAGE_SIZE;
+    }
+    memcpy(page, (const unsigned char *) inode->priv + offset, len);
+    memset((unsigned char *) page + len, 0, PAGE_SIZE - len);
+    return VFS_OK;
+}
+
+/**
+ * @name initramfs_vfs_getpage
+ *
+ * @brief VFS getpage: the module page holding the data, mkinitrd aligned it
+ * and zeroed the rest of the last page
+ *
+ * @return The page, NULL past the end of the file or if GRUB did not load
+ * the module on a page boundary
+ */
+static void * initramfs_vfs_getpage(INODE * inode, unsigned int index)
+{
+    unsigned int offset = index << PAGE_SHIFT;
+
+    if ((inode->mode != VFS_MODE_FILE) || (offset >= inode->size) ||
+        ((unsigned int) irfs_base & ~PAGE_MASK))
+    {
+        return NULL;
+    }
+    return (unsigned char *) inode->priv + offset;
+}
+
+/**
+ * @name initramfs_vfs_mount
+ *
+ * @brief VFS mount: the root directory has the empty prefix
+ */
+static int initramfs_vfs_mount(SUPER_BLOCK * sb, void * data)
+{
+    (void) data;
+
+    if (irfs_base == NULL)
+    {
+        return VFS_ERR_NOENT;
+    }
+    sb->root = vfs_new_inode(sb, INITRAMFS_DIR_INO_BIT, VFS_MODE_DIR, 0,
+                             &initramfs_inode_ops);
+    if (sb->root == NULL)
+    {
+        return VFS_ERR_NOMEM;
+    }
+    sb->root->priv = (void *) "";
+    return VFS_OK;
+}
+
+void initramfs_register_vfs(void)
+{
+    vfs_register_fs(&initramfs_fs_type);
+}
@@ -0,0 +1,566 @@
+/**
+ * @file vfs.c
+ *
+ * @brief Implementation of the virtual filesystem layer
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "kstring.h"
+#include "kmalloc.h"
+#include "pmm.h"
+#include "paging.h"
+#include "radix_tree.h"
+#include "vfs.h"
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+/** Registered filesystem types */
+static FS_TYPE *vfs_types;
+
+/** The "/" dentry, filesystems are mounted on it */
+static DENTRY *vfs_root;
+
+/** Dentry hash table */
+static DENTRY *vfs_dcache[VFS_DCACHE_BUCKETS];
+
+static VFS_STATS vfs_stats;
+
+/** Held from a dentry cache miss until the new dentry is in the cache */
+static MUTEX vfs_dcache_lock = MUTEX_INIT;
+
+/******************************************* Functions */
+
+/**
+ * @name vfs_dentry_hash
+ *
+ * @brief Hashes a name together with its parent (FNV-1a, then mixed)
+ */
+static unsigned int vfs_dentry_hash(const DENTRY * parent, const char * name, unsigned int len)
+{
+    unsigned int hash = 2166136261U;
+    unsigned int i;
+
+    for (i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char) name[i];
+        hash *= 16777619U;
+    }
+    return hash ^ (((unsigned int) parent >> 4) * 0x9E3779B1U);
+}
+
+/**
+ * @name vfs_d_lookup
+ *
+ * @brief Finds a cached child dentry
+ */
+static DENTRY * vfs_d_lookup(const DENTRY * parent, const char * name, unsigned int len,
+                             unsigned int hash)
+{
+    DENTRY *d;
+
+    for (d = vfs_dcache[hash & (VFS_DCACHE_BUCKETS - 1U)]; d != NULL; d = d->hash_next)
+    {
+        if ((d->hash == hash) && (d->parent == parent) && (d->name_len == len) &&
+            (memcmp(d->name, name, len) == 0))
+        {
+            return d;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @name vfs_d_new
+ *
+ * @brief Creates a dentry that is not in the hash table
+ */
+static DENTRY * vfs_d_new(DENTRY * parent, const char * name, unsigned int len,
+                          unsigned int hash, INODE * inode)
+{
+    DENTRY *d = kmalloc(sizeof(*d) + len + 1U);
+
+    if (d == NULL)
+    {
+        return NULL;
+    }
+    d->hash_next = NULL;
+    d->parent = parent;
+    d->mounted = NULL;
+    d->inode = inode;
+    d->hash = hash;
+    d->name_len = len;
+    memcpy(d->name, name, len);
+    d->name[len] = '\0';
+    return d;
+}
+
+/**
+ * @name vfs_d_alloc
+ *
+ * @brief Creates a dentry and adds it to the hash table
+ *
+ * @param inode The inode, NULL for a negative dentry
+ */
+static DENTRY * vfs_d_alloc(DENTRY * parent, const char * name, unsigned int len,
+                            unsigned int hash, INODE * inode)
+{
+    DENTRY *d = vfs_d_new(parent, name, len, hash, inode);
+    unsigned int bucket = hash & (VFS_DCACHE_BUCKETS - 1U);
+
+    if (d == NULL)
+    {
+        return NULL;
+    }
+    d->hash_next = vfs_dcache[bucket];
+    vfs_dcache[bucket] = d;
+
+    vfs_stats.dcache_entries++;
+    if (inode == NULL)
+    {
+        vfs_stats.dcache_negative++;
+    }
+    return d;
+}
+
+/**
+ * @name vfs_follow_mounts
+ *
+ * @brief Steps from a mount point to the root of what is mounted on it
+ */
+static DENTRY * vfs_follow_mounts(DENTRY * d)
+{
+    while (d->mounted != NULL)
+    {
+        d = d->mounted;
+    }
+    return d;
+}
+
+/**
+ * @name vfs_d_miss
+ *
+ * @brief Asks the filesystem for a name the dentry cache missed and caches
+ * the answer
+ *
+ * @par The lookup may sleep on block reads; the lock keeps a second walker
+ * from adding the same name meanwhile, it finds ours instead.
+ */
+static int vfs_d_miss(DENTRY * parent, const char * name, unsigned int len,
+                      unsigned int hash, DENTRY ** out)
+{
+    DENTRY *child;
+    INODE *inode = NULL;
+    int ret = VFS_OK;
+
+    mutex_lock(&vfs_dcache_lock);
+    child = vfs_d_lookup(parent, name, len, hash);
+    if (child == NULL)
+    {
+        vfs_stats.dcache_misses++;
+        ret = parent->inode->ops->lookup(parent->inode, name, len, &inode);
+        if ((ret == VFS_ERR_NOENT) && (vfs_stats.dcache_negative < VFS_DCACHE_MAX_NEGATIVE))
+        {
+            /* Only a real miss is remembered, not a failed read, and
+             * beyond the limit it is just reported */
+            inode = NULL;
+            ret = VFS_OK;
+        }
+        if (ret == VFS_OK)
+        {
+            child = vfs_d_alloc(parent, name, len, hash, inode);
+            if (child == NULL)
+            {
+                ret = VFS_ERR_NOMEM;
+            }
+        }
+    }
+    mutex_unlock(&vfs_dcache_lock);
+
+    *out = child;
+    return ret;
+}
+
+/**
+ * @name vfs_walk
+ *
+ * @brief Resolves an absolute path to a dentry
+ *
+ * @param path  The path
+ * @param out   Set to the dentry, which may be negative
+ * @return      VFS_OK, or an error for the intermediate components
+ */
+static int vfs_walk(const char * path, DENTRY ** out)
+{
+    DENTRY *d = vfs_follow_mounts(vfs_root);
+    DENTRY *child;
+    const char *name;
+    unsigned int len;
+    unsigned int hash;
+    int ret;
+
+    if (*path != '/')
+    {
+        return VFS_ERR_INVAL;
+    }
+
+    for (;;)
+    {
+        while (*path == '/')
+        {
+            path++;
+        }
+        if (*path == '\0')
+        {
+            break;
+        }
+
+        name = path;
+        while ((*path != '/') && (*path != '\0'))
+        {
+            path++;
+        }
+        len = path - name;
+
+        if (d->inode == NULL)
+        {
+            return VFS_ERR_NOENT;
+        }
+        if (d->inode->mode != VFS_MODE_DIR)
+        {
+            return VFS_ERR_NOTDIR;
+        }
+
+        if ((len == 1U) && (name[0] == '.'))
+        {
+            continue;
+        }
+        if ((len == 2U) && (name[0] == '.') && (name[1] == '.'))
+        {
+            if (d->parent != NULL)
+            {
+                d = vfs_follow_mounts(d->parent);
+            }
+            continue;
+        }
+
+        hash = vfs_dentry_hash(d, name, len);
+        child = vfs_d_lookup(d, name, len, hash);
+        if (child != NULL)
+        {
+            vfs_stats.dcache_hits++;
+            if (child->inode == NULL)
+            {
+                vfs_stats.dcache_neg_hits++;
+            }
+        }
+        else
+        {
+            ret = vfs_d_miss(d, name, len, hash, &child);
+            if (ret != VFS_OK)
+            {
+                return ret;
+            }
+        }
+        d = vfs_follow_mounts(child);
+    }
+
+    *out = d;
+    return VFS_OK;
+}
+
+void vfs_init(void)
+{
+    /* The root itself is no cache entry that a lookup can hit */
+    vfs_root = vfs_d_new(NULL, "/", 1, vfs_dentry_hash(NULL, "/", 1), NULL);
+}
+
+void vfs_register_fs(FS_TYPE * type)
+{
+    type->next = vfs_types;
+    vfs_types = type;
+}
+
+int vfs_mount(const char * path, const char * fs_name, void * data)
+{
+    FS_TYPE *type;
+    SUPER_BLOCK *sb;
+    DENTRY *mountpoint;
+    DENTRY *root;
+    int ret;
+
+    for (type = vfs_types; type != NULL; type = type->next)
+    {
+        if (strcmp(type->name, fs_name) == 0)
+        {
+            break;
+        }
+    }
+    if (type == NULL)
+    {
+        return VFS_ERR_NOFS;
+    }
+
+    ret = vfs_walk(path, &mountpoint);
+    if (ret != VFS_OK)
+    {
+        return ret;
+    }
+
+    /* The new root hangs off the mount point, which may be a negative entry.
+     * Lookups reach it through mounted only, so it stays out of the hash
+     * table, and it is allocated first so a failure leaves nothing mounted */
+    root = vfs_d_new(mountpoint->parent, mountpoint->name, mountpoint->name_len,
+                     mountpoint->hash, NULL);
+    sb = kzalloc(sizeof(*sb));
+    if ((root == NULL) || (sb == NULL))
+    {
+        kfree(root);
+        kfree(sb);
+        return VFS_ERR_NOMEM;
+    }
+    sb->type = type;
+    mutex_init(&sb->lock);
+    ret = type->mount(sb, data);
+    if (ret != VFS_OK)
+    {
+        kfree(root);
+        kfree(sb);
+        return ret;
+    }
+
+    root->inode = sb->root;
+    mountpoint->mounted = root;
+    return VFS_OK;
+}
+
+INODE * vfs_new_inode(SUPER_BLOCK * sb, unsigned int ino, unsigned int mode,
+                      unsigned int size, const INODE_OPS * ops)
+{
+    INODE *inode = kzalloc(sizeof(*inode));
+
+    if (inode != NULL)
+    {
+        inode->sb = sb;
+        inode->ino = ino;
+        inode->mode = mode;
+        inode->size = size;
+        inode->ops = ops;
+    }
+    return inode;
+}
+
+/**
+ * @name vfs_fill_page
+ *
+ * @brief Brings page index of inode into the page cache
+ *
+ * @note Called with the superblock lock held.
+ */
+static void * vfs_fill_page(INODE * inode, unsigned int index)
+{
+    void *page = NULL;
+
+    vfs_stats.page_misses++;
+    if (inode->ops->getpage != NULL)
+    {
+        page = inode->ops->getpage(inode, index);
+    }
+    if (page != NULL)
+    {
+        /* The filesystem's own memory, cached without a copy */
+        if (radix_tree_insert(&inode->pages, index, page) != RADIX_TREE_OK)
+        {
+            return NULL;
+        }
+    }
+    else
+    {
+        page = pmm_alloc_page();
+        if (page == NULL)
+        {
+            return NULL;
+        }
+        if ((inode->ops->readpage(inode, index, page) != VFS_OK) ||
+            (radix_tree_insert(&inode->pages, index, page) != RADIX_TREE_OK))
+        {
+            pmm_free_page(page);
+            return NULL;
+        }
+    }
+
+    inode->nr_pages++;
+    vfs_stats.page_cached++;
+    return page;
+}
+
+void * vfs_get_page(INODE * inode, unsigned int index)
+{
+    void *page = radix_tree_lookup(&inode->pages, index);
+
+    if (page != NULL)
+    {
+        vfs_stats.page_hits++;
+        return page;
+    }
+
+    mutex_lock(&inode->sb->lock);
+    /* Someone else may have read it while we waited for the lock */
+    page = radix_tree_lookup(&inode->pages, index);
+    if (page != NULL)
+    {
+        vfs_stats.page_hits++;
+    }
+    else
+    {
+        page = vfs_fill_page(inode, index);
+    }
+    mutex_unlock(&inode->sb->lock);
+    return page;
+}
+
+VFS_FILE * vfs_open(const char * path, int * err)
+{
+    VFS_FILE *file;
+    DENTRY *d;
+    int ret;
+
+    ret = vfs_walk(path, &d);
+    if ((ret == VFS_OK) && (d->inode == NULL))
+    {
+        ret = VFS_ERR_NOENT;
+    }
+    if ((ret == VFS_OK) && (d->inode->mode != VFS_MODE_FILE))
+    {
+        ret = VFS_ERR_ISDIR;
+    }
+
+    file = NULL;
+    if (ret == VFS_OK)
+    {
+        file = kmalloc(sizeof(*file));
+        if (file == NULL)
+        {
+            ret = VFS_ERR_NOMEM;
+        }
+        else
+        {
+            file->inode = d->inode;
+            file->pos = 0;
+        }
+    }
+
+    if (err != NULL)
+    {
+        *err = ret;
+    }
+    return file;
+}
+
+int vfs_read(VFS_FILE * file, void * buf, unsigned int len)
+{
+    INODE *inode = file->inode;
+    unsigned char *out = buf;
+    unsigned char *page;
+    unsigned int offset;
+    unsigned int chunk;
+    unsigned int done = 0;
+
+    if (file->pos >= inode->size)
+    {
+        return 0;
+    }
+    if (len > inode->size - file->pos)
+    {
+        len = inode->size - file->pos;
+    }
+
+    while (done < len)
+    {
+        page = vfs_get_page(inode, file->pos >> PAGE_SHIFT);
+        if (page == NULL)
+        {
+            return (done != 0) ? (int) done : VFS_ERR_IO;
+        }
+
+        offset = file->pos & ~PAGE_MASK;
+        chunk = PAGE_SIZE - offset;
+        if (chunk > len - done)
+        {
+            chunk = len - done;
+        }
+        memcpy(out + done, page + offset, chunk);
+        done += chunk;
+        file->pos += chunk;
+    }
+    return (int) done;
+}
+
+void vfs_seek(VFS_FILE * file, unsigned int pos)
+{
+    file->pos = pos;
+}
+
+void vfs_close(VFS_FILE * file)
+{
+    kfree(file);
+}
+
+void * vfs_mmap(VFS_FILE * file, unsigned int offset, unsigned int len)
+{
+    INODE *inode = file->inode;
+    unsigned int pages = ALIGN_UP(len, PAGE_SIZE) >> PAGE_SHIFT;
+    unsigned int virt;
+    unsigned int i;
+    void *page;
+
+    if ((offset & ~PAGE_MASK) || (len == 0) || (offset >= inode->size) ||
+        (len > ALIGN_UP(inode->size, PAGE_SIZE) - offset))
+    {
+        return NULL;
+    }
+
+    virt = paging_alloc_virt(pages);
+    if (virt == 0)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < pages; i++)
+    {
+        page = vfs_get_page(inode, (offset >> PAGE_SHIFT) + i);
+
+        /* Read-only: CR0.WP makes the cache safe from stray kernel writes */
+        if ((page == NULL) ||
+            (paging_map_page(virt + (i << PAGE_SHIFT), (unsigned int) page, 0) != PAGING_OK))
+        {
+            vfs_munmap((void *) virt, i << PAGE_SHIFT);
+            paging_free_virt(virt + (i << PAGE_SHIFT), pages - i);
+            return NULL;
+        }
+        vfs_stats.mmap_pages++;
+    }
+    return (void *) virt;
+}
+
+void vfs_munmap(void * addr, unsigned int len)
+{
+    unsigned int virt = (unsigned int) addr;
+    unsigned int pages = ALIGN_UP(len, PAGE_SIZE) >> PAGE_SHIFT;
+    unsigned int i;
+
+    for (i = 0; i < pages; i++)
+    {
+        paging_unmap_page(virt + (i << PAGE_SHIFT));
+    }
+    paging_free_virt(virt, pages);
+    vfs_stats.mmap_pages -= pages;
+}
+
+const VFS_STATS * vfs_get_stats(void)
+{
+    return &vfs_stats;
+}
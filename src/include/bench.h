@@ -0,0 +1,98 @@
+/**
+ * @file bench.h
+ *
+ * @brief Header file for the in-kernel benchmarks
+ *
+ * @par Benchmarks report over COM1 with @ref kprintf.
+ */
+#ifndef INCLUDE_BENCH_H
+#define INCLUDE_BENCH_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name bench_blk_qd_sweep
+ *
+ * @brief Random 4 KiB reads on the virtio disk at queue depth 1 to 32
+ *
+ * @par For each depth prints IOPS, throughput and the average, minimum and
+ * maximum submit-to-completion latency.
+ */
+void bench_blk_qd_sweep(void);
+
+/**
+ * @name bench_vfs_read
+ *
+ * @brief Reads a file with a cold and a warm page cache
+ *
+ * @par Compares read(), an mmap() scan and a plain memcpy of the same size,
+ * times cold and warm path walks and prints the dentry and page cache hit
+ * counters.
+ */
+void bench_vfs_read(void);
+
+/**
+ * @name bench_fb_console
+ *
+ * @brief Times glyph rendering, flushes and scrolling of the graphics console
+ *
+ * @par Prints cycles per glyph, per full screen flush with the framebuffer
+ * bandwidth, and per scroll. Does nothing in VGA text mode.
+ */
+void bench_fb_console(void);
+
+/**
+ * @name bench_defer
+ *
+ * @brief Measures deferred work: workqueue round trips and serial output
+ * through the softirq refilled ring
+ *
+ * @par Prints the cost of queueing a work item, the latency until the
+ * worker ran it and the deepest queue, then the cycles a writer spends on
+ * 1 KiB of serial output polled against queued in the ring.
+ */
+void bench_defer(void);
+
+/**
+ * @name bench_ipc
+ *
+ * @brief Streams messages of 16 B to 64 KiB between two threads over a
+ * channel
+ *
+ * @par For each size prints throughput and send-to-receive latency, copying
+ * in and out of the ring against building messages in place (granting pages
+ * above the slot size).
+ */
+void bench_ipc(void);
+
+/**
+ * @name bench_trace
+ *
+ * @brief Cycles per call of a leaf function without an entry pad, with the
+ * pad disabled and with the function traced
+ */
+void bench_trace(void);
+
+/**
+ * @name bench_lock
+ *
+ * @brief Threads contending for a lock held across a sleeping serial flush,
+ * spinning on trylock against sleeping in mutex_lock()
+ *
+ * @par Prints the on-CPU cycles spent acquiring per lock and the total time.
+ */
+void bench_lock(void);
+
+/**
+ * @name bench_rcu
+ *
+ * @brief Cycles per lookup of a table a writer keeps updating, for 1 to 4
+ * reader threads under RCU, a mutex and with interrupts disabled
+ */
+void bench_rcu(void);
+
+#endif /* INCLUDE_BENCH_H */
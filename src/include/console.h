@@ -0,0 +1,81 @@
+/**
+ * @file console.h
+ *
+ * @brief Header file for the kernel console (screen and COM1)
+ *
+ * @par Console output fans out to a list of sinks, the screen and COM1 to
+ * begin with. Writers walk the list under RCU (rcu.h), so printing takes no
+ * lock; registering and unregistering are serialised by a mutex and
+ * unregistering waits for a grace period before the sink may be reused.
+ * Sink write functions run inside an RCU reader and must not sleep.
+ */
+#ifndef INCLUDE_CONSOLE_H
+#define INCLUDE_CONSOLE_H
+/******************************************* Includes */
+#include "fb.h"
+
+/******************************************* Defines */
+/** Colours used for console text on the screen */
+#define CONSOLE_FG_COLOR        FB_LIGHT_GREY
+#define CONSOLE_BG_COLOR        FB_BLACK
+
+/* CONSOLE_SINK flags */
+#define CONSOLE_SINK_SERIAL     0x1U    /**< Also gets console_write_serial() output */
+
+/* Return codes */
+#define CONSOLE_OK              0
+#define CONSOLE_ERR_BUSY        (-1)    /**< Already registered */
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct CONSOLE_SINK
+ * @brief A destination of console output
+ */
+typedef struct _CONSOLE_SINK
+{
+    const char             *name;
+    void                  (*write)(const char * buf, unsigned int len);
+    unsigned int            flags;    /**< CONSOLE_SINK_* */
+    struct _CONSOLE_SINK   *next;     /**< RCU protected list link */
+} CONSOLE_SINK;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name console_write
+ *
+ * @brief Writes text to every sink, the screen and COM1
+ *
+ * @par "\n" is sent to the serial port as "\r\n" so terminals return to the
+ * first column, "\b" erases the previous character on the screen.
+ *
+ * @param buf Text to write
+ * @param len Number of characters
+ */
+void console_write(const char * buf, unsigned int len);
+
+/**
+ * @name console_write_serial
+ *
+ * @brief Like @ref console_write, but to the CONSOLE_SINK_SERIAL sinks only
+ */
+void console_write_serial(const char * buf, unsigned int len);
+
+/**
+ * @name console_register
+ *
+ * @brief Adds a sink at the end of the list
+ *
+ * @return CONSOLE_OK or CONSOLE_ERR_BUSY
+ */
+int console_register(CONSOLE_SINK * sink);
+
+/**
+ * @name console_unregister
+ *
+ * @brief Removes a sink, sleeping until no writer uses it any more
+ */
+void console_unregister(CONSOLE_SINK * sink);
+
+#endif /* INCLUDE_CONSOLE_H */
@@ -0,0 +1,290 @@
+/**
+ * @file cpu.h
+ *
+ * @brief Header file for small x86 CPU helpers (TSC, barriers, 64-bit math)
+ */
+#ifndef INCLUDE_CPU_H
+#define INCLUDE_CPU_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** Interrupt enable flag in EFLAGS */
+#define EFLAGS_IF               0x200U
+
+/* CPUID leaf 1 EDX feature bits */
+#define CPUID_EDX_PAT           (1U << 16)  /**< Page attribute table */
+#define CPUID_EDX_FXSR          (1U << 24)  /**< fxsave / fxrstor */
+#define CPUID_EDX_SSE           (1U << 25)
+#define CPUID_EDX_SSE2          (1U << 26)
+
+/**
+ * Number of CPUs per-CPU data is sized for. The kernel only brings up the
+ * boot CPU so far, per-CPU structures are indexed by @ref cpu_id already.
+ */
+#define CPU_MAX                 1U
+
+/** Line size data shared between CPUs is padded to */
+#define CACHE_LINE_SIZE         64U
+
+/******************************************* Macros */
+
+/**
+ * @name Compiler barrier
+ *
+ * @brief Stops the compiler from reordering memory accesses across it
+ */
+#define barrier() asm volatile ("" ::: "memory")
+
+/**
+ * @name Memory barriers
+ *
+ * @par x86 only reorders a store with a later load, so the write barrier and
+ * read barrier only have to stop the compiler. The full barrier uses a locked
+ * add on the stack, which is cheaper than mfence on most cores.
+ */
+#define mb()  asm volatile ("lock; addl $0, 0(%%esp)" ::: "memory")
+#define wmb() barrier()
+#define rmb() barrier()
+
+/******************************************* Protoytes */
+
+/**
+ * @name rdtsc
+ *
+ * @brief Reads the time stamp counter
+ *
+ * @return The 64 bit cycle counter
+ */
+static inline unsigned long long rdtsc(void)
+{
+    unsigned int lo, hi;
+
+    asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((unsigned long long) hi << 32) | lo;
+}
+
+/**
+ * @name cpuid
+ *
+ * @brief Executes cpuid for a leaf (sub-leaf 0)
+ */
+static inline void cpuid(unsigned int leaf, unsigned int * eax, unsigned int * ebx,
+                         unsigned int * ecx, unsigned int * edx)
+{
+    asm volatile ("cpuid"
+                  : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+                  : "a" (leaf), "c" (0));
+}
+
+/**
+ * @name cpuid_edx
+ *
+ * @brief Returns the leaf 1 EDX feature bits (CPUID_EDX_*)
+ */
+static inline unsigned int cpuid_edx(void)
+{
+    unsigned int a, b, c, d;
+
+    cpuid(1, &a, &b, &c, &d);
+    return d;
+}
+
+/**
+ * @name rdmsr / wrmsr
+ *
+ * @brief Reads or writes a model specific register
+ */
+static inline unsigned long long rdmsr(unsigned int msr)
+{
+    unsigned int lo, hi;
+
+    asm volatile ("rdmsr" : "=a" (lo), "=d" (hi) : "c" (msr));
+    return ((unsigned long long) hi << 32) | lo;
+}
+
+static inline void wrmsr(unsigned int msr, unsigned long long val)
+{
+    asm volatile ("wrmsr" :: "c" (msr), "a" ((unsigned int) val),
+                  "d" ((unsigned int) (val >> 32)) : "memory");
+}
+
+/**
+ * @name cpu_relax
+ *
+ * @brief Hint to the CPU that we are inside a spin-wait loop
+ */
+static inline void cpu_relax(void)
+{
+    asm volatile ("pause" ::: "memory");
+}
+
+/**
+ * @name local_irq_disable / local_irq_enable
+ *
+ * @brief Masks or unmasks interrupts on this CPU
+ */
+static inline void local_irq_disable(void)
+{
+    asm volatile ("cli" ::: "memory");
+}
+
+static inline void local_irq_enable(void)
+{
+    asm volatile ("sti" ::: "memory");
+}
+
+/**
+ * @name local_irq_save
+ *
+ * @brief Disables interrupts and returns the previous EFLAGS
+ */
+static inline unsigned int local_irq_save(void)
+{
+    unsigned int flags;
+
+    asm volatile ("pushfl; popl %0; cli" : "=r" (flags) :: "memory");
+    return flags;
+}
+
+/**
+ * @name local_irq_restore
+ *
+ * @brief Restores the interrupt flag saved by @ref local_irq_save
+ */
+static inline void local_irq_restore(unsigned int flags)
+{
+    asm volatile ("pushl %0; popfl" :: "g" (flags) : "memory", "cc");
+}
+
+/**
+ * @name irqs_disabled
+ *
+ * @brief Returns 1 if interrupts are masked on this CPU
+ */
+static inline int irqs_disabled(void)
+{
+    unsigned int flags;
+
+    asm volatile ("pushfl; popl %0" : "=r" (flags) :: "memory");
+    return !(flags & EFLAGS_IF);
+}
+
+/**
+ * @name cpu_idle
+ *
+ * @brief Enables interrupts and halts until the next one
+ *
+ * @note sti only takes effect after the following instruction, so an
+ * interrupt cannot slip in between the two and be missed by hlt.
+ */
+static inline void cpu_idle(void)
+{
+    asm volatile ("sti; hlt" ::: "memory");
+}
+
+/**
+ * @name cpu_id
+ *
+ * @brief Index of the CPU we run on, for per-CPU data
+ */
+static inline unsigned int cpu_id(void)
+{
+    return 0;
+}
+
+/**
+ * @name xchg
+ *
+ * @brief Atomically stores a value and returns the previous one
+ *
+ * @note xchg with a memory operand is always locked.
+ */
+static inline unsigned int xchg(volatile unsigned int * p, unsigned int val)
+{
+    asm volatile ("xchgl %0, %1" : "+r" (val), "+m" (*p) :: "memory");
+    return val;
+}
+
+static inline void * xchg_ptr(void * volatile * p, void * val)
+{
+    asm volatile ("xchgl %0, %1" : "+r" (val), "+m" (*p) :: "memory");
+    return val;
+}
+
+/**
+ * @name cmpxchg / cmpxchg_ptr
+ *
+ * @brief Stores val if *p still holds old
+ *
+ * @return The value *p held, equal to old on success
+ */
+static inline unsigned int cmpxchg(volatile unsigned int * p, unsigned int old,
+                                   unsigned int val)
+{
+    unsigned int prev;
+
+    asm volatile ("lock; cmpxchgl %2, %1"
+                  : "=a" (prev), "+m" (*p) : "r" (val), "0" (old) : "memory");
+    return prev;
+}
+
+static inline void * cmpxchg_ptr(void * volatile * p, void * old, void * val)
+{
+    void *prev;
+
+    asm volatile ("lock; cmpxchgl %2, %1"
+                  : "=a" (prev), "+m" (*p) : "r" (val), "0" (old) : "memory");
+    return prev;
+}
+
+/**
+ * @name atomic_or / atomic_add
+ *
+ * @brief Locked read-modify-write, safe against interrupts and other CPUs
+ */
+static inline void atomic_or(volatile unsigned int * p, unsigned int val)
+{
+    asm volatile ("lock; orl %1, %0" : "+m" (*p) : "r" (val) : "memory");
+}
+
+/** @return The new value */
+static inline unsigned int atomic_add(volatile unsigned int * p, unsigned int val)
+{
+    unsigned int old = val;
+
+    asm volatile ("lock; xaddl %0, %1" : "+r" (old), "+m" (*p) :: "memory");
+    return old + val;
+}
+
+/**
+ * @name div_u64_rem
+ *
+ * @brief Divides a 64 bit value by a 32 bit value
+ *
+ * @note The kernel is linked without libgcc, so plain 64 bit division
+ * (__udivdi3) is not available. This does it with two divl instructions.
+ *
+ * @param n   The dividend
+ * @param d   The divisor (must not be 0)
+ * @param rem Where to store the remainder (may be NULL)
+ * @return    The quotient
+ */
+static inline unsigned long long div_u64_rem(unsigned long long n, unsigned int d,
+                                             unsigned int *rem)
+{
+    unsigned int hi = (unsigned int) (n >> 32);
+    unsigned int lo = (unsigned int) n;
+    unsigned int q_hi = hi / d;
+    unsigned int q_lo;
+    unsigned int r;
+
+    hi = hi % d;
+    asm ("divl %4" : "=a" (q_lo), "=d" (r) : "a" (lo), "d" (hi), "rm" (d));
+    if (rem)
+    {
+        *rem = r;
+    }
+    return ((unsigned long long) q_hi << 32) | q_lo;
+}
+
+#endif /* INCLUDE_CPU_H */
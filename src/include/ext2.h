@@ -0,0 +1,140 @@
+/**
+ * @file ext2.h
+ *
+ * @brief Header file for the read-only ext2 filesystem
+ */
+#ifndef INCLUDE_EXT2_H
+#define INCLUDE_EXT2_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+#define EXT2_SUPER_MAGIC            0xEF53U
+/** The superblock always starts 1024 bytes into the device */
+#define EXT2_SUPERBLOCK_OFFSET      1024U
+#define EXT2_SUPERBLOCK_SIZE        1024U
+#define EXT2_ROOT_INO               2U
+
+/** Block pointers in an inode: 12 direct, then single/double/triple indirect */
+#define EXT2_NDIR_BLOCKS            12U
+#define EXT2_IND_BLOCK              12U
+#define EXT2_DIND_BLOCK             13U
+#define EXT2_TIND_BLOCK             14U
+#define EXT2_N_BLOCKS               15U
+
+/* i_mode file type bits */
+#define EXT2_S_IFMT                 0xF000U
+#define EXT2_S_IFREG                0x8000U
+#define EXT2_S_IFDIR                0x4000U
+
+/** Incompatible features we can't read (compression, journal dev, meta_bg...) */
+#define EXT2_FEATURE_INCOMPAT_FILETYPE  0x0002U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct EXT2_SUPERBLOCK
+ * @brief The fields of the on-disk superblock we use
+ */
+typedef struct _EXT2_SUPERBLOCK
+{
+    unsigned int   s_inodes_count;        /**< Total inodes */
+    unsigned int   s_blocks_count;        /**< Total blocks */
+    unsigned int   s_r_blocks_count;      /**< Reserved blocks */
+    unsigned int   s_free_blocks_count;   /**< Free blocks */
+    unsigned int   s_free_inodes_count;   /**< Free inodes */
+    unsigned int   s_first_data_block;    /**< Block holding the superblock */
+    unsigned int   s_log_block_size;      /**< Block size is 1024 << this */
+    unsigned int   s_log_frag_size;       /**< Unused */
+    unsigned int   s_blocks_per_group;    /**< Blocks per group */
+    unsigned int   s_frags_per_group;     /**< Unused */
+    unsigned int   s_inodes_per_group;    /**< Inodes per group */
+    unsigned int   s_mtime;               /**< Last mount time */
+    unsigned int   s_wtime;               /**< Last write time */
+    unsigned short s_mnt_count;           /**< Mounts since fsck */
+    unsigned short s_max_mnt_count;       /**< Mounts before fsck */
+    unsigned short s_magic;               /**< EXT2_SUPER_MAGIC */
+    unsigned short s_state;               /**< Clean / errors */
+    unsigned short s_errors;              /**< Error behaviour */
+    unsigned short s_minor_rev_level;     /**< Minor revision */
+    unsigned int   s_lastcheck;           /**< Last fsck */
+    unsigned int   s_checkinterval;       /**< fsck interval */
+    unsigned int   s_creator_os;          /**< Creator OS */
+    unsigned int   s_rev_level;           /**< 0: fixed inode size, 1: dynamic */
+    unsigned short s_def_resuid;          /**< Reserved blocks uid */
+    unsigned short s_def_resgid;          /**< Reserved blocks gid */
+    unsigned int   s_first_ino;           /**< First usable inode (rev 1) */
+    unsigned short s_inode_size;          /**< Inode size (rev 1) */
+    unsigned short s_block_group_nr;      /**< Group of this superblock copy */
+    unsigned int   s_feature_compat;      /**< Compatible features */
+    unsigned int   s_feature_incompat;    /**< Incompatible features */
+    unsigned int   s_feature_ro_compat;   /**< Read-only compatible features */
+} __attribute__((packed)) EXT2_SUPERBLOCK;
+
+/**
+ * @struct EXT2_GROUP_DESC
+ * @brief Block group descriptor
+ */
+typedef struct _EXT2_GROUP_DESC
+{
+    unsigned int   bg_block_bitmap;       /**< Block bitmap block */
+    unsigned int   bg_inode_bitmap;       /**< Inode bitmap block */
+    unsigned int   bg_inode_table;        /**< First inode table block */
+    unsigned short bg_free_blocks_count;  /**< Free blocks */
+    unsigned short bg_free_inodes_count;  /**< Free inodes */
+    unsigned short bg_used_dirs_count;    /**< Directories */
+    unsigned short bg_pad;                /**< Padding */
+    unsigned int   bg_reserved[3];        /**< Reserved */
+} __attribute__((packed)) EXT2_GROUP_DESC;
+
+/**
+ * @struct EXT2_INODE
+ * @brief On-disk inode (the 128 byte revision 0 part)
+ */
+typedef struct _EXT2_INODE
+{
+    unsigned short i_mode;                /**< Type and permissions */
+    unsigned short i_uid;                 /**< Owner */
+    unsigned int   i_size;                /**< Size in bytes (low 32 bits) */
+    unsigned int   i_atime;               /**< Access time */
+    unsigned int   i_ctime;               /**< Change time */
+    unsigned int   i_mtime;               /**< Modification time */
+    unsigned int   i_dtime;               /**< Deletion time */
+    unsigned short i_gid;                 /**< Group */
+    unsigned short i_links_count;         /**< Hard links */
+    unsigned int   i_blocks;              /**< 512 byte sectors used */
+    unsigned int   i_flags;               /**< Flags */
+    unsigned int   i_osd1;                /**< OS specific */
+    unsigned int   i_block[EXT2_N_BLOCKS];/**< Block pointers */
+    unsigned int   i_generation;          /**< NFS generation */
+    unsigned int   i_file_acl;            /**< Extended attributes */
+    unsigned int   i_dir_acl;             /**< Size high 32 bits for files */
+    unsigned int   i_faddr;               /**< Fragment address */
+    unsigned char  i_osd2[12];            /**< OS specific */
+} __attribute__((packed)) EXT2_INODE;
+
+/**
+ * @struct EXT2_DIR_ENTRY
+ * @brief Directory entry header, the name follows
+ */
+typedef struct _EXT2_DIR_ENTRY
+{
+    unsigned int   inode;                 /**< Inode number, 0 if unused */
+    unsigned short rec_len;               /**< Distance to the next entry */
+    unsigned char  name_len;              /**< Name length */
+    unsigned char  file_type;             /**< Type (with FILETYPE feature) */
+    char           name[];                /**< Name, not NUL terminated */
+} __attribute__((packed)) EXT2_DIR_ENTRY;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name ext2_register_vfs
+ *
+ * @brief Registers the "ext2" filesystem type with the VFS
+ *
+ * @par vfs_mount() data is the BLK_DEVICE to read from. Only reading is
+ * supported; file data and directories go through the VFS page cache.
+ */
+void ext2_register_vfs(void);
+
+#endif /* INCLUDE_EXT2_H */
@@ -0,0 +1,128 @@
+/**
+ * @file ftrace.h
+ *
+ * @brief Header file for the function tracer
+ *
+ * @par Kernel C code is built with -fpatchable-function-entry, which leaves
+ * a pad of FTRACE_PAD_SIZE bytes at the entry of every function and lists
+ * it in the __patchable_function_entries section. link.ld collects that
+ * list between ftrace_sites_start and ftrace_sites_end. At boot every pad
+ * becomes a single 5 byte NOP, the only cost of a function not traced.
+ *
+ * Tracing a function turns its pad into a call of ftrace_entry_tramp. The
+ * entry hook counts the call, timestamps it and swaps the return address
+ * for ftrace_return_tramp, whose hook adds the elapsed cycles (inclusive of
+ * callees, and of sleeps) to the function. Functions are selected by name
+ * or glob through the kernel symbol table (ksyms.h).
+ *
+ * ftrace.c itself is built without pads, so the tracer cannot trace itself.
+ */
+#ifndef INCLUDE_FTRACE_H
+#define INCLUDE_FTRACE_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** Pad bytes per function, must match -fpatchable-function-entry */
+#define FTRACE_PAD_SIZE         5U
+
+/** Traced calls a thread can have open at once */
+#define FTRACE_MAX_DEPTH        32U
+
+/* Return codes */
+#define FTRACE_OK               0
+#define FTRACE_ERR_NOENT        (-1)    /**< No function matches */
+#define FTRACE_ERR_NOMEM        (-2)
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct FTRACE_FUNC
+ * @brief A patch site and the counters of its function
+ */
+typedef struct _FTRACE_FUNC
+{
+    unsigned int        addr;         /**< Pad, the function entry */
+    const char         *name;
+    unsigned int        enabled;
+    unsigned int        calls;
+    unsigned long long  cycles;       /**< Inclusive time of returned calls */
+} FTRACE_FUNC;
+
+/**
+ * @struct FTRACE_FRAME
+ * @brief A traced call that has not returned, kept per thread
+ */
+typedef struct _FTRACE_FRAME
+{
+    FTRACE_FUNC        *func;
+    unsigned int        ret;          /**< Return address into the caller */
+    unsigned long long  start;
+} FTRACE_FRAME;
+
+/**
+ * @struct FTRACE_STATS
+ * @brief Tracer counters
+ */
+typedef struct _FTRACE_STATS
+{
+    unsigned int sites;               /**< Patchable functions */
+    unsigned int enabled;             /**< Functions traced now */
+    unsigned int overflows;           /**< Calls not timed, FTRACE_MAX_DEPTH reached */
+} FTRACE_STATS;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name ftrace_enable / ftrace_disable
+ *
+ * @brief Starts or stops tracing the functions matching a name or glob
+ *
+ * @return The number of functions matched, or FTRACE_ERR_NOENT
+ */
+int ftrace_enable(const char * pattern);
+int ftrace_disable(const char * pattern);
+
+/**
+ * @name ftrace_reset
+ *
+ * @brief Clears the call counts and times
+ */
+void ftrace_reset(void);
+
+/**
+ * @name ftrace_for_each
+ *
+ * @brief Calls fn for every function that was called while traced
+ */
+void ftrace_for_each(void (*fn)(const FTRACE_FUNC * func));
+
+/**
+ * @name ftrace_get_stats
+ *
+ * @brief Returns the tracer counters
+ */
+const FTRACE_STATS * ftrace_get_stats(void);
+
+/**
+ * @name ftrace_entry / ftrace_exit
+ *
+ * @brief Hooks called by the trampolines with interrupts as they were
+ *
+ * @param site   Pad of the called function
+ * @param parent Stack slot holding the return address into the caller
+ * @return       ftrace_exit(): where the traced function really returns
+ */
+void ftrace_entry(unsigned int site, unsigned int * parent);
+unsigned int ftrace_exit(void);
+
+/**
+ * @name ftrace_entry_tramp / ftrace_return_tramp
+ *
+ * @brief Save the registers around the hooks
+ *
+ * @note Implemented in ftrace_tramp.s.
+ */
+void ftrace_entry_tramp(void);
+void ftrace_return_tramp(void);
+
+#endif /* INCLUDE_FTRACE_H */
@@ -0,0 +1,54 @@
+/**
+ * @file futex.h
+ *
+ * @brief Header file for futex style waiting on a memory word
+ *
+ * @par A thread that finds a word at a value it cannot proceed with sleeps
+ * on the word's address; whoever changes the word wakes the sleepers. The
+ * fast paths stay in the data structure owning the word, the wait is only
+ * the slow path. Waiters are kept in a small table hashed by address.
+ */
+#ifndef INCLUDE_FUTEX_H
+#define INCLUDE_FUTEX_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** Waiter hash buckets (power of two) */
+#define FUTEX_HASH_BUCKETS      32U
+
+/** Count for @ref futex_wake that wakes every waiter */
+#define FUTEX_WAKE_ALL          0xFFFFFFFFU
+
+/* Return codes */
+#define FUTEX_OK                0
+#define FUTEX_ERR_AGAIN         (-1)    /**< The word no longer held the value */
+
+/******************************************* Typedefs/structures */
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name futex_wait
+ *
+ * @brief Sleeps until woken if *addr still equals val
+ *
+ * @par The comparison and the enqueue happen with interrupts disabled, so a
+ * change followed by @ref futex_wake cannot slip in between them. Callers
+ * recheck their condition after it returns.
+ *
+ * @return FUTEX_OK once woken, FUTEX_ERR_AGAIN if *addr had changed
+ */
+int futex_wait(volatile unsigned int * addr, unsigned int val);
+
+/**
+ * @name futex_wake
+ *
+ * @brief Wakes up to count threads sleeping on addr, may be called from
+ * interrupts
+ *
+ * @return The number of threads woken
+ */
+unsigned int futex_wake(volatile unsigned int * addr, unsigned int count);
+
+#endif /* INCLUDE_FUTEX_H */
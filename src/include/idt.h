@@ -0,0 +1,104 @@
+/**
+ * @file idt.h
+ *
+ * @brief Header file for the Interrupt Descriptor Table (IDT)
+ */
+#ifndef INCLUDE_IDT_H
+#define INCLUDE_IDT_H
+
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** CPU exceptions use vectors 0 - 31 */
+#define IDT_NR_EXCEPTIONS       32U
+/** The 16 PIC lines are remapped to vectors 32 - 47 */
+#define IDT_IRQ_BASE            32U
+/** Vectors with a stub in interrupt.s */
+#define IDT_NR_VECTORS          48U
+/** Size of the IDT, unused vectors are not present */
+#define IDT_ENTRY_COUNT         256U
+
+/** @defgroup IDT_ATTR IDT gate type and attributes
+ * @{
+ */
+#define IDT_ATTR_PRESENT        0x80    /**< Gate is present */
+#define IDT_ATTR_PRIVILEGE_0    0x00    /**< Only ring 0 may int into it */
+#define IDT_ATTR_INTERRUPT_32   0x0E    /**< 32 bit interrupt gate (clears IF) */
+/** @} */
+
+#define IDT_KERNEL_INTERRUPT_GATE (IDT_ATTR_PRESENT | IDT_ATTR_PRIVILEGE_0 | \
+                                   IDT_ATTR_INTERRUPT_32)
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct IDT_ENTRY
+ * @brief A single interrupt gate descriptor
+ */
+typedef struct _IDT_ENTRY
+{
+    unsigned short offset_low;    /**< Lower 16 bits of the handler address */
+    unsigned short selector;      /**< Code segment selector */
+    unsigned char  zero;          /**< Always 0 */
+    unsigned char  type_attr;     /**< Gate type, DPL and present bit */
+    unsigned short offset_high;   /**< Upper 16 bits of the handler address */
+} __attribute__((packed)) IDT_ENTRY;
+
+/**
+ * @struct IDT
+ * @brief IDT pointer structure for the LIDT instruction
+ */
+typedef struct _IDT
+{
+    unsigned short size;          /**< Size of the IDT in bytes minus 1 */
+    unsigned int   address;       /**< Linear address of the IDT */
+} __attribute__((packed)) IDT;
+
+/**
+ * @struct INTERRUPT_FRAME
+ * @brief Registers saved by the common stub in interrupt.s
+ *
+ * The layout must match the push order of isr_common.
+ */
+typedef struct _INTERRUPT_FRAME
+{
+    unsigned int gs, fs, es, ds;                          /**< Segment registers */
+    unsigned int edi, esi, ebp, esp, ebx, edx, ecx, eax;  /**< pusha */
+    unsigned int vector;                                  /**< Interrupt vector */
+    unsigned int error_code;                              /**< CPU error code or 0 */
+    unsigned int eip, cs, eflags;                         /**< Pushed by the CPU */
+} INTERRUPT_FRAME;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name idt_install
+ *
+ * @brief Points vectors 0 - 47 at their stubs and loads the IDT
+ *
+ * @note The GDT must be installed first, the gates use its code selector.
+ */
+void idt_install(void);
+
+/**
+ * @name idt_flush
+ *
+ * @brief Assembly function to load the IDT with the lidt instruction
+ *
+ * @param idt_ptr Pointer to the IDT pointer structure
+ */
+void idt_flush(IDT * idt_ptr);
+
+/**
+ * @name interrupt_dispatch
+ *
+ * @brief Called by the assembly stubs for every interrupt, see irq.c
+ *
+ * @param frame The saved registers
+ */
+void interrupt_dispatch(INTERRUPT_FRAME * frame);
+
+/** Stub addresses, indexed by vector (defined in interrupt.s) */
+extern unsigned int isr_stub_table[IDT_NR_VECTORS];
+
+#endif /* INCLUDE_IDT_H */
@@ -0,0 +1,157 @@
+/**
+ * @file initcall.h
+ *
+ * @brief Header file for staged boot initcalls and the boot timeline
+ *
+ * @par Subsystems register their init functions with the INITCALL_* macros.
+ * Each one is placed in a .initcall<level> section, link.ld collects the
+ * sections in level order, and @ref initcall_run_all walks them. Within a
+ * level the order is link order, so anything with a dependency goes in a
+ * later level.
+ *
+ * Every call is timestamped with the TSC, counting from the first
+ * instruction of loader.s. Calls that nothing at boot waits for can be:
+ * - asynchronous: queued to the kworker thread, which runs them once the
+ *   boot thread waits for input,
+ * - deferred: run only when something first needs them,
+ * and @ref initcall_sync runs a pending one at its first use either way.
+ * When the last asynchronous call is done the timeline goes out over COM1.
+ */
+#ifndef INCLUDE_INITCALL_H
+#define INCLUDE_INITCALL_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/* Levels, in the order they run */
+#define INITCALL_LEVEL_EARLY    0       /**< CPU tables, PIC, COM1 */
+#define INITCALL_LEVEL_MEMORY   1       /**< Page allocator and paging */
+#define INITCALL_LEVEL_CORE     2       /**< Kernel threads for deferred work */
+#define INITCALL_LEVEL_CONSOLE  3       /**< Console output beyond COM1 */
+#define INITCALL_LEVEL_FS       4       /**< VFS and the root file system */
+#define INITCALL_LEVEL_DEVICE   5       /**< Device drivers */
+#define INITCALL_LEVEL_LATE     6       /**< Everything else */
+#define INITCALL_NR_LEVELS      7U
+
+/* Flags */
+#define INITCALL_SYNC           0x0U    /**< Runs in order during boot */
+#define INITCALL_ASYNC          0x1U    /**< Runs in the kworker after boot */
+#define INITCALL_DEFERRED       0x2U    /**< Runs at first use only */
+
+/** Boot timeline entries, initcalls plus the loader, kmain and ready marks */
+#define INITCALL_MAX_RECORDS    48U
+
+/* Return codes */
+#define INITCALL_OK             0
+#define INITCALL_ERR_NOENT      (-1)    /**< No initcall with that name */
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct INITCALL_STATE
+ * @brief Run state of one initcall, in .bss next to its registration
+ */
+typedef struct _INITCALL_STATE
+{
+    unsigned int  state;              /**< Not run, running or done */
+    int           ret;                /**< Result once done */
+} INITCALL_STATE;
+
+/**
+ * @struct INITCALL
+ * @brief One registered init function, lives in a .initcall<level> section
+ */
+typedef struct _INITCALL
+{
+    const char     *name;
+    int           (*fn)(void);        /**< Returns 0 or a negative error */
+    unsigned int    level;
+    unsigned int    flags;            /**< INITCALL_SYNC, _ASYNC or _DEFERRED */
+    INITCALL_STATE *state;
+} INITCALL;
+
+/**
+ * @struct INITCALL_RECORD
+ * @brief One entry of the boot timeline
+ */
+typedef struct _INITCALL_RECORD
+{
+    const char        *name;
+    unsigned int       level;
+    unsigned int       flags;
+    int                ret;
+    unsigned long long start;         /**< TSC when the call started */
+    unsigned long long end;           /**< TSC when it returned */
+} INITCALL_RECORD;
+
+/**
+ * @name INITCALL_OUT
+ *
+ * @brief Where @ref initcall_report writes its lines
+ */
+typedef void (*INITCALL_OUT)(const char * buf, unsigned int len);
+
+/******************************************* Macros */
+#define INITCALL_STR(x)         #x
+#define INITCALL_SECTION(level) ".initcall" INITCALL_STR(level)
+
+/**
+ * @name INITCALL_DEFINE
+ *
+ * @brief Registers fn to run at the given level
+ */
+#define INITCALL_DEFINE(level, fn, flags) \
+        static INITCALL_STATE initcall_state_##fn; \
+        static const INITCALL initcall_##fn \
+            __attribute__((used, section(INITCALL_SECTION(level)), aligned(4))) = \
+            { #fn, fn, level, flags, &initcall_state_##fn }
+
+#define INITCALL_EARLY(fn)      INITCALL_DEFINE(INITCALL_LEVEL_EARLY, fn, INITCALL_SYNC)
+#define INITCALL_MEMORY(fn)     INITCALL_DEFINE(INITCALL_LEVEL_MEMORY, fn, INITCALL_SYNC)
+#define INITCALL_CORE(fn)       INITCALL_DEFINE(INITCALL_LEVEL_CORE, fn, INITCALL_SYNC)
+#define INITCALL_CONSOLE(fn)    INITCALL_DEFINE(INITCALL_LEVEL_CONSOLE, fn, INITCALL_SYNC)
+#define INITCALL_FS(fn)         INITCALL_DEFINE(INITCALL_LEVEL_FS, fn, INITCALL_SYNC)
+#define INITCALL_DEVICE(fn)     INITCALL_DEFINE(INITCALL_LEVEL_DEVICE, fn, INITCALL_SYNC)
+#define INITCALL_LATE(fn)       INITCALL_DEFINE(INITCALL_LEVEL_LATE, fn, INITCALL_SYNC)
+
+/******************************************* Protoytes */
+/**
+ * @name initcall_run_all
+ *
+ * @brief Runs the synchronous initcalls of every level in order
+ *
+ * @note Called once by kmain(). Asynchronous calls are queued to the
+ * kworker, deferred ones wait for @ref initcall_sync.
+ */
+void initcall_run_all(void);
+
+/**
+ * @name initcall_mark_ready
+ *
+ * @brief Records the point where the kernel is ready for input
+ */
+void initcall_mark_ready(void);
+
+/**
+ * @name initcall_sync
+ *
+ * @brief Runs a pending asynchronous or deferred initcall now
+ *
+ * @param name Function name the initcall was registered with
+ * @return     Its return value (also if it already ran), or INITCALL_ERR_NOENT
+ */
+int initcall_sync(const char * name);
+
+/**
+ * @name initcall_sync_all
+ *
+ * @brief Runs every pending asynchronous and deferred initcall
+ */
+void initcall_sync_all(void);
+
+/**
+ * @name initcall_report
+ *
+ * @brief Writes the boot timeline
+ */
+void initcall_report(INITCALL_OUT out);
+
+#endif /* INCLUDE_INITCALL_H */
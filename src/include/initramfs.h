@@ -0,0 +1,146 @@
+/**
+ * @file initramfs.h
+ *
+ * @brief Header file for the initial RAM filesystem
+ *
+ * @par The archive is built on the host by src/tools/mkinitrd.c and loaded by
+ * GRUB as a multiboot module. It is laid out as:
+ *
+ *  | INITRAMFS_HEADER | INITRAMFS_ENTRY x nr_entries | names | file data |
+ *
+ * Entries are sorted by path in byte order, the kernel finds directories by
+ * binary search. All offsets are relative to the start of the archive. File data starts
+ * on a page boundary and the archive is padded to a whole page, with zeros,
+ * so the VFS can map a file's pages in the module itself. This header is
+ * shared with the host tool, so it only uses fixed size fields.
+ */
+#ifndef INCLUDE_INITRAMFS_H
+#define INCLUDE_INITRAMFS_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** "IRFS" in little endian */
+#define INITRAMFS_MAGIC             0x53465249U
+#define INITRAMFS_VERSION           2U
+
+/** File data and archive size alignment, the kernel's PAGE_SIZE */
+#define INITRAMFS_DATA_ALIGN        4096U
+
+/** Lookup hash buckets (power of two), shared by all files */
+#define INITRAMFS_HASH_BUCKETS      256U
+
+/** End of a hash chain */
+#define INITRAMFS_NO_ENTRY          0xFFFFFFFFU
+
+/* Return codes */
+#define INITRAMFS_OK                0
+#define INITRAMFS_ERR_FORMAT        (-1)    /**< Not an archive, or corrupt */
+#define INITRAMFS_ERR_NOENT         (-2)    /**< No such file */
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct INITRAMFS_HEADER
+ * @brief Archive header
+ */
+typedef struct _INITRAMFS_HEADER
+{
+    unsigned int magic;           /**< INITRAMFS_MAGIC */
+    unsigned int version;         /**< INITRAMFS_VERSION */
+    unsigned int nr_entries;      /**< Number of files */
+    unsigned int total_size;      /**< Size of the whole archive */
+} __attribute__((packed)) INITRAMFS_HEADER;
+
+/**
+ * @struct INITRAMFS_ENTRY
+ * @brief One file of the archive
+ *
+ * @note next is written by the kernel at mount time to chain entries of the
+ * same hash bucket, so the index needs no memory of its own.
+ */
+typedef struct _INITRAMFS_ENTRY
+{
+    unsigned int hash;            /**< initramfs_hash() of the path */
+    unsigned int name_offset;     /**< Path, without leading '/', NUL terminated */
+    unsigned int name_len;        /**< Path length without the NUL */
+    unsigned int data_offset;     /**< File contents */
+    unsigned int data_len;        /**< File size */
+    unsigned int next;            /**< Next entry in the bucket (kernel use) */
+} __attribute__((packed)) INITRAMFS_ENTRY;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name initramfs_hash
+ *
+ * @brief FNV-1a hash of the first len characters of a path
+ *
+ * @note Used both by mkinitrd and the kernel, so it must never change
+ * without bumping INITRAMFS_VERSION.
+ */
+static inline unsigned int initramfs_hash(const char * path, unsigned int len)
+{
+    unsigned int hash = 2166136261U;
+    unsigned int i;
+
+    for (i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char) path[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+#ifndef INITRAMFS_HOST_TOOL
+/**
+ * @name initramfs_mount
+ *
+ * @brief Validates an archive and builds its lookup index
+ *
+ * @par Mounting only checks the entry table and links it into the hash
+ * buckets; it neither allocates nor touches file data.
+ *
+ * @param base Start of the archive (the multiboot module)
+ * @param size Size of the module
+ * @return     INITRAMFS_OK or INITRAMFS_ERR_FORMAT
+ */
+int initramfs_mount(void * base, unsigned int size);
+
+/**
+ * @name initramfs_lookup
+ *
+ * @brief Finds a file and returns a pointer straight into the archive
+ *
+ * @param path Absolute or relative path, e.g. "/etc/motd"
+ * @param data Set to the file contents (read only, not NUL terminated)
+ * @param len  Set to the file size
+ * @return     INITRAMFS_OK or INITRAMFS_ERR_NOENT
+ */
+int initramfs_lookup(const char * path, const void ** data, unsigned int * len);
+
+/**
+ * @name initramfs_entry_count
+ *
+ * @brief Returns the number of files in the mounted archive
+ */
+unsigned int initramfs_entry_count(void);
+
+/**
+ * @name initramfs_entry_name
+ *
+ * @brief Returns the path of the idx'th file (without leading '/')
+ */
+const char * initramfs_entry_name(unsigned int idx);
+
+/**
+ * @name initramfs_register_vfs
+ *
+ * @brief Registers the "initramfs" filesystem type with the VFS
+ *
+ * @par Mounting it exposes the archive mounted by @ref initramfs_mount,
+ * directories are implied by the paths of the files.
+ */
+void initramfs_register_vfs(void);
+#endif /* INITRAMFS_HOST_TOOL */
+
+#endif /* INCLUDE_INITRAMFS_H */
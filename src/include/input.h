@@ -0,0 +1,110 @@
+/**
+ * @file input.h
+ *
+ * @brief Header file for the keyboard and serial input path
+ *
+ * @par Each source has a single-producer single-consumer ring. The interrupt
+ * handler is the only producer: it stores the raw byte (a scancode or a
+ * serial character) with a TSC timestamp and publishes it by moving the head.
+ * Nothing is decoded in interrupt context. The consumer pops events, turns
+ * them into characters and records how long each event waited between the
+ * interrupt and the consumer waking up.
+ */
+#ifndef INCLUDE_INPUT_H
+#define INCLUDE_INPUT_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** Events per ring (power of two) */
+#define INPUT_RING_SIZE         256U
+
+/* Input sources */
+#define INPUT_SRC_KEYBOARD      0U
+#define INPUT_SRC_SERIAL        1U
+#define INPUT_NR_SOURCES        2U
+
+/* Control characters produced by the decoders */
+#define INPUT_CHAR_BACKSPACE    '\b'
+#define INPUT_CHAR_CTRL(c)      ((c) & 0x1F)
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct INPUT_EVENT
+ * @brief A raw byte as captured by the interrupt handler
+ */
+typedef struct _INPUT_EVENT
+{
+    unsigned long long tsc;           /**< TSC when the interrupt read it */
+    unsigned int       code;          /**< Scancode or serial byte */
+} INPUT_EVENT;
+
+/**
+ * @struct INPUT_RING
+ * @brief Lock-free ring, written by one interrupt handler, read by one consumer
+ */
+typedef struct _INPUT_RING
+{
+    volatile unsigned int head;       /**< Next slot to fill, producer only */
+    volatile unsigned int tail;       /**< Next slot to read, consumer only */
+    unsigned int          dropped;    /**< Events lost because the ring was full */
+    INPUT_EVENT           ev[INPUT_RING_SIZE];
+} INPUT_RING;
+
+/**
+ * @struct INPUT_STATS
+ * @brief Per source counters, latencies are in TSC cycles
+ */
+typedef struct _INPUT_STATS
+{
+    unsigned int       events;        /**< Events consumed */
+    unsigned int       chars;         /**< Events that decoded to a character */
+    unsigned int       dropped;       /**< Events lost to a full ring */
+    unsigned long long lat_sum;       /**< Sum of interrupt-to-consumer latencies */
+    unsigned long long lat_min;       /**< Smallest latency */
+    unsigned long long lat_max;       /**< Largest latency */
+} INPUT_STATS;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name input_push
+ *
+ * @brief Queues a raw byte, called from the source's interrupt handler
+ *
+ * @param src  INPUT_SRC_*
+ * @param code The raw byte
+ */
+void input_push(unsigned int src, unsigned int code);
+
+/**
+ * @name input_getc
+ *
+ * @brief Returns the next character, sleeping while there is none
+ *
+ * @note Must be called from a thread with interrupts enabled.
+ */
+int input_getc(void);
+
+/**
+ * @name input_trygetc
+ *
+ * @brief Returns the next character, or -1 if none is queued
+ */
+int input_trygetc(void);
+
+/**
+ * @name input_get_stats
+ *
+ * @brief Returns the counters of one source
+ */
+const INPUT_STATS * input_get_stats(unsigned int src);
+
+/**
+ * @name input_reset_stats
+ *
+ * @brief Clears the counters of all sources
+ */
+void input_reset_stats(void);
+
+#endif /* INCLUDE_INPUT_H */
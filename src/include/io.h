@@ -25,4 +25,36 @@ void outb(unsigned short port, unsigned char data);
  */
 unsigned char inb(unsigned short port);
 
+/** outw:
+ *  Sends the given word to the given I/O port. Defined in io.s
+ *
+ *  @param port The I/O port to send the data to
+ *  @param data The data to send to the I/O port
+ */
+void outw(unsigned short port, unsigned short data);
+
+/** inw:
+ *  Read a word from an I/O port.
+ *
+ *  @param  port The address of the I/O port
+ *  @return      The read word
+ */
+unsigned short inw(unsigned short port);
+
+/** outl:
+ *  Sends the given double word to the given I/O port. Defined in io.s
+ *
+ *  @param port The I/O port to send the data to
+ *  @param data The data to send to the I/O port
+ */
+void outl(unsigned short port, unsigned int data);
+
+/** inl:
+ *  Read a double word from an I/O port.
+ *
+ *  @param  port The address of the I/O port
+ *  @return      The read double word
+ */
+unsigned int inl(unsigned short port);
+
 #endif /* INCLUDE_IO_H */
\ No newline at end of file
@@ -0,0 +1,193 @@
+/**
+ * @file ipc.h
+ *
+ * @brief Header file for message channels between kernel threads
+ *
+ * @par A channel is a ring of fixed size slots in pages of its own, shared
+ * by the sender and the receiver. Messages are built and read in place:
+ * - @ref ipc_send_begin hands the sender a free slot to write,
+ *   @ref ipc_send_commit publishes it,
+ * - @ref ipc_recv_begin hands the receiver the oldest message,
+ *   @ref ipc_recv_end returns its slot.
+ * Every slot carries a sequence number saying which lap of the ring it is
+ * ready for, so both sides only touch their own index and the slot. The
+ * producer index and the consumer index sit on cache lines of their own.
+ *
+ * A channel has one receiver and either one sender (IPC_CHAN_SPSC) or any
+ * number of them (IPC_CHAN_MPSC, which claim slots with a compare-and-swap).
+ *
+ * Payloads larger than a slot are granted: the sender fills pages from
+ * @ref ipc_page_alloc and passes them with @ref ipc_send_pages. The pages
+ * then belong to the receiver, nothing is copied.
+ *
+ * A side only sleeps when the ring is full or empty, with @ref futex_wait on
+ * the slot's sequence number.
+ */
+#ifndef INCLUDE_IPC_H
+#define INCLUDE_IPC_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/* Channel flags */
+#define IPC_CHAN_SPSC           0x0U    /**< One sender */
+#define IPC_CHAN_MPSC           0x1U    /**< Many senders */
+
+/* Send and receive flags */
+#define IPC_NONBLOCK            0x1U    /**< Fail with IPC_ERR_AGAIN instead of sleeping */
+
+/* Message flags */
+#define IPC_MSG_PAGES           0x1U    /**< Payload is in granted pages */
+
+/** Largest grant, in pages */
+#define IPC_GRANT_MAX_PAGES     16U
+
+/* Return codes */
+#define IPC_OK                  0
+#define IPC_ERR_INVAL           (-1)    /**< Bad argument */
+#define IPC_ERR_NOMEM           (-2)    /**< Out of memory */
+#define IPC_ERR_AGAIN           (-3)    /**< Ring full or empty with IPC_NONBLOCK */
+#define IPC_ERR_MSGSIZE         (-4)    /**< Message does not fit */
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct IPC_MSG
+ * @brief Slot header, the inline payload follows it
+ */
+typedef struct _IPC_MSG
+{
+    volatile unsigned int seq;        /**< Ring position the slot is ready for */
+    unsigned int          pos;        /**< Ring position it was claimed at */
+    unsigned int          len;        /**< Payload bytes */
+    unsigned int          flags;      /**< IPC_MSG_* */
+    void                 *pages;      /**< Granted pages with IPC_MSG_PAGES */
+    unsigned int          npages;
+    unsigned long long    tsc;        /**< Commit time */
+} IPC_MSG;
+
+/**
+ * @struct IPC_STATS
+ * @brief Counters of a channel
+ */
+typedef struct _IPC_STATS
+{
+    unsigned int sent;
+    unsigned int granted;             /**< Sent messages carrying pages */
+    unsigned int send_waits;          /**< Sleeps on a full ring */
+    unsigned int received;
+    unsigned int recv_waits;          /**< Sleeps on an empty ring */
+} IPC_STATS;
+
+/** A channel, opaque to its users */
+typedef struct _IPC_CHAN IPC_CHAN;
+
+/******************************************* Macros */
+/** Inline payload of a slot */
+#define IPC_MSG_DATA(msg)       ((void *) ((IPC_MSG *) (msg) + 1))
+
+/******************************************* Protoytes */
+/**
+ * @name ipc_chan_create
+ *
+ * @brief Allocates a channel
+ *
+ * @param nr_slots   Ring size, a power of two
+ * @param max_inline Largest inline payload, the slot size is rounded up to
+ *                   cache lines
+ * @param flags      IPC_CHAN_SPSC or IPC_CHAN_MPSC
+ * @param err        Where to store the error code (may be NULL)
+ * @return           The channel, or NULL
+ */
+IPC_CHAN * ipc_chan_create(unsigned int nr_slots, unsigned int max_inline,
+                           unsigned int flags, int * err);
+
+/**
+ * @name ipc_chan_destroy
+ *
+ * @brief Frees a channel and the pages of messages never received
+ *
+ * @note Nobody may be using it anymore.
+ */
+void ipc_chan_destroy(IPC_CHAN * chan);
+
+/**
+ * @name ipc_chan_max_inline
+ *
+ * @brief Returns the largest payload that fits in a slot
+ */
+unsigned int ipc_chan_max_inline(const IPC_CHAN * chan);
+
+/**
+ * @name ipc_send_begin
+ *
+ * @brief Claims the next free slot, sleeping while the ring is full
+ *
+ * @par The caller writes up to @ref ipc_chan_max_inline bytes to
+ * IPC_MSG_DATA(msg), sets msg->len and commits it.
+ *
+ * @return IPC_OK or IPC_ERR_AGAIN
+ */
+int ipc_send_begin(IPC_CHAN * chan, IPC_MSG ** msg, unsigned int flags);
+
+/**
+ * @name ipc_send_commit
+ *
+ * @brief Publishes a slot from @ref ipc_send_begin and wakes the receiver
+ */
+void ipc_send_commit(IPC_CHAN * chan, IPC_MSG * msg);
+
+/**
+ * @name ipc_recv_begin
+ *
+ * @brief Returns the oldest message, sleeping while the ring is empty
+ *
+ * @par The payload stays valid until @ref ipc_recv_end. Granted pages belong
+ * to the receiver from here on and are freed with @ref ipc_page_free.
+ *
+ * @return IPC_OK or IPC_ERR_AGAIN
+ */
+int ipc_recv_begin(IPC_CHAN * chan, IPC_MSG ** msg, unsigned int flags);
+
+/**
+ * @name ipc_recv_end
+ *
+ * @brief Returns a slot from @ref ipc_recv_begin and wakes blocked senders
+ */
+void ipc_recv_end(IPC_CHAN * chan, IPC_MSG * msg);
+
+/**
+ * @name ipc_send / ipc_recv
+ *
+ * @brief Copying wrappers around the calls above, for inline messages
+ *
+ * @return IPC_OK / the payload length, or a negative error
+ */
+int ipc_send(IPC_CHAN * chan, const void * buf, unsigned int len, unsigned int flags);
+int ipc_recv(IPC_CHAN * chan, void * buf, unsigned int size, unsigned int flags);
+
+/**
+ * @name ipc_page_alloc / ipc_page_free
+ *
+ * @brief Allocate and free pages for a grant of len bytes
+ */
+void * ipc_page_alloc(unsigned int len);
+void ipc_page_free(void * pages, unsigned int len);
+
+/**
+ * @name ipc_send_pages
+ *
+ * @brief Sends pages from @ref ipc_page_alloc holding len bytes
+ *
+ * @par On success the pages belong to the receiver.
+ *
+ * @return IPC_OK or a negative error
+ */
+int ipc_send_pages(IPC_CHAN * chan, void * pages, unsigned int len, unsigned int flags);
+
+/**
+ * @name ipc_chan_get_stats
+ *
+ * @brief Copies the counters of a channel
+ */
+void ipc_chan_get_stats(const IPC_CHAN * chan, IPC_STATS * stats);
+
+#endif /* INCLUDE_IPC_H */
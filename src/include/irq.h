@@ -0,0 +1,120 @@
+/**
+ * @file irq.h
+ *
+ * @brief Header file for the 8259 PIC and hardware interrupt handlers
+ *
+ * @par The two PICs are remapped to vectors 32 - 47 so they do not collide
+ * with the CPU exceptions. Every line starts masked; a driver registers its
+ * handler and then unmasks its line. Handlers run with interrupts disabled
+ * and the end of interrupt is sent after they return.
+ *
+ * The dispatch finds the handler in an RCU protected table (rcu.h), so it
+ * takes no lock and writes no shared line on the way to the handler.
+ */
+#ifndef INCLUDE_IRQ_H
+#define INCLUDE_IRQ_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** Number of PIC lines */
+#define IRQ_COUNT               16U
+
+/* Legacy IRQ lines */
+#define IRQ_TIMER               0U
+#define IRQ_KEYBOARD            1U
+#define IRQ_CASCADE             2U
+#define IRQ_COM1                4U
+
+/* PIC ports */
+#define PIC1_COMMAND            0x20
+#define PIC1_DATA               0x21
+#define PIC2_COMMAND            0xA0
+#define PIC2_DATA               0xA1
+
+/* PIC commands */
+#define PIC_ICW1_INIT_ICW4      0x11    /**< Initialise, ICW4 follows */
+#define PIC_ICW4_8086           0x01    /**< 8086 mode */
+#define PIC_OCW3_READ_ISR       0x0B    /**< Next read of the command port returns ISR */
+#define PIC_EOI                 0x20    /**< Non-specific end of interrupt */
+
+/* Return codes */
+#define IRQ_OK                  0
+#define IRQ_ERR_INVAL           (-1)    /**< No such line */
+#define IRQ_ERR_BUSY            (-2)    /**< Line already has a handler */
+#define IRQ_ERR_NOMEM           (-3)
+
+/******************************************* Typedefs/structures */
+/**
+ * @name IRQ_HANDLER
+ *
+ * @brief Interrupt handler, runs with interrupts disabled
+ *
+ * @param irq The PIC line
+ * @param ctx The pointer given to @ref irq_register
+ */
+typedef void (*IRQ_HANDLER)(unsigned int irq, void * ctx);
+
+/**
+ * @struct IRQ_STATS
+ * @brief Interrupt counters
+ */
+typedef struct _IRQ_STATS
+{
+    unsigned int count[IRQ_COUNT];    /**< Interrupts handled per line */
+    unsigned int spurious;            /**< Spurious IRQ 7 / 15 */
+    unsigned int unhandled;           /**< Interrupts on lines without a handler */
+} IRQ_STATS;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name irq_init
+ *
+ * @brief Installs the IDT and remaps the PICs with all lines masked
+ *
+ * @note Interrupts stay disabled, call local_irq_enable() when ready.
+ */
+void irq_init(void);
+
+/**
+ * @name irq_register
+ *
+ * @brief Installs the handler of a line, the line stays masked
+ *
+ * @return IRQ_OK or an error
+ */
+int irq_register(unsigned int irq, IRQ_HANDLER handler, void * ctx);
+
+/**
+ * @name irq_unregister
+ *
+ * @brief Masks a line and removes its handler
+ *
+ * @par Sleeps until a handler running on another CPU has returned, ctx may
+ * be freed afterwards. Threads only.
+ */
+void irq_unregister(unsigned int irq);
+
+/**
+ * @name irq_unmask
+ *
+ * @brief Lets the PIC deliver interrupts of a line
+ */
+void irq_unmask(unsigned int irq);
+
+/**
+ * @name irq_mask
+ *
+ * @brief Stops the PIC from delivering interrupts of a line
+ */
+void irq_mask(unsigned int irq);
+
+/**
+ * @name irq_get_stats
+ *
+ * @brief Returns the interrupt counters
+ */
+const IRQ_STATS * irq_get_stats(void);
+
+#endif /* INCLUDE_IRQ_H */
@@ -0,0 +1,64 @@
+/**
+ * @file kmalloc.h
+ *
+ * @brief Header file for the kernel heap
+ */
+#ifndef INCLUDE_KMALLOC_H
+#define INCLUDE_KMALLOC_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** Smallest and largest size class served from shared pages */
+#define KMALLOC_MIN_SIZE        16U
+#define KMALLOC_MAX_SMALL       2048U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct KMALLOC_STATS
+ * @brief Heap counters
+ */
+typedef struct _KMALLOC_STATS
+{
+    unsigned int allocs;          /**< Successful kmalloc calls */
+    unsigned int frees;           /**< kfree calls */
+    unsigned int slab_pages;      /**< Pages used by the size classes */
+    unsigned int large_pages;     /**< Pages used by large allocations */
+} KMALLOC_STATS;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name kmalloc
+ *
+ * @brief Allocates size bytes of kernel memory
+ *
+ * @par Sizes up to KMALLOC_MAX_SMALL come from power of two size classes,
+ * objects of a class are size aligned. Larger sizes get their own pages.
+ *
+ * @return The memory (identity mapped), or NULL
+ */
+void * kmalloc(unsigned int size);
+
+/**
+ * @name kzalloc
+ *
+ * @brief Like @ref kmalloc, but the memory is zeroed
+ */
+void * kzalloc(unsigned int size);
+
+/**
+ * @name kfree
+ *
+ * @brief Frees memory from @ref kmalloc (NULL is ignored)
+ */
+void kfree(void * ptr);
+
+/**
+ * @name kmalloc_get_stats
+ *
+ * @brief Returns the heap counters
+ */
+const KMALLOC_STATS * kmalloc_get_stats(void);
+
+#endif /* INCLUDE_KMALLOC_H */
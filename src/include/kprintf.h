@@ -0,0 +1,53 @@
+/**
+ * @file kprintf.h
+ *
+ * @brief Header file for the kernel's formatted output
+ */
+#ifndef INCLUDE_KPRINTF_H
+#define INCLUDE_KPRINTF_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** Largest single kprintf line, longer output is truncated */
+#define KPRINTF_BUF_SIZE 256U
+
+/******************************************* Macros */
+/* -nostdinc leaves us without stdarg.h, the builtins are what it wraps */
+typedef __builtin_va_list va_list;
+#define va_start(ap, last) __builtin_va_start(ap, last)
+#define va_arg(ap, type)   __builtin_va_arg(ap, type)
+#define va_end(ap)         __builtin_va_end(ap)
+
+/******************************************* Protoytes */
+/**
+ * @name kvsnprintf
+ *
+ * @brief Formats a string into buf
+ *
+ * @par Supported conversions: %d %u %x %c %s %p %% with an optional '0'
+ * flag, a field width and the 'l' / 'll' length modifiers.
+ *
+ * @param buf  The output buffer
+ * @param size Size of buf including the terminating NUL
+ * @param fmt  The format string
+ * @param ap   The arguments
+ * @return     Number of characters written (without the NUL)
+ */
+unsigned int kvsnprintf(char * buf, unsigned int size, const char * fmt, va_list ap);
+
+/**
+ * @name ksnprintf
+ *
+ * @brief Formats a string into buf, see @ref kvsnprintf
+ */
+unsigned int ksnprintf(char * buf, unsigned int size, const char * fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @name kprintf
+ *
+ * @brief Formats a string and writes it to the console (screen and COM1)
+ */
+void kprintf(const char * fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#endif /* INCLUDE_KPRINTF_H */
@@ -0,0 +1,79 @@
+/**
+ * @file kstring.h
+ *
+ * @brief Header file for the kernel's memory and string helpers
+ */
+#ifndef INCLUDE_KSTRING_H
+#define INCLUDE_KSTRING_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name memset
+ *
+ * @brief Fills len bytes of dst with the byte c
+ *
+ * @note Also used by GCC for struct initialisers, so it keeps the libc name.
+ */
+void * memset(void * dst, int c, unsigned int len);
+
+/**
+ * @name memcpy
+ *
+ * @brief Copies len bytes from src to dst. The areas must not overlap.
+ */
+void * memcpy(void * dst, const void * src, unsigned int len);
+
+/**
+ * @name memmove
+ *
+ * @brief Copies len bytes from src to dst. The areas may overlap.
+ */
+void * memmove(void * dst, const void * src, unsigned int len);
+
+/**
+ * @name memcmp
+ *
+ * @brief Compares len bytes of a and b
+ *
+ * @return 0 if equal, <0 or >0 on the first differing byte
+ */
+int memcmp(const void * a, const void * b, unsigned int len);
+
+/**
+ * @name strlen
+ *
+ * @brief Returns the length of a NUL terminated string
+ */
+unsigned int strlen(const char * s);
+
+/**
+ * @name strcmp
+ *
+ * @brief Compares two NUL terminated strings
+ */
+int strcmp(const char * a, const char * b);
+
+/**
+ * @name strncmp
+ *
+ * @brief Compares at most n characters of two strings
+ */
+int strncmp(const char * a, const char * b, unsigned int n);
+
+/**
+ * @name glob_match
+ *
+ * @brief Matches a string against a shell style pattern
+ *
+ * @par '*' matches any run of characters, '?' any single one.
+ *
+ * @return 1 on a match, 0 otherwise
+ */
+int glob_match(const char * pattern, const char * s);
+
+#endif /* INCLUDE_KSTRING_H */
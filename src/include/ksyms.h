@@ -0,0 +1,46 @@
+/**
+ * @file ksyms.h
+ *
+ * @brief Header file for the kernel symbol table
+ *
+ * @par The table lists every function of the kernel image, sorted by
+ * address. It is generated by the mkksyms host tool from the nm output of a
+ * first link and compiled into the second one. It lives in .rodata, after
+ * .text, so its size does not move any function.
+ */
+#ifndef INCLUDE_KSYMS_H
+#define INCLUDE_KSYMS_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct KSYM
+ * @brief One function
+ */
+typedef struct _KSYM
+{
+    unsigned int  addr;
+    const char   *name;
+} KSYM;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/** Generated table, ksym_count entries sorted by address */
+extern const KSYM ksym_table[];
+extern const unsigned int ksym_count;
+
+/**
+ * @name ksym_lookup
+ *
+ * @brief Finds the function containing addr
+ *
+ * @param addr   Code address
+ * @param offset Where to store addr minus the function start (may be NULL)
+ * @return       The function name, or NULL outside the table
+ */
+const char * ksym_lookup(unsigned int addr, unsigned int * offset);
+
+#endif /* INCLUDE_KSYMS_H */
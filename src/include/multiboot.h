@@ -0,0 +1,147 @@
+/**
+ * @file multiboot.h
+ *
+ * @brief Header file for the multiboot (version 1) boot information
+ */
+#ifndef INCLUDE_MULTIBOOT_H
+#define INCLUDE_MULTIBOOT_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** Value the bootloader leaves in eax */
+#define MULTIBOOT_BOOTLOADER_MAGIC      0x2BADB002U
+
+/* Multiboot header flags (see loader.s) */
+#define MULTIBOOT_PAGE_ALIGN            0x00000001U  /**< Modules on 4 KiB boundaries */
+#define MULTIBOOT_MEMORY_INFO           0x00000002U  /**< Ask for mem_* and mmap_* */
+#define MULTIBOOT_VIDEO_MODE            0x00000004U  /**< Ask for a video mode */
+
+/* Boot information flags, tell which fields are valid */
+#define MULTIBOOT_INFO_MEMORY           0x00000001U
+#define MULTIBOOT_INFO_CMDLINE          0x00000004U
+#define MULTIBOOT_INFO_MODS             0x00000008U
+#define MULTIBOOT_INFO_MEM_MAP          0x00000040U
+#define MULTIBOOT_INFO_VBE_INFO         0x00000800U
+#define MULTIBOOT_INFO_FRAMEBUFFER_INFO 0x00001000U
+
+/** framebuffer_type of a direct colour (RGB) framebuffer */
+#define MULTIBOOT_FRAMEBUFFER_TYPE_RGB  1U
+
+/** VBE mode attribute: linear framebuffer available */
+#define VBE_MODE_ATTR_LINEAR            0x0080U
+
+/** Memory map entry type of usable RAM */
+#define MULTIBOOT_MEMORY_AVAILABLE      1U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct MULTIBOOT_MMAP_ENTRY
+ * @brief One BIOS memory map entry
+ *
+ * @note size does not count itself, the next entry is at
+ * (char *) entry + entry->size + 4.
+ */
+typedef struct _MULTIBOOT_MMAP_ENTRY
+{
+    unsigned int       size;      /**< Size of the rest of the entry */
+    unsigned long long addr;      /**< Start of the region */
+    unsigned long long len;       /**< Length of the region */
+    unsigned int       type;      /**< MULTIBOOT_MEMORY_* */
+} __attribute__((packed)) MULTIBOOT_MMAP_ENTRY;
+
+/**
+ * @struct MULTIBOOT_MODULE
+ * @brief One module loaded by the bootloader
+ */
+typedef struct _MULTIBOOT_MODULE
+{
+    unsigned int mod_start;       /**< Physical start address */
+    unsigned int mod_end;         /**< Physical end address (exclusive) */
+    unsigned int cmdline;         /**< Module command line string */
+    unsigned int reserved;        /**< Must be 0 */
+} __attribute__((packed)) MULTIBOOT_MODULE;
+
+/**
+ * @struct MULTIBOOT_INFO
+ * @brief Boot information structure, its address is left in ebx
+ */
+typedef struct _MULTIBOOT_INFO
+{
+    unsigned int flags;           /**< MULTIBOOT_INFO_* */
+    unsigned int mem_lower;       /**< KiB of memory below 1 MiB */
+    unsigned int mem_upper;       /**< KiB of memory above 1 MiB */
+    unsigned int boot_device;     /**< BIOS boot device */
+    unsigned int cmdline;         /**< Kernel command line */
+    unsigned int mods_count;      /**< Number of modules */
+    unsigned int mods_addr;       /**< Address of MULTIBOOT_MODULE array */
+    unsigned int syms[4];         /**< a.out or ELF symbol information */
+    unsigned int mmap_length;     /**< Size of the memory map */
+    unsigned int mmap_addr;       /**< Address of the memory map */
+    unsigned int drives_length;   /**< Size of the drive table */
+    unsigned int drives_addr;     /**< Address of the drive table */
+    unsigned int config_table;    /**< BIOS configuration table */
+    unsigned int boot_loader_name;/**< Boot loader name string */
+    unsigned int apm_table;       /**< APM table */
+    unsigned int vbe_control_info;/**< VBE controller information block */
+    unsigned int vbe_mode_info;   /**< VBE_MODE_INFO of the current mode */
+    unsigned short vbe_mode;      /**< Current VBE mode number */
+    unsigned short vbe_interface_seg;
+    unsigned short vbe_interface_off;
+    unsigned short vbe_interface_len;
+    unsigned long long framebuffer_addr;    /**< Physical address of the framebuffer */
+    unsigned int framebuffer_pitch;         /**< Bytes per scan line */
+    unsigned int framebuffer_width;         /**< Pixels per line */
+    unsigned int framebuffer_height;        /**< Lines */
+    unsigned char framebuffer_bpp;          /**< Bits per pixel */
+    unsigned char framebuffer_type;         /**< MULTIBOOT_FRAMEBUFFER_TYPE_* */
+    unsigned char red_field_position;       /**< RGB only: bit position of red */
+    unsigned char red_mask_size;
+    unsigned char green_field_position;
+    unsigned char green_mask_size;
+    unsigned char blue_field_position;
+    unsigned char blue_mask_size;
+} __attribute__((packed)) MULTIBOOT_INFO;
+
+/**
+ * @struct VBE_MODE_INFO
+ * @brief Start of the VBE 2.0 mode information block (up to the LFB address)
+ */
+typedef struct _VBE_MODE_INFO
+{
+    unsigned short attributes;    /**< VBE_MODE_ATTR_* */
+    unsigned char  window_a;
+    unsigned char  window_b;
+    unsigned short granularity;
+    unsigned short window_size;
+    unsigned short segment_a;
+    unsigned short segment_b;
+    unsigned int   win_func_ptr;
+    unsigned short pitch;         /**< Bytes per scan line */
+    unsigned short width;         /**< Pixels per line */
+    unsigned short height;        /**< Lines */
+    unsigned char  w_char;
+    unsigned char  y_char;
+    unsigned char  planes;
+    unsigned char  bpp;           /**< Bits per pixel */
+    unsigned char  banks;
+    unsigned char  memory_model;
+    unsigned char  bank_size;
+    unsigned char  image_pages;
+    unsigned char  reserved0;
+    unsigned char  red_mask;      /**< Red mask size */
+    unsigned char  red_position;  /**< Red bit position */
+    unsigned char  green_mask;
+    unsigned char  green_position;
+    unsigned char  blue_mask;
+    unsigned char  blue_position;
+    unsigned char  reserved_mask;
+    unsigned char  reserved_position;
+    unsigned char  direct_color_attributes;
+    unsigned int   framebuffer;   /**< Physical address of the LFB */
+} __attribute__((packed)) VBE_MODE_INFO;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+
+#endif /* INCLUDE_MULTIBOOT_H */
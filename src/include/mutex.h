@@ -0,0 +1,95 @@
+/**
+ * @file mutex.h
+ *
+ * @brief Header file for sleeping mutexes
+ *
+ * @par An uncontended lock or unlock is a single cmpxchg. A contended
+ * locker first spins, for at most MUTEX_SPIN_MAX rounds, while the owner is
+ * running on another CPU: the owner is then likely to unlock soon, sooner
+ * than a sleep and wakeup would take. Otherwise, or when the spin runs
+ * out, it sleeps exclusively on the mutex's wait queue and unlock wakes the
+ * first sleeper only. A sleeper lends its priority to the owner
+ * (@ref sched_pi_boost) so a less urgent owner cannot hold it up.
+ *
+ * On a single CPU an owner other than the caller is never running, so a
+ * contended lock always sleeps at once.
+ *
+ * Only threads may lock a mutex; the owner must unlock it.
+ */
+#ifndef INCLUDE_MUTEX_H
+#define INCLUDE_MUTEX_H
+/******************************************* Includes */
+#include "sched.h"
+#include "wait.h"
+
+/******************************************* Defines */
+/** Spin rounds while the owner runs on another CPU */
+#define MUTEX_SPIN_MAX          1000U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct MUTEX_STATS
+ * @brief Counters of one mutex
+ */
+typedef struct _MUTEX_STATS
+{
+    unsigned int acquired;
+    unsigned int contended;           /**< Locks that missed the fast path */
+    unsigned int spins;               /**< Contended locks taken while spinning */
+    unsigned int sleeps;              /**< Times a locker slept */
+} MUTEX_STATS;
+
+/**
+ * @struct MUTEX
+ * @brief A sleeping lock
+ */
+typedef struct _MUTEX
+{
+    void * volatile       owner;      /**< TASK holding it, NULL when free */
+    WAIT_QUEUE            wait;       /**< Exclusive waiters */
+    SCHED_PI              pi;         /**< Priority lent to the owner */
+    MUTEX_STATS           stats;
+} MUTEX;
+
+/******************************************* Macros */
+#define MUTEX_INIT              { NULL, WAIT_QUEUE_INIT, { NULL, 0, 0 }, { 0, 0, 0, 0 } }
+
+/******************************************* Protoytes */
+/**
+ * @name mutex_init
+ *
+ * @brief Sets up an unlocked mutex
+ */
+void mutex_init(MUTEX * m);
+
+/**
+ * @name mutex_lock
+ *
+ * @brief Takes the mutex, sleeping while another thread holds it
+ */
+void mutex_lock(MUTEX * m);
+
+/**
+ * @name mutex_trylock
+ *
+ * @brief Takes the mutex if it is free
+ *
+ * @return 1 if taken, 0 otherwise
+ */
+int mutex_trylock(MUTEX * m);
+
+/**
+ * @name mutex_unlock
+ *
+ * @brief Releases the mutex and wakes the first sleeper
+ */
+void mutex_unlock(MUTEX * m);
+
+/**
+ * @name mutex_is_locked
+ *
+ * @brief Returns 1 if a thread holds the mutex
+ */
+int mutex_is_locked(const MUTEX * m);
+
+#endif /* INCLUDE_MUTEX_H */
@@ -8,6 +8,9 @@
 /******************************************* Includes */
 
 /******************************************* Defines */
+#ifndef NULL
+#define NULL ((void *) 0)
+#endif
 
 /******************************************* Macros */
 
@@ -18,6 +21,24 @@
 #define GET_BYTE_FROM_VAL(val, byte_idx) \
         (((val) >> (8U * byte_idx)) & 0xFFU)
 
+/**
+ * @name Round value up to the given power of two alignment
+ */
+#define ALIGN_UP(val, align) \
+        (((val) + ((align) - 1U)) & ~((align) - 1U))
+
+/**
+ * @name Number of elements in a static array
+ */
+#define ARRAY_SIZE(arr) \
+        (sizeof(arr) / sizeof((arr)[0]))
+
+/**
+ * @name Structure of type holding member at ptr
+ */
+#define CONTAINER_OF(ptr, type, member) \
+        ((type *) ((char *) (ptr) - __builtin_offsetof(type, member)))
+
 /******************************************* Protoytes */
 
 #endif /* INCLUDE_OS_COMMON_H */
\ No newline at end of file
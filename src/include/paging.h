@@ -0,0 +1,128 @@
+/**
+ * @file paging.h
+ *
+ * @brief Header file for x86 32 bit paging
+ *
+ * @par RAM is identity mapped with 4 MiB pages, so kernel pointers are also
+ * physical addresses. On top of that a window of 4 KiB pages is available
+ * for remapping pages somewhere else (see vfs_mmap()).
+ */
+#ifndef INCLUDE_PAGING_H
+#define INCLUDE_PAGING_H
+/******************************************* Includes */
+#include "pmm.h"
+
+/******************************************* Defines */
+/* Page table / directory entry bits */
+#define PAGE_PRESENT            0x001U
+#define PAGE_RW                 0x002U
+#define PAGE_USER               0x004U
+#define PAGE_PWT                0x008U
+#define PAGE_PCD                0x010U
+#define PAGE_ACCESSED           0x020U
+#define PAGE_DIRTY              0x040U
+#define PAGE_LARGE              0x080U  /**< PDE maps a 4 MiB page (PSE) */
+#define PAGE_GLOBAL             0x100U
+
+/**
+ * Write-combining memory type for 4 KiB pages. paging_init() reprograms PAT
+ * entry 1, which is the one PWT alone selects, from write-through to WC.
+ */
+#define PAGE_WC                 PAGE_PWT
+
+#define PAGE_ENTRIES            1024U
+#define LARGE_PAGE_SIZE         0x00400000U
+
+/** Remap window for 4 KiB mappings */
+#define PAGING_WINDOW_START     0xD0000000U
+#define PAGING_WINDOW_SIZE      0x10000000U
+#define PAGING_WINDOW_PAGES     (PAGING_WINDOW_SIZE / PAGE_SIZE)
+
+/** PAT MSR and the memory type encodings we use */
+#define MSR_PAT                 0x277U
+#define PAT_TYPE_UC             0x00U
+#define PAT_TYPE_WC             0x01U
+#define PAT_TYPE_WT             0x04U
+#define PAT_TYPE_WB             0x06U
+#define PAT_TYPE_UC_MINUS       0x07U
+
+/* Return codes */
+#define PAGING_OK               0
+#define PAGING_ERR_NOMEM        (-1)
+
+/******************************************* Macros */
+#define PAGE_DIR_INDEX(va)      ((va) >> 22)
+#define PAGE_TABLE_INDEX(va)    (((va) >> 12) & 0x3FFU)
+
+/******************************************* Protoytes */
+/**
+ * @name paging_init
+ *
+ * @brief Identity maps [0, identity_end) with 4 MiB pages and turns paging on
+ *
+ * @param identity_end End of the identity mapping (rounded up to 4 MiB)
+ */
+void paging_init(unsigned int identity_end);
+
+/**
+ * @name paging_map_page
+ *
+ * @brief Maps one 4 KiB page inside the remap window
+ *
+ * @param virt  Virtual address (page aligned, inside the window)
+ * @param phys  Physical address (page aligned)
+ * @param flags PAGE_* bits, PAGE_PRESENT is implied
+ * @return      PAGING_OK or PAGING_ERR_NOMEM
+ */
+int paging_map_page(unsigned int virt, unsigned int phys, unsigned int flags);
+
+/**
+ * @name paging_unmap_page
+ *
+ * @brief Removes a mapping made by @ref paging_map_page
+ */
+void paging_unmap_page(unsigned int virt);
+
+/**
+ * @name paging_virt_to_phys
+ *
+ * @brief Translates a mapped virtual address (0 if not mapped)
+ */
+unsigned int paging_virt_to_phys(unsigned int virt);
+
+/**
+ * @name paging_alloc_virt
+ *
+ * @brief Reserves pages of address space in the remap window
+ *
+ * @return The first virtual address, or 0 if the window is full
+ */
+unsigned int paging_alloc_virt(unsigned int pages);
+
+/**
+ * @name paging_map_phys
+ *
+ * @brief Maps a physical range, e.g. device memory, into the remap window
+ *
+ * @param phys  Physical start (need not be page aligned)
+ * @param len   Length in bytes
+ * @param flags PAGE_* bits such as PAGE_RW | PAGE_WC
+ * @return      Virtual address of phys, or NULL
+ */
+void * paging_map_phys(unsigned int phys, unsigned int len, unsigned int flags);
+
+/**
+ * @name paging_has_wc
+ *
+ * @brief Returns 1 if PAGE_WC really selects write-combining (PAT present)
+ */
+int paging_has_wc(void);
+
+/**
+ * @name paging_free_virt
+ *
+ * @brief Returns address space from @ref paging_alloc_virt
+ */
+void paging_free_virt(unsigned int virt, unsigned int pages);
+
+#endif /* INCLUDE_PAGING_H */
@@ -0,0 +1,93 @@
+/**
+ * @file pmm.h
+ *
+ * @brief Header file for the physical page frame allocator
+ */
+#ifndef INCLUDE_PMM_H
+#define INCLUDE_PMM_H
+/******************************************* Includes */
+#include "multiboot.h"
+
+/******************************************* Defines */
+#define PAGE_SIZE               4096U
+#define PAGE_SHIFT              12U
+#define PAGE_MASK               (~(PAGE_SIZE - 1U))
+
+/** Highest physical address we manage, the bitmap is sized for it */
+#define PMM_MAX_MEMORY          0x40000000U
+#define PMM_MAX_PAGES           (PMM_MAX_MEMORY / PAGE_SIZE)
+
+/** Memory below this (BIOS, VGA, ROMs) is never handed out */
+#define PMM_LOW_MEMORY_END      0x00100000U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct PMM_STATS
+ * @brief Page counters
+ */
+typedef struct _PMM_STATS
+{
+    unsigned int total_pages;     /**< Pages of usable RAM */
+    unsigned int free_pages;      /**< Pages currently free */
+} PMM_STATS;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name pmm_init
+ *
+ * @brief Builds the free page bitmap from the multiboot memory map
+ *
+ * @par The kernel image, the boot information and all modules are reserved.
+ *
+ * @param mb_info The multiboot information (NULL: assume 32 MiB)
+ */
+void pmm_init(const MULTIBOOT_INFO * mb_info);
+
+/**
+ * @name pmm_alloc_pages
+ *
+ * @brief Allocates physically contiguous pages
+ *
+ * @param count Number of pages
+ * @return      Physical (= identity mapped) address, or NULL
+ */
+void * pmm_alloc_pages(unsigned int count);
+
+/**
+ * @name pmm_alloc_page
+ *
+ * @brief Allocates one page, see @ref pmm_alloc_pages
+ */
+void * pmm_alloc_page(void);
+
+/**
+ * @name pmm_free_pages
+ *
+ * @brief Returns pages from @ref pmm_alloc_pages
+ */
+void pmm_free_pages(void * addr, unsigned int count);
+
+/**
+ * @name pmm_free_page
+ *
+ * @brief Returns a page from @ref pmm_alloc_page
+ */
+void pmm_free_page(void * addr);
+
+/**
+ * @name pmm_memory_end
+ *
+ * @brief Returns the end of the highest usable RAM region
+ */
+unsigned int pmm_memory_end(void);
+
+/**
+ * @name pmm_get_stats
+ *
+ * @brief Returns the page counters
+ */
+const PMM_STATS * pmm_get_stats(void);
+
+#endif /* INCLUDE_PMM_H */
@@ -0,0 +1,73 @@
+/**
+ * @file radix_tree.h
+ *
+ * @brief Header file for the radix tree (page cache index)
+ */
+#ifndef INCLUDE_RADIX_TREE_H
+#define INCLUDE_RADIX_TREE_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** Index bits resolved per level */
+#define RADIX_TREE_MAP_SHIFT    6U
+#define RADIX_TREE_MAP_SIZE     (1U << RADIX_TREE_MAP_SHIFT)
+#define RADIX_TREE_MAP_MASK     (RADIX_TREE_MAP_SIZE - 1U)
+
+/** Levels needed for a full 32 bit index */
+#define RADIX_TREE_MAX_HEIGHT   6U
+
+/* Return codes */
+#define RADIX_TREE_OK           0
+#define RADIX_TREE_ERR_NOMEM    (-1)
+#define RADIX_TREE_ERR_EXIST    (-2)
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct RADIX_TREE
+ * @brief Root of a tree mapping unsigned int indices to pointers
+ *
+ * @note A zeroed structure is an empty tree. Nodes are 64 pointer arrays,
+ * so a tree of height h covers indices below 64^h.
+ */
+typedef struct _RADIX_TREE
+{
+    unsigned int  height;         /**< Levels below the root pointer */
+    void        **root;           /**< Top node */
+} RADIX_TREE;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name radix_tree_lookup
+ *
+ * @brief Returns the item at index, or NULL
+ */
+void * radix_tree_lookup(const RADIX_TREE * tree, unsigned int index);
+
+/**
+ * @name radix_tree_insert
+ *
+ * @brief Stores a non NULL item at index, growing the tree as needed
+ *
+ * @return RADIX_TREE_OK, RADIX_TREE_ERR_NOMEM or RADIX_TREE_ERR_EXIST
+ */
+int radix_tree_insert(RADIX_TREE * tree, unsigned int index, void * item);
+
+/**
+ * @name radix_tree_delete
+ *
+ * @brief Removes and returns the item at index (NULL if none)
+ *
+ * @note Emptied nodes are kept, they are freed by @ref radix_tree_destroy.
+ */
+void * radix_tree_delete(RADIX_TREE * tree, unsigned int index);
+
+/**
+ * @name radix_tree_destroy
+ *
+ * @brief Frees all nodes, calling release (if not NULL) for every item
+ */
+void radix_tree_destroy(RADIX_TREE * tree, void (*release)(void * item));
+
+#endif /* INCLUDE_RADIX_TREE_H */
@@ -0,0 +1,140 @@
+/**
+ * @file rcu.h
+ *
+ * @brief Header file for read-copy-update
+ *
+ * @par Readers of an RCU protected pointer take no lock and write no shared
+ * memory: @ref rcu_read_lock only disables preemption on their CPU. A writer
+ * publishes a new version with @ref rcu_assign_pointer and may free the old
+ * one once every CPU went through a quiescent state, a point where it
+ * cannot be inside a reader: a context switch or a pass of the idle loop
+ * (see @ref schedule). That wait is a grace period; @ref synchronize_rcu
+ * sleeps through one, @ref call_rcu queues a callback to run after one.
+ *
+ * Writers still have to serialise among themselves. Callbacks run in the
+ * CPU's rcu thread, in the order they were queued; they must not sleep.
+ * As that thread is no kworker, work items may call @ref synchronize_rcu.
+ *
+ * Readers may nest and may run in interrupt handlers. They must not sleep:
+ * a reader that does holds off every grace period until it leaves.
+ */
+#ifndef INCLUDE_RCU_H
+#define INCLUDE_RCU_H
+/******************************************* Includes */
+#include "cpu.h"
+#include "sched.h"
+
+/******************************************* Defines */
+/* Return codes */
+#define RCU_OK                  0
+#define RCU_ERR_NOMEM           (-1)    /**< No memory for the callback threads */
+
+/******************************************* Typedefs/structures */
+struct _RCU_HEAD;
+
+/**
+ * @name RCU_FUNC
+ *
+ * @brief Callback run after a grace period, usually frees the container of
+ * the head
+ */
+typedef void (*RCU_FUNC)(struct _RCU_HEAD * head);
+
+/**
+ * @struct RCU_HEAD
+ * @brief Embedded in an object retired with call_rcu()
+ */
+typedef struct _RCU_HEAD
+{
+    struct _RCU_HEAD   *next;
+    RCU_FUNC            func;
+} RCU_HEAD;
+
+/**
+ * @struct RCU_STATS
+ * @brief Grace period and callback counters
+ */
+typedef struct _RCU_STATS
+{
+    unsigned int        gp_started;
+    unsigned int        gp_completed;
+    unsigned int        qs;           /**< Quiescent states that ended a CPU's part */
+    unsigned int        queued;       /**< call_rcu() calls */
+    unsigned int        invoked;      /**< Callbacks run */
+    unsigned int        syncs;        /**< synchronize_rcu() calls */
+    unsigned long long  gp_sum;       /**< Cycles from start to end of a grace period */
+    unsigned long long  gp_max;
+} RCU_STATS;
+
+/******************************************* Macros */
+/**
+ * @name rcu_read_lock / rcu_read_unlock
+ *
+ * @brief Bracket a reader
+ */
+#define rcu_read_lock()         preempt_disable()
+#define rcu_read_unlock()       preempt_enable()
+
+/**
+ * @name rcu_dereference
+ *
+ * @brief Loads an RCU protected pointer inside a reader
+ *
+ * @par x86 does not reorder dependent loads, a volatile load is enough.
+ */
+#define rcu_dereference(p)      (*(__typeof__(p) volatile *) &(p))
+
+/**
+ * @name rcu_assign_pointer
+ *
+ * @brief Publishes v in p, the object's initialisation becomes visible first
+ */
+#define rcu_assign_pointer(p, v) \
+    do                                              \
+    {                                               \
+        wmb();                                      \
+        *(__typeof__(p) volatile *) &(p) = (v);     \
+    } while (0)
+
+/******************************************* Protoytes */
+/**
+ * @name call_rcu
+ *
+ * @brief Runs func(head) once a grace period has passed; may be called
+ * from interrupts
+ */
+void call_rcu(RCU_HEAD * head, RCU_FUNC func);
+
+/**
+ * @name synchronize_rcu
+ *
+ * @brief Sleeps until every reader that started before the call has ended
+ *
+ * @note Threads only, outside readers.
+ */
+void synchronize_rcu(void);
+
+/**
+ * @name rcu_barrier
+ *
+ * @brief Sleeps until every callback this CPU queued so far has run
+ */
+void rcu_barrier(void);
+
+/**
+ * @name rcu_note_qs
+ *
+ * @brief Reports a quiescent state of this CPU
+ *
+ * @note Called by the scheduler with interrupts disabled.
+ */
+void rcu_note_qs(void);
+
+/**
+ * @name rcu_get_stats
+ *
+ * @brief Returns the counters
+ */
+const RCU_STATS * rcu_get_stats(void);
+
+#endif /* INCLUDE_RCU_H */
@@ -0,0 +1,209 @@
+/**
+ * @file sched.h
+ *
+ * @brief Header file for kernel threads and the scheduler
+ *
+ * @par Kernel threads are scheduled cooperatively: a thread runs until it
+ * sleeps or calls @ref sched_yield. The next thread is the runnable one with
+ * the lowest priority value, round robin among equals; every thread starts
+ * at SCHED_PRIO_DEFAULT. A thread holding a lock a more urgent one waits
+ * for runs at the waiter's priority until it unlocks (@ref sched_pi_boost).
+ * Interrupt handlers may wake a thread, which then runs at the next
+ * scheduling point of the current one. When no thread is runnable the CPU
+ * halts inside @ref schedule until an interrupt wakes one.
+ *
+ * kmain() becomes the first thread (the shell), the rest are created with
+ * @ref kthread_create.
+ *
+ * Every call of @ref schedule outside a @ref preempt_disable section, and
+ * every pass of its idle loop, is an RCU quiescent state of the CPU
+ * (rcu.h).
+ */
+#ifndef INCLUDE_SCHED_H
+#define INCLUDE_SCHED_H
+/******************************************* Includes */
+#include "ftrace.h"
+
+/******************************************* Defines */
+/** Kernel stack of a thread */
+#define KTHREAD_STACK_PAGES     2U
+
+/* Task states */
+#define TASK_RUNNABLE           0U
+#define TASK_SLEEPING           1U
+#define TASK_DEAD               2U
+
+/* Priorities, lower values run first */
+#define SCHED_PRIO_HIGH         0U
+#define SCHED_PRIO_DEFAULT      8U
+#define SCHED_PRIO_LOW          15U
+
+/* Return codes */
+#define SCHED_OK                0
+#define SCHED_ERR_NOMEM         (-1)
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct SCHED_PI
+ * @brief The priority a sleeping lock lends its owner, embedded in the lock
+ */
+typedef struct _SCHED_PI
+{
+    struct _SCHED_PI   *next;         /**< Other lending locks of the owner */
+    unsigned int        prio;         /**< Most urgent waiter of this owner */
+    unsigned int        lent;         /**< On the owner's pi_held list */
+} SCHED_PI;
+
+/**
+ * @struct TASK
+ * @brief A kernel thread
+ */
+typedef struct _TASK
+{
+    unsigned int        esp;          /**< Saved stack pointer, must stay first */
+    volatile unsigned int state;      /**< TASK_* */
+    const char         *name;
+    void              (*fn)(void * arg);
+    void               *arg;
+    void               *stack;        /**< Stack pages, NULL for the boot thread */
+    struct _TASK       *next;         /**< Ring of all tasks */
+    volatile unsigned int on_cpu;     /**< Set while running */
+    unsigned int        prio;         /**< Effective priority, may be boosted */
+    unsigned int        base_prio;    /**< Priority set by sched_set_prio() */
+    unsigned int        pi_boosts;    /**< Times boosted by a lock waiter */
+    SCHED_PI           *pi_held;      /**< Held locks with waiters */
+    unsigned int        switches;     /**< Times switched to */
+    unsigned long long  run_cycles;   /**< TSC cycles spent running */
+    unsigned long long  run_start;    /**< TSC when last switched to */
+    unsigned int        trace_depth;  /**< Open traced calls */
+    FTRACE_FRAME        trace[FTRACE_MAX_DEPTH];
+} TASK;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name sched_init
+ *
+ * @brief Turns the boot thread into a task
+ */
+void sched_init(void);
+
+/**
+ * @name kthread_create
+ *
+ * @brief Creates a runnable kernel thread
+ *
+ * @par The thread starts with interrupts enabled. If fn returns the thread
+ * is reaped by a later kthread_create().
+ *
+ * @return The task, or NULL without memory
+ */
+TASK * kthread_create(const char * name, void (*fn)(void * arg), void * arg);
+
+/**
+ * @name sched_current
+ *
+ * @brief Returns the running task
+ */
+TASK * sched_current(void);
+
+/**
+ * @name schedule
+ *
+ * @brief Switches to the next runnable task
+ *
+ * @par The current task keeps running if it is the only runnable one. A
+ * task that set itself TASK_SLEEPING (with interrupts disabled, after
+ * checking its wakeup condition) stays off the CPU until @ref sched_wake.
+ */
+void schedule(void);
+
+/**
+ * @name sched_yield
+ *
+ * @brief Lets other runnable tasks run
+ *
+ * @return 1 if another task ran, 0 if there was none
+ */
+int sched_yield(void);
+
+/**
+ * @name sched_wake
+ *
+ * @brief Makes a sleeping task runnable, may be called from interrupts
+ */
+void sched_wake(TASK * task);
+
+/**
+ * @name sched_need_resched
+ *
+ * @brief Returns 1 if a task was woken since the last switch
+ */
+int sched_need_resched(void);
+
+/**
+ * @name preempt_disable / preempt_enable
+ *
+ * @brief Nest a per-CPU count of sections that must not give up the CPU
+ *
+ * @par Threads are never preempted, so the count only tells the scheduler
+ * that a switch now would not be a quiescent state. A thread that sleeps
+ * inside such a section holds off RCU grace periods until it leaves it.
+ */
+void preempt_disable(void);
+void preempt_enable(void);
+
+/**
+ * @name preempt_count
+ *
+ * @brief Returns the nesting of preempt_disable() on this CPU
+ */
+unsigned int preempt_count(void);
+
+/**
+ * @name sched_set_prio
+ *
+ * @brief Sets the priority of a task, SCHED_PRIO_*
+ */
+void sched_set_prio(TASK * task, unsigned int prio);
+
+/**
+ * @name sched_pi_boost / sched_pi_restore
+ *
+ * @brief Priority inheritance: a lock owner runs at least at the priority
+ * of a waiter, until it drops the lock
+ *
+ * @par Each lock keeps what its waiters lent, so dropping one lock only
+ * takes back that lock's boost: the owner falls back to the most urgent
+ * of its own priority and those of the other locks it still holds.
+ *
+ * @note Called with interrupts disabled by the sleeping locks.
+ */
+void sched_pi_boost(TASK * owner, SCHED_PI * pi, const TASK * waiter);
+void sched_pi_restore(TASK * task, SCHED_PI * pi);
+
+/**
+ * @name sched_task_cycles
+ *
+ * @brief Returns the cycles a task ran, including its current slice
+ */
+unsigned long long sched_task_cycles(const TASK * task);
+
+/**
+ * @name sched_for_each
+ *
+ * @brief Calls fn for every task, for the statistics
+ */
+void sched_for_each(void (*fn)(const TASK * task));
+
+/**
+ * @name sched_switch
+ *
+ * @brief Saves the callee-saved registers and esp, then resumes next
+ *
+ * @note Implemented in switch.s.
+ */
+void sched_switch(unsigned int * prev_esp, unsigned int next_esp);
+
+#endif /* INCLUDE_SCHED_H */
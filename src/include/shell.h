@@ -0,0 +1,54 @@
+/**
+ * @file shell.h
+ *
+ * @brief Header file for the kernel console shell
+ *
+ * @par The shell reads lines from the keyboard and COM1 through the input
+ * rings with a minimal line discipline (echo, backspace, ^U to kill the line,
+ * ^C to abandon it) and runs built-in commands to start benchmarks and dump
+ * statistics at runtime.
+ */
+#ifndef INCLUDE_SHELL_H
+#define INCLUDE_SHELL_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** Longest input line */
+#define SHELL_LINE_MAX          128U
+/** Most words on a line, the command included */
+#define SHELL_MAX_ARGS          8U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct SHELL_COMMAND
+ * @brief A built-in command
+ */
+typedef struct _SHELL_COMMAND
+{
+    const char  *name;                /**< Word that runs it */
+    const char  *help;                /**< One line description */
+    void       (*run)(unsigned int argc, char ** argv);
+} SHELL_COMMAND;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name shell_readline
+ *
+ * @brief Reads one line with echo and line editing
+ *
+ * @param buf  Where to store the line, NUL terminated without the newline
+ * @param size Size of buf
+ * @return     Length of the line
+ */
+unsigned int shell_readline(char * buf, unsigned int size);
+
+/**
+ * @name shell_run
+ *
+ * @brief Prompts for and runs commands forever
+ */
+void shell_run(void);
+
+#endif /* INCLUDE_SHELL_H */
@@ -0,0 +1,120 @@
+/**
+ * @file softirq.h
+ *
+ * @brief Header file for softirq bottom halves
+ *
+ * @par An interrupt handler does the minimum with interrupts disabled and
+ * raises a softirq for the rest. Pending softirqs run on the way out of the
+ * outermost interrupt, with interrupts enabled, so other lines are not held
+ * off meanwhile.
+ *
+ * One exit runs them for at most SOFTIRQ_MAX_RESTART passes and
+ * SOFTIRQ_BUDGET_US; whatever is still pending after that is handed to the
+ * ksoftirqd thread, so an interrupt storm cannot starve the threads.
+ *
+ * Softirq handlers must not sleep.
+ */
+#ifndef INCLUDE_SOFTIRQ_H
+#define INCLUDE_SOFTIRQ_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/* Softirq numbers, lower numbers run first */
+#define SOFTIRQ_SERIAL          0U      /**< COM1 transmit FIFO refill */
+#define SOFTIRQ_BLK             1U      /**< virtio-blk completions */
+#define SOFTIRQ_NR              2U
+
+/** Passes over the pending mask per interrupt exit */
+#define SOFTIRQ_MAX_RESTART     10U
+/** Time per interrupt exit before handing over to ksoftirqd */
+#define SOFTIRQ_BUDGET_US       2000U
+
+/******************************************* Typedefs/structures */
+/**
+ * @name SOFTIRQ_HANDLER
+ *
+ * @brief Bottom half, runs with interrupts enabled
+ */
+typedef void (*SOFTIRQ_HANDLER)(void);
+
+/**
+ * @struct SOFTIRQ_STATS
+ * @brief Counters of one softirq
+ */
+typedef struct _SOFTIRQ_STATS
+{
+    unsigned int       raised;        /**< softirq_raise() calls */
+    unsigned int       runs;          /**< Handler invocations */
+    unsigned long long lat_sum;       /**< Cycles from the first raise to the run */
+    unsigned long long lat_max;
+    unsigned long long run_sum;       /**< Cycles spent in the handler */
+    unsigned long long run_max;
+} SOFTIRQ_STATS;
+
+/**
+ * @struct SOFTIRQ_CPU_STATS
+ * @brief Per-CPU softirq counters
+ */
+typedef struct _SOFTIRQ_CPU_STATS
+{
+    unsigned int irq_exits;           /**< Interrupt exits that ran softirqs */
+    unsigned int restarts;            /**< Extra passes within one exit */
+    unsigned int handoffs;            /**< Budget exceeded, left to ksoftirqd */
+    unsigned int thread_runs;         /**< Passes run by ksoftirqd */
+} SOFTIRQ_CPU_STATS;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name softirq_open
+ *
+ * @brief Installs the handler of a softirq
+ */
+void softirq_open(unsigned int nr, SOFTIRQ_HANDLER handler);
+
+/**
+ * @name softirq_raise
+ *
+ * @brief Marks a softirq pending on this CPU
+ *
+ * @par Lock-free, may be called from interrupt handlers and threads. From a
+ * thread the softirq runs at the next interrupt exit or in ksoftirqd.
+ */
+void softirq_raise(unsigned int nr);
+
+/**
+ * @name irq_enter / irq_exit
+ *
+ * @brief Bracket a hardware interrupt handler
+ *
+ * @par irq_exit() runs the pending softirqs when leaving the outermost
+ * interrupt. Called by interrupt_dispatch() with interrupts disabled.
+ */
+void irq_enter(void);
+void irq_exit(void);
+
+/**
+ * @name in_interrupt
+ *
+ * @brief Returns 1 in an interrupt handler or a softirq, where sleeping is
+ * not allowed
+ */
+int in_interrupt(void);
+
+/**
+ * @name softirq_get_stats / softirq_get_cpu_stats
+ *
+ * @brief Return the counters
+ */
+const SOFTIRQ_STATS * softirq_get_stats(unsigned int nr);
+const SOFTIRQ_CPU_STATS * softirq_get_cpu_stats(unsigned int cpu);
+
+/**
+ * @name softirq_reset_stats
+ *
+ * @brief Clears all counters
+ */
+void softirq_reset_stats(void);
+
+#endif /* INCLUDE_SOFTIRQ_H */
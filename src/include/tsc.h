@@ -0,0 +1,48 @@
+/**
+ * @file tsc.h
+ *
+ * @brief Header file for time stamp counter calibration
+ */
+#ifndef INCLUDE_TSC_H
+#define INCLUDE_TSC_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/** PIT input clock in Hz */
+#define PIT_FREQUENCY_HZ            1193182U
+
+/* PIT and speaker ports used to gate channel 2 */
+#define PIT_CHANNEL2_DATA_PORT      0x42
+#define PIT_COMMAND_PORT            0x43
+#define PIT_SPEAKER_PORT            0x61
+
+/** Calibration window in milliseconds */
+#define TSC_CALIBRATE_MS            10U
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name tsc_calibrate
+ *
+ * @brief Measures the TSC frequency against PIT channel 2
+ *
+ * @return The TSC frequency in kHz
+ */
+unsigned int tsc_calibrate(void);
+
+/**
+ * @name tsc_khz
+ *
+ * @brief Returns the calibrated TSC frequency in kHz (0 before calibration)
+ */
+unsigned int tsc_khz(void);
+
+/**
+ * @name tsc_cycles_to_us
+ *
+ * @brief Converts a cycle count to microseconds
+ */
+unsigned long long tsc_cycles_to_us(unsigned long long cycles);
+
+#endif /* INCLUDE_TSC_H */
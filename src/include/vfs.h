@@ -0,0 +1,272 @@
+/**
+ * @file vfs.h
+ *
+ * @brief Header file for the virtual filesystem layer
+ *
+ * @par Filesystems register an FS_TYPE and provide two inode operations:
+ * lookup of a name in a directory and reading one page of a file. Those
+ * whose files already sit page aligned in memory may hand out the pages
+ * themselves instead (getpage). Everything else is done here:
+ * - path walks go through a hashed dentry cache, which also remembers names
+ *   that do not exist (negative dentries),
+ * - file data is read through a per-inode page cache indexed by a radix tree,
+ * - vfs_mmap() maps the cached pages themselves, so nothing is copied.
+ *
+ * Block reads may sleep, so lookups that miss the dentry cache are
+ * serialised, and so are page cache fills of a filesystem (SUPER_BLOCK
+ * lock). A filesystem's own shared buffers may rely on the latter.
+ */
+#ifndef INCLUDE_VFS_H
+#define INCLUDE_VFS_H
+/******************************************* Includes */
+#include "radix_tree.h"
+#include "mutex.h"
+
+/******************************************* Defines */
+/* Inode types */
+#define VFS_MODE_FILE           1U
+#define VFS_MODE_DIR            2U
+
+/** Dentry hash buckets (power of two) */
+#define VFS_DCACHE_BUCKETS      256U
+/** Upper bound on negative dentries, beyond it misses are simply not cached */
+#define VFS_DCACHE_MAX_NEGATIVE 1024U
+
+/* Return codes */
+#define VFS_OK                  0
+#define VFS_ERR_NOENT           (-1)    /**< No such file or directory */
+#define VFS_ERR_NOTDIR          (-2)    /**< Path component is not a directory */
+#define VFS_ERR_ISDIR           (-3)    /**< Is a directory */
+#define VFS_ERR_NOMEM           (-4)    /**< Out of memory */
+#define VFS_ERR_IO              (-5)    /**< Filesystem or device error */
+#define VFS_ERR_INVAL           (-6)    /**< Bad argument */
+#define VFS_ERR_NOFS            (-7)    /**< Unknown filesystem type */
+
+/******************************************* Typedefs/structures */
+struct _INODE;
+struct _SUPER_BLOCK;
+
+/**
+ * @struct INODE_OPS
+ * @brief Filesystem specific inode operations
+ */
+typedef struct _INODE_OPS
+{
+    /**
+     * Looks up name (len characters, not NUL terminated) in dir and sets
+     * out to a new inode. Returns VFS_OK, VFS_ERR_NOENT if there is no such
+     * entry, or another error; only VFS_ERR_NOENT is cached.
+     */
+    int (*lookup)(struct _INODE * dir, const char * name, unsigned int len,
+                  struct _INODE ** out);
+
+    /**
+     * Fills the 4 KiB page with file data from offset index * PAGE_SIZE,
+     * zeroing whatever lies beyond the end of the file. Returns VFS_OK.
+     */
+    int (*readpage)(struct _INODE * inode, unsigned int index, void * page);
+
+    /**
+     * Optional. Returns the page in memory that already holds the file data
+     * from offset index * PAGE_SIZE, zeroed beyond the end of the file; the
+     * page cache then uses it as is and never frees it. NULL falls back to
+     * readpage.
+     */
+    void * (*getpage)(struct _INODE * inode, unsigned int index);
+} INODE_OPS;
+
+/**
+ * @struct INODE
+ * @brief An in-memory file or directory
+ */
+typedef struct _INODE
+{
+    unsigned int          ino;        /**< Filesystem inode number */
+    unsigned int          mode;       /**< VFS_MODE_* */
+    unsigned int          size;       /**< Size in bytes */
+    struct _SUPER_BLOCK  *sb;         /**< Owning filesystem */
+    const INODE_OPS      *ops;        /**< Operations */
+    void                 *priv;       /**< Filesystem private data */
+    RADIX_TREE            pages;      /**< Page cache, page index -> page */
+    unsigned int          nr_pages;   /**< Pages in the page cache */
+} INODE;
+
+/**
+ * @struct SUPER_BLOCK
+ * @brief A mounted filesystem instance
+ */
+typedef struct _SUPER_BLOCK
+{
+    const struct _FS_TYPE *type;      /**< Filesystem type */
+    INODE                 *root;      /**< Root directory, set by mount */
+    void                  *priv;      /**< Filesystem private data */
+    MUTEX                  lock;      /**< Held across readpage / getpage */
+} SUPER_BLOCK;
+
+/**
+ * @struct FS_TYPE
+ * @brief A filesystem driver
+ */
+typedef struct _FS_TYPE
+{
+    const char       *name;           /**< Name used by vfs_mount() */
+    /** Reads the filesystem from data and sets sb->root, returns VFS_OK */
+    int             (*mount)(SUPER_BLOCK * sb, void * data);
+    struct _FS_TYPE  *next;           /**< Registry link */
+} FS_TYPE;
+
+/**
+ * @struct DENTRY
+ * @brief A cached path component
+ */
+typedef struct _DENTRY
+{
+    struct _DENTRY *hash_next;        /**< Dentry hash chain */
+    struct _DENTRY *parent;           /**< Parent directory (NULL for "/") */
+    struct _DENTRY *mounted;          /**< Root of a filesystem mounted here */
+    INODE          *inode;            /**< NULL for a negative dentry */
+    unsigned int    hash;             /**< Hash of parent and name */
+    unsigned int    name_len;         /**< Length of name */
+    char            name[];           /**< Component, NUL terminated */
+} DENTRY;
+
+/**
+ * @struct VFS_FILE
+ * @brief An open file
+ */
+typedef struct _VFS_FILE
+{
+    INODE        *inode;              /**< The file */
+    unsigned int  pos;                /**< Read position */
+} VFS_FILE;
+
+/**
+ * @struct VFS_STATS
+ * @brief Cache counters
+ */
+typedef struct _VFS_STATS
+{
+    unsigned int dcache_hits;         /**< Components found in the dentry cache */
+    unsigned int dcache_neg_hits;     /**< ... of which were negative entries */
+    unsigned int dcache_misses;       /**< Components that went to the filesystem */
+    unsigned int dcache_entries;      /**< Dentries allocated */
+    unsigned int dcache_negative;     /**< ... of which are negative */
+    unsigned int page_hits;           /**< Pages found in the page cache */
+    unsigned int page_misses;         /**< Pages read from the filesystem */
+    unsigned int page_cached;         /**< Pages held by all page caches */
+    unsigned int mmap_pages;          /**< Pages currently mapped by vfs_mmap() */
+} VFS_STATS;
+
+/******************************************* Macros */
+
+/******************************************* Protoytes */
+/**
+ * @name vfs_init
+ *
+ * @brief Creates the root dentry
+ */
+void vfs_init(void);
+
+/**
+ * @name vfs_register_fs
+ *
+ * @brief Makes a filesystem type available to vfs_mount()
+ */
+void vfs_register_fs(FS_TYPE * type);
+
+/**
+ * @name vfs_mount
+ *
+ * @brief Mounts a filesystem on path
+ *
+ * @param path    Mount point, "/" for the root filesystem
+ * @param fs_name Registered filesystem type
+ * @param data    Passed to the type's mount (e.g. a BLK_DEVICE)
+ * @return        VFS_OK or an error
+ */
+int vfs_mount(const char * path, const char * fs_name, void * data);
+
+/**
+ * @name vfs_new_inode
+ *
+ * @brief Allocates a zeroed inode of sb for a filesystem's lookup/mount
+ */
+INODE * vfs_new_inode(SUPER_BLOCK * sb, unsigned int ino, unsigned int mode,
+                      unsigned int size, const INODE_OPS * ops);
+
+/**
+ * @name vfs_get_page
+ *
+ * @brief Returns a page of an inode from the page cache, reading it on a miss
+ *
+ * @par Filesystems use this for their own metadata too (e.g. directories).
+ *
+ * @return The page (owned by the cache), or NULL
+ */
+void * vfs_get_page(INODE * inode, unsigned int index);
+
+/**
+ * @name vfs_open
+ *
+ * @brief Opens a file for reading
+ *
+ * @param path Absolute path
+ * @param err  Set to the error if NULL is returned (may be NULL)
+ * @return     The open file, or NULL
+ */
+VFS_FILE * vfs_open(const char * path, int * err);
+
+/**
+ * @name vfs_read
+ *
+ * @brief Reads up to len bytes from the current position
+ *
+ * @return Bytes read (0 at end of file), or a negative error
+ */
+int vfs_read(VFS_FILE * file, void * buf, unsigned int len);
+
+/**
+ * @name vfs_seek
+ *
+ * @brief Sets the read position
+ */
+void vfs_seek(VFS_FILE * file, unsigned int pos);
+
+/**
+ * @name vfs_close
+ *
+ * @brief Closes a file from @ref vfs_open
+ */
+void vfs_close(VFS_FILE * file);
+
+/**
+ * @name vfs_mmap
+ *
+ * @brief Maps part of a file read-only into the kernel address space
+ *
+ * @par The page cache pages themselves are mapped, so reads through the
+ * mapping cost nothing beyond the memory access. Pages not yet cached are
+ * read first.
+ *
+ * @param file   The file
+ * @param offset Start in the file, page aligned
+ * @param len    Length in bytes (rounded up to whole pages)
+ * @return       The mapping, or NULL
+ */
+void * vfs_mmap(VFS_FILE * file, unsigned int offset, unsigned int len);
+
+/**
+ * @name vfs_munmap
+ *
+ * @brief Removes a mapping made by @ref vfs_mmap, the pages stay cached
+ */
+void vfs_munmap(void * addr, unsigned int len);
+
+/**
+ * @name vfs_get_stats
+ *
+ * @brief Returns the cache counters
+ */
+const VFS_STATS * vfs_get_stats(void);
+
+#endif /* INCLUDE_VFS_H */
@@ -0,0 +1,194 @@
+/**
+ * @file wait.h
+ *
+ * @brief Header file for wait queues and completions
+ *
+ * @par A thread waiting for a condition queues a WAIT_ENTRY on its stack,
+ * marks itself TASK_SLEEPING and calls @ref schedule; whoever makes the
+ * condition true calls @ref wake_up, from a thread or an interrupt. The
+ * condition is checked after queueing with interrupts disabled, so a wakeup
+ * between the check and the sleep is not lost.
+ *
+ * Exclusive waiters (a lock, a free slot) are woken one per wake_up() in
+ * FIFO order, which avoids waking every waiter to have all but one of them
+ * go back to sleep. Non-exclusive waiters (an event everyone wants to see)
+ * are all woken each time, before the exclusive ones.
+ *
+ * Only threads may wait. Interrupts, softirqs and code running with
+ * interrupts disabled must poll instead.
+ */
+#ifndef INCLUDE_WAIT_H
+#define INCLUDE_WAIT_H
+/******************************************* Includes */
+#include "cpu.h"
+#include "sched.h"
+
+/******************************************* Defines */
+/** WAIT_ENTRY flag, woken one at a time */
+#define WAIT_EXCLUSIVE          0x1U
+
+/** wake_up_nr() count that wakes every exclusive waiter */
+#define WAIT_WAKE_ALL           0xFFFFFFFFU
+
+/** COMPLETION done count set by complete_all() */
+#define COMPLETION_DONE_ALL     0xFFFFFFFFU
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct WAIT_ENTRY
+ * @brief A waiting thread, lives on its stack
+ */
+typedef struct _WAIT_ENTRY
+{
+    struct _WAIT_ENTRY *next;
+    TASK               *task;
+    unsigned int        flags;        /**< WAIT_EXCLUSIVE */
+    unsigned int        queued;       /**< Cleared by the wakeup that dequeued it */
+} WAIT_ENTRY;
+
+/**
+ * @struct WAIT_QUEUE
+ * @brief Non-exclusive waiters first, then exclusive ones in arrival order
+ */
+typedef struct _WAIT_QUEUE
+{
+    WAIT_ENTRY         *head;
+} WAIT_QUEUE;
+
+/**
+ * @struct COMPLETION
+ * @brief Counts complete() calls not yet consumed by a waiter
+ */
+typedef struct _COMPLETION
+{
+    volatile unsigned int done;
+    WAIT_QUEUE            wait;
+} COMPLETION;
+
+/******************************************* Macros */
+#define WAIT_QUEUE_INIT         { NULL }
+#define COMPLETION_INIT         { 0, WAIT_QUEUE_INIT }
+
+/**
+ * @name wait_event / wait_event_exclusive
+ *
+ * @brief Sleeps on wq until cond is true
+ *
+ * @par cond is evaluated with interrupts disabled after every wakeup, it
+ * must not sleep. Returns at once, without queueing, if cond already holds.
+ */
+#define wait_event(wq, cond)            WAIT_EVENT((wq), (cond), 0U)
+#define wait_event_exclusive(wq, cond)  WAIT_EVENT((wq), (cond), WAIT_EXCLUSIVE)
+
+#define WAIT_EVENT(wq, cond, wflags)                \
+    do                                              \
+    {                                               \
+        WAIT_ENTRY __wait;                          \
+        unsigned int __flags;                       \
+                                                    \
+        if (cond)                                   \
+        {                                           \
+            break;                                  \
+        }                                           \
+        __flags = local_irq_save();                 \
+        wait_entry_init(&__wait, (wflags));         \
+        for (;;)                                    \
+        {                                           \
+            wait_prepare((wq), &__wait);            \
+            if (cond)                               \
+            {                                       \
+                break;                              \
+            }                                       \
+            schedule();                             \
+        }                                           \
+        wait_finish((wq), &__wait);                 \
+        local_irq_restore(__flags);                 \
+    } while (0)
+
+/**
+ * @name wake_up / wake_up_all
+ *
+ * @brief Wakes every non-exclusive waiter and one, or every, exclusive one
+ */
+#define wake_up(wq)             wake_up_nr((wq), 1U)
+#define wake_up_all(wq)         wake_up_nr((wq), WAIT_WAKE_ALL)
+
+/******************************************* Protoytes */
+/**
+ * @name wait_queue_init
+ *
+ * @brief Empties a wait queue
+ */
+void wait_queue_init(WAIT_QUEUE * wq);
+
+/**
+ * @name wait_entry_init
+ *
+ * @brief Ties an entry to the running thread
+ */
+void wait_entry_init(WAIT_ENTRY * entry, unsigned int flags);
+
+/**
+ * @name wait_prepare / wait_finish
+ *
+ * @brief Queue the entry (unless still queued) and mark the thread
+ * TASK_SLEEPING, then, once the condition holds, make it runnable and
+ * dequeue the entry
+ *
+ * @note Called with interrupts disabled, for loops wait_event() does not
+ * cover.
+ */
+void wait_prepare(WAIT_QUEUE * wq, WAIT_ENTRY * entry);
+void wait_finish(WAIT_QUEUE * wq, WAIT_ENTRY * entry);
+
+/**
+ * @name wake_up_nr
+ *
+ * @brief Wakes the non-exclusive waiters and up to nr exclusive ones,
+ * dequeueing them; may be called from interrupts
+ *
+ * @return The number of threads woken
+ */
+unsigned int wake_up_nr(WAIT_QUEUE * wq, unsigned int nr);
+
+/**
+ * @name waitqueue_active
+ *
+ * @brief Returns 1 if a thread waits, lets wakers skip the call
+ */
+int waitqueue_active(const WAIT_QUEUE * wq);
+
+/**
+ * @name completion_init / reinit_completion
+ *
+ * @brief Clears a completion before it is (re)used
+ */
+void completion_init(COMPLETION * c);
+void reinit_completion(COMPLETION * c);
+
+/**
+ * @name complete / complete_all
+ *
+ * @brief Lets one waiter, or every present and future one, through; may be
+ * called from interrupts
+ */
+void complete(COMPLETION * c);
+void complete_all(COMPLETION * c);
+
+/**
+ * @name wait_for_completion
+ *
+ * @brief Sleeps until the completion is signalled and consumes one count
+ */
+void wait_for_completion(COMPLETION * c);
+
+/**
+ * @name try_wait_for_completion
+ *
+ * @brief Consumes one count without sleeping
+ *
+ * @return 1 if there was one, 0 otherwise
+ */
+int try_wait_for_completion(COMPLETION * c);
+
+#endif /* INCLUDE_WAIT_H */
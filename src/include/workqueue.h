@@ -0,0 +1,102 @@
+/**
+ * @file workqueue.h
+ *
+ * @brief Header file for per-CPU workqueues
+ *
+ * @par Work items run in a kernel worker thread, one per CPU, so unlike
+ * softirqs they may take long and sleep. Queueing pushes the item on the
+ * CPU's list with a compare-and-swap and never takes a lock, so it is safe
+ * from interrupt handlers. The worker takes the whole list with one exchange
+ * and runs it oldest first.
+ */
+#ifndef INCLUDE_WORKQUEUE_H
+#define INCLUDE_WORKQUEUE_H
+/******************************************* Includes */
+
+/******************************************* Defines */
+/* Return codes */
+#define WORKQUEUE_OK            0
+#define WORKQUEUE_ERR_NOMEM     (-1)
+
+/******************************************* Typedefs/structures */
+struct _WORK;
+
+/**
+ * @name WORK_FUNC
+ *
+ * @brief Work function, gets the item so it can find its container
+ */
+typedef void (*WORK_FUNC)(struct _WORK * work);
+
+/**
+ * @struct WORK
+ * @brief A work item, usually embedded in the structure it works on
+ */
+typedef struct _WORK
+{
+    struct _WORK          *next;      /**< Queue link */
+    WORK_FUNC              fn;
+    volatile unsigned int  pending;   /**< Queued and not started yet */
+    unsigned long long     queued;    /**< TSC at queue time */
+} WORK;
+
+/**
+ * @struct WORKQUEUE_STATS
+ * @brief Counters of a CPU's workqueue
+ */
+typedef struct _WORKQUEUE_STATS
+{
+    unsigned int          queued;     /**< Items queued */
+    unsigned int          merged;     /**< Queued while already pending */
+    unsigned int          run;        /**< Items run */
+    volatile unsigned int depth;      /**< Items waiting now */
+    unsigned int          max_depth;
+    unsigned long long    lat_sum;    /**< Cycles from queueing to the start */
+    unsigned long long    lat_max;
+    unsigned long long    run_sum;    /**< Cycles spent in work functions */
+    unsigned long long    run_max;
+} WORKQUEUE_STATS;
+
+/******************************************* Macros */
+/** Static initialiser of a WORK */
+#define WORK_INIT(func)         { NULL, (func), 0, 0 }
+
+/******************************************* Protoytes */
+/**
+ * @name work_init
+ *
+ * @brief Initialises a WORK at run time
+ */
+void work_init(WORK * work, WORK_FUNC fn);
+
+/**
+ * @name queue_work
+ *
+ * @brief Queues work on this CPU's worker
+ *
+ * @return 1 if queued, 0 if it was still pending (it runs once)
+ */
+int queue_work(WORK * work);
+
+/**
+ * @name queue_work_on
+ *
+ * @brief Queues work on a given CPU's worker
+ */
+int queue_work_on(unsigned int cpu, WORK * work);
+
+/**
+ * @name workqueue_get_stats
+ *
+ * @brief Returns the counters of a CPU's workqueue
+ */
+const WORKQUEUE_STATS * workqueue_get_stats(unsigned int cpu);
+
+/**
+ * @name workqueue_reset_stats
+ *
+ * @brief Clears the counters, except the current depth
+ */
+void workqueue_reset_stats(void);
+
+#endif /* INCLUDE_WORKQUEUE_H */
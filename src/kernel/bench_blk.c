@@ -0,0 +1,208 @@
+/**
+ * @file bench_blk.c
+ *
+ * @brief Queue depth sweep benchmark for the virtio block driver
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "tsc.h"
+#include "kprintf.h"
+#include "virtio_blk.h"
+#include "bench.h"
+
+/******************************************* Defines */
+/** Size of each read */
+#define BENCH_BLK_IO_SIZE       4096U
+/** Deepest queue in the sweep */
+#define BENCH_BLK_MAX_QD        32U
+/** Reads issued per queue depth */
+#define BENCH_BLK_IOS           4096U
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+/**
+ * @struct BENCH_BLK_STATE
+ * @brief Counters of one sweep step
+ */
+typedef struct _BENCH_BLK_STATE
+{
+    volatile unsigned int completed;  /**< Reads finished, also counted by the bottom half */
+    unsigned int       errors;        /**< Reads that failed */
+    unsigned long long lat_sum;       /**< Sum of latencies in cycles */
+    unsigned long long lat_min;       /**< Smallest latency in cycles */
+    unsigned long long lat_max;       /**< Largest latency in cycles */
+} BENCH_BLK_STATE;
+
+static BENCH_BLK_STATE bench_blk;
+
+static BLK_REQUEST bench_blk_reqs[BENCH_BLK_MAX_QD];
+
+static unsigned char bench_blk_bufs[BENCH_BLK_MAX_QD][BENCH_BLK_IO_SIZE]
+    __attribute__((aligned(4096)));
+
+/** xorshift state for picking random blocks */
+static unsigned int bench_blk_seed = 0x2545F491U;
+
+/******************************************* Functions */
+
+/**
+ * @name bench_blk_done
+ *
+ * @brief Completion callback, accounts latency and frees the request
+ */
+static void bench_blk_done(BLK_REQUEST * req, int status)
+{
+    unsigned long long lat = rdtsc() - req->submit_tsc;
+
+    if (status != BLK_OK)
+    {
+        bench_blk.errors++;
+    }
+    bench_blk.completed++;
+    bench_blk.lat_sum += lat;
+    if (lat < bench_blk.lat_min)
+    {
+        bench_blk.lat_min = lat;
+    }
+    if (lat > bench_blk.lat_max)
+    {
+        bench_blk.lat_max = lat;
+    }
+
+    /* A NULL done marks the request as free for the issue loop */
+    req->done = NULL;
+}
+
+/**
+ * @name bench_blk_random_sector
+ *
+ * @brief Picks a random 4 KiB aligned sector below nr_blocks * 8
+ */
+static unsigned long long bench_blk_random_sector(unsigned int nr_blocks)
+{
+    unsigned int block;
+
+    bench_blk_seed ^= bench_blk_seed << 13;
+    bench_blk_seed ^= bench_blk_seed >> 17;
+    bench_blk_seed ^= bench_blk_seed << 5;
+
+    block = bench_blk_seed % nr_blocks;
+    return (unsigned long long) block * (BENCH_BLK_IO_SIZE / BLK_SECTOR_SIZE);
+}
+
+/**
+ * @name bench_blk_run
+ *
+ * @brief Runs BENCH_BLK_IOS reads keeping qd of them in flight
+ */
+static void bench_blk_run(unsigned int qd, unsigned int nr_blocks)
+{
+    unsigned long long start;
+    unsigned long long elapsed_us;
+    unsigned long long iops;
+    unsigned int issued = 0;
+    unsigned int done;
+    unsigned int i;
+
+    bench_blk.completed = 0;
+    bench_blk.errors = 0;
+    bench_blk.lat_sum = 0;
+    bench_blk.lat_min = ~0ULL;
+    bench_blk.lat_max = 0;
+
+    start = rdtsc();
+    while (bench_blk.completed < BENCH_BLK_IOS)
+    {
+        /* Top the queue up to qd, then ring the doorbell once */
+        for (i = 0; (i < qd) && (issued < BENCH_BLK_IOS); i++)
+        {
+            BLK_REQUEST *req = &bench_blk_reqs[i];
+
+            if (req->done != NULL)
+            {
+                continue;
+            }
+            req->op = BLK_OP_READ;
+            req->sector = bench_blk_random_sector(nr_blocks);
+            req->segs[0].buf = bench_blk_bufs[i];
+            req->segs[0].len = BENCH_BLK_IO_SIZE;
+            req->nr_segs = 1;
+            req->done = bench_blk_done;
+            if (virtio_blk_submit(req) != BLK_OK)
+            {
+                req->done = NULL;
+                break;
+            }
+            issued++;
+        }
+        virtio_blk_kick();
+
+        /* The bottom half may reap them first */
+        done = bench_blk.completed;
+        while ((virtio_blk_poll() == 0) && (bench_blk.completed == done))
+        {
+            cpu_relax();
+        }
+    }
+    elapsed_us = tsc_cycles_to_us(rdtsc() - start);
+    if (elapsed_us == 0)
+    {
+        elapsed_us = 1;
+    }
+
+    iops = div_u64_rem((unsigned long long) BENCH_BLK_IOS * 1000000ULL,
+                       (unsigned int) elapsed_us, NULL);
+    kprintf("  qd %2u: %6u IOPS %7u KiB/s  lat avg %6u min %6u max %7u us  err %u\n",
+            qd, (unsigned int) iops,
+            (unsigned int) (iops * (BENCH_BLK_IO_SIZE / 1024U)),
+            (unsigned int) tsc_cycles_to_us(div_u64_rem(bench_blk.lat_sum,
+                                                        BENCH_BLK_IOS, NULL)),
+            (unsigned int) tsc_cycles_to_us(bench_blk.lat_min),
+            (unsigned int) tsc_cycles_to_us(bench_blk.lat_max),
+            bench_blk.errors);
+}
+
+void bench_blk_qd_sweep(void)
+{
+    const VIRTIO_BLK_STATS *stats;
+    unsigned long long blocks;
+    unsigned int qd;
+
+    if (tsc_khz() == 0)
+    {
+        tsc_calibrate();
+    }
+
+    if (virtio_blk_init() != BLK_OK)
+    {
+        kprintf("virtio-blk: no device\n");
+        return;
+    }
+
+    blocks = div_u64_rem(virtio_blk_capacity(), BENCH_BLK_IO_SIZE / BLK_SECTOR_SIZE, NULL);
+    if (blocks == 0)
+    {
+        kprintf("virtio-blk: disk smaller than one block\n");
+        return;
+    }
+    if (blocks > 0xFFFFFFFFULL)
+    {
+        blocks = 0xFFFFFFFFULL;
+    }
+
+    kprintf("virtio-blk: %u sectors, TSC %u kHz, %u random %u B reads per depth\n",
+            (unsigned int) virtio_blk_capacity(), tsc_khz(),
+            BENCH_BLK_IOS, BENCH_BLK_IO_SIZE);
+
+    for (qd = 1; qd <= BENCH_BLK_MAX_QD; qd <<= 1)
+    {
+        bench_blk_run(qd, (unsigned int) blocks);
+    }
+
+    stats = virtio_blk_get_stats();
+    kprintf("virtio-blk: %u submitted, %u completed, %u doorbells, %u suppressed\n",
+            stats->submitted, stats->completed, stats->kicks, stats->kicks_skipped);
+}
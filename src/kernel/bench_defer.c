@@ -0,0 +1,127 @@
+/**
+ * @file bench_defer.c
+ *
+ * @brief Workqueue and softirq benchmark
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "tsc.h"
+#include "kprintf.h"
+#include "sched.h"
+#include "workqueue.h"
+#include "serial_port.h"
+#include "bench.h"
+
+/******************************************* Defines */
+/** Work items queued in one burst */
+#define BENCH_DEFER_WORKS       256U
+/** Serial output per run */
+#define BENCH_DEFER_SERIAL_LEN  1024U
+/** Characters per line of serial output, the last one is a newline */
+#define BENCH_DEFER_LINE_LEN    64U
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+static WORK bench_defer_works[BENCH_DEFER_WORKS];
+
+static volatile unsigned int bench_defer_done;
+
+static char bench_defer_text[BENCH_DEFER_SERIAL_LEN];
+
+/******************************************* Functions */
+/**
+ * @name bench_defer_work
+ *
+ * @brief Work function, only counts
+ */
+static void bench_defer_work(WORK * work)
+{
+    (void) work;
+    bench_defer_done++;
+}
+
+/**
+ * @name bench_defer_drain
+ *
+ * @brief Waits until the transmit ring is empty, returns the cycles waited
+ */
+static unsigned long long bench_defer_drain(void)
+{
+    unsigned long long start = rdtsc();
+
+    serial_flush();
+    return rdtsc() - start;
+}
+
+void bench_defer(void)
+{
+    const WORKQUEUE_STATS *wq = workqueue_get_stats(cpu_id());
+    unsigned long long queue_cycles;
+    unsigned long long polled_cycles;
+    unsigned long long ring_cycles;
+    unsigned long long drain_cycles;
+    unsigned long long start;
+    unsigned int flags;
+    unsigned int n;
+
+    if (tsc_khz() == 0)
+    {
+        tsc_calibrate();
+    }
+
+    /* Queue a burst, the worker only gets it once we yield */
+    workqueue_reset_stats();
+    bench_defer_done = 0;
+    for (n = 0; n < BENCH_DEFER_WORKS; n++)
+    {
+        work_init(&bench_defer_works[n], bench_defer_work);
+    }
+    start = rdtsc();
+    for (n = 0; n < BENCH_DEFER_WORKS; n++)
+    {
+        queue_work(&bench_defer_works[n]);
+    }
+    queue_cycles = rdtsc() - start;
+    while (bench_defer_done < BENCH_DEFER_WORKS)
+    {
+        sched_yield();
+    }
+
+    kprintf("defer: %u work items, TSC %u kHz\n", BENCH_DEFER_WORKS, tsc_khz());
+    kprintf("  queue     %8u cycles per item\n",
+            (unsigned int) div_u64_rem(queue_cycles, BENCH_DEFER_WORKS, NULL));
+    kprintf("  latency   %8u us avg, %u us max\n",
+            (unsigned int) tsc_cycles_to_us(div_u64_rem(wq->lat_sum, wq->run, NULL)),
+            (unsigned int) tsc_cycles_to_us(wq->lat_max));
+    kprintf("  max depth %8u\n", wq->max_depth);
+
+    for (n = 0; n < BENCH_DEFER_SERIAL_LEN; n++)
+    {
+        bench_defer_text[n] = ((n % BENCH_DEFER_LINE_LEN) == BENCH_DEFER_LINE_LEN - 1U) ?
+                              '\n' : (char) ('a' + (n % 26U));
+    }
+
+    /* With interrupts off serial_write() spins on every byte */
+    bench_defer_drain();
+    flags = local_irq_save();
+    start = rdtsc();
+    serial_write(SERIAL_COM1_BASE, bench_defer_text, BENCH_DEFER_SERIAL_LEN);
+    polled_cycles = rdtsc() - start;
+    local_irq_restore(flags);
+
+    /* With them on it only copies into the ring */
+    start = rdtsc();
+    serial_write(SERIAL_COM1_BASE, bench_defer_text, BENCH_DEFER_SERIAL_LEN);
+    ring_cycles = rdtsc() - start;
+    drain_cycles = bench_defer_drain();
+
+    kprintf("defer: %u bytes of serial output\n", BENCH_DEFER_SERIAL_LEN);
+    kprintf("  polled    %8u us in the writer\n",
+            (unsigned int) tsc_cycles_to_us(polled_cycles));
+    kprintf("  ring      %8u us in the writer, sent %u us later\n",
+            (unsigned int) tsc_cycles_to_us(ring_cycles),
+            (unsigned int) tsc_cycles_to_us(drain_cycles));
+}
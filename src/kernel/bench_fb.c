@@ -0,0 +1,103 @@
+/**
+ * @file bench_fb.c
+ *
+ * @brief Rendering and scrolling benchmark for the graphics console
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "tsc.h"
+#include "kprintf.h"
+#include "fb.h"
+#include "fbcon.h"
+#include "bench.h"
+
+/******************************************* Defines */
+/** Full screens of glyphs drawn */
+#define BENCH_FB_SCREENS        4U
+/** Scroll plus full screen flush rounds */
+#define BENCH_FB_SCROLLS        64U
+
+/******************************************* Macros */
+
+/******************************************* Functions */
+void bench_fb_console(void)
+{
+    const FBCON_STATS *st = fbcon_get_stats();
+    unsigned long long glyph_cycles;
+    unsigned long long scroll_cycles = 0;
+    unsigned long long flush_cycles;
+    unsigned long long flush_bytes;
+    unsigned long long start;
+    unsigned long long us;
+    unsigned int glyphs = 0;
+    unsigned int rows = fbcon_rows();
+    unsigned int cols = fbcon_cols();
+    unsigned int n;
+    unsigned int r;
+    unsigned int c;
+
+    if (!fbcon_active())
+    {
+        kprintf("fb: graphics console not active\n");
+        return;
+    }
+    if (tsc_khz() == 0)
+    {
+        tsc_calibrate();
+    }
+
+    /* Glyph expansion into the shadow buffer only */
+    start = rdtsc();
+    for (n = 0; n < BENCH_FB_SCREENS; n++)
+    {
+        for (r = 0; r < rows; r++)
+        {
+            for (c = 0; c < cols; c++)
+            {
+                fbcon_putc(r, c, (char) ('!' + ((r + c + n) % 94U)),
+                           (unsigned char) ((c & 0x0FU) | 0x08U), FB_BLACK);
+                glyphs++;
+            }
+        }
+    }
+    glyph_cycles = rdtsc() - start;
+    fbcon_flush();
+
+    /* Every scroll dirties the whole screen */
+    flush_cycles = st->flush_cycles;
+    flush_bytes = st->flushed_bytes;
+    for (n = 0; n < BENCH_FB_SCROLLS; n++)
+    {
+        start = rdtsc();
+        fbcon_scroll(FB_BLACK);
+        scroll_cycles += rdtsc() - start;
+        fbcon_flush();
+    }
+    flush_cycles = st->flush_cycles - flush_cycles;
+    flush_bytes = st->flushed_bytes - flush_bytes;
+
+    for (r = 0; r < rows; r++)
+    {
+        fbcon_clear_row(r, FB_BLACK);
+    }
+    fbcon_flush();
+
+    us = tsc_cycles_to_us(flush_cycles);
+    if (us == 0)
+    {
+        us = 1;
+    }
+    kprintf("fb: %ux%u, %ux%u cells, write-combining %s, TSC %u kHz\n",
+            st->width, st->height, cols, rows,
+            st->write_combining ? "on" : "off", tsc_khz());
+    kprintf("  glyph  %8u cycles\n",
+            (unsigned int) div_u64_rem(glyph_cycles, glyphs, NULL));
+    kprintf("  scroll %8u cycles (shadow move)\n",
+            (unsigned int) div_u64_rem(scroll_cycles, BENCH_FB_SCROLLS, NULL));
+    kprintf("  flush  %8u cycles per screen, %u KiB/s\n",
+            (unsigned int) div_u64_rem(flush_cycles, BENCH_FB_SCROLLS, NULL),
+            (unsigned int) (div_u64_rem(flush_bytes * 1000000ULL,
+                                        (unsigned int) us, NULL) >> 10));
+}
@@ -0,0 +1,367 @@
+/**
+ * @file bench_ipc.c
+ *
+ * @brief Message channel benchmark, in place and granted against copying
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "tsc.h"
+#include "kstring.h"
+#include "kprintf.h"
+#include "pmm.h"
+#include "sched.h"
+#include "ipc.h"
+#include "bench.h"
+
+/******************************************* Defines */
+#define BENCH_IPC_SLOTS         64U
+/** Inline payload per slot, larger messages are granted or chunked */
+#define BENCH_IPC_INLINE        1024U
+#define BENCH_IPC_MIN_SIZE      16U
+#define BENCH_IPC_MAX_SIZE      (64U * 1024U)
+/** Bytes moved per size and mode, within the message count limits */
+#define BENCH_IPC_BYTES         (4U * 1024U * 1024U)
+#define BENCH_IPC_MIN_MSGS      64U
+#define BENCH_IPC_MAX_MSGS      16384U
+
+/* Modes */
+#define BENCH_IPC_COPY          0U      /**< Copy in and out, chunked by slot */
+#define BENCH_IPC_ZERO_COPY     1U      /**< In place, or granted pages */
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct BENCH_IPC_RUN
+ * @brief One size and mode, shared by the sender thread and the receiver
+ */
+typedef struct _BENCH_IPC_RUN
+{
+    IPC_CHAN           *chan;
+    unsigned int        mode;
+    unsigned int        size;
+    unsigned int        count;
+    unsigned char      *buf;          /**< Sender buffer in copy mode */
+    unsigned long long  lat_sum;
+    unsigned long long  lat_max;
+    unsigned long long  cycles;
+    unsigned int        sum;          /**< Keeps the receiver's reads */
+    int                 err;          /**< First sender error, IPC_OK if none */
+    IPC_STATS           stats;
+} BENCH_IPC_RUN;
+
+/******************************************* Macros */
+
+/******************************************* Functions */
+/**
+ * @name bench_ipc_fill
+ *
+ * @brief Writes a message, starting with the time it was started at
+ */
+static void bench_ipc_fill(unsigned char * dst, unsigned int size, unsigned int n,
+                           unsigned long long start)
+{
+    memset(dst, (int) (n & 0xFFU), size);
+    memcpy(dst, &start, sizeof(start));
+}
+
+/**
+ * @name bench_ipc_sum
+ *
+ * @brief Reads every word of a message
+ */
+static unsigned int bench_ipc_sum(const unsigned char * src, unsigned int size)
+{
+    const unsigned int *p = (const unsigned int *) src;
+    unsigned int sum = 0;
+    unsigned int i;
+
+    for (i = 0; i < size / sizeof(unsigned int); i++)
+    {
+        sum += p[i];
+    }
+    return sum;
+}
+
+/**
+ * @name bench_ipc_send
+ *
+ * @brief Sends message n
+ *
+ * @return IPC_OK or the error that stopped it
+ */
+static int bench_ipc_send(BENCH_IPC_RUN * run, unsigned int n)
+{
+    unsigned long long start = rdtsc();
+    unsigned int chunk;
+    unsigned int off;
+    IPC_MSG *msg;
+    void *pages;
+    int ret;
+
+    if (run->mode == BENCH_IPC_COPY)
+    {
+        bench_ipc_fill(run->buf, run->size, n, start);
+        for (off = 0; off < run->size; off += chunk)
+        {
+            chunk = run->size - off;
+            if (chunk > BENCH_IPC_INLINE)
+            {
+                chunk = BENCH_IPC_INLINE;
+            }
+            ret = ipc_send(run->chan, run->buf + off, chunk, 0);
+            if (ret != IPC_OK)
+            {
+                return ret;
+            }
+        }
+        return IPC_OK;
+    }
+
+    if (run->size <= BENCH_IPC_INLINE)
+    {
+        ret = ipc_send_begin(run->chan, &msg, 0);
+        if (ret != IPC_OK)
+        {
+            return ret;
+        }
+        bench_ipc_fill(IPC_MSG_DATA(msg), run->size, n, start);
+        msg->len = run->size;
+        ipc_send_commit(run->chan, msg);
+        return IPC_OK;
+    }
+
+    pages = ipc_page_alloc(run->size);
+    if (pages == NULL)
+    {
+        return IPC_ERR_NOMEM;
+    }
+    bench_ipc_fill(pages, run->size, n, start);
+    ret = ipc_send_pages(run->chan, pages, run->size, 0);
+    if (ret != IPC_OK)
+    {
+        ipc_page_free(pages, run->size);
+    }
+    return ret;
+}
+
+/**
+ * @name bench_ipc_sender
+ *
+ * @brief Sender thread, an empty message tells the receiver it gave up
+ */
+static void bench_ipc_sender(void * arg)
+{
+    BENCH_IPC_RUN *run = arg;
+    unsigned int n;
+
+    for (n = 0; n < run->count; n++)
+    {
+        run->err = bench_ipc_send(run, n);
+        if (run->err != IPC_OK)
+        {
+            ipc_send(run->chan, NULL, 0, 0);
+            return;
+        }
+    }
+}
+
+/**
+ * @name bench_ipc_lat
+ *
+ * @brief Accounts the latency of a message whose payload starts at data
+ */
+static void bench_ipc_lat(BENCH_IPC_RUN * run, const unsigned char * data)
+{
+    unsigned long long start;
+    unsigned long long lat;
+
+    memcpy(&start, data, sizeof(start));
+    lat = rdtsc() - start;
+    run->lat_sum += lat;
+    if (lat > run->lat_max)
+    {
+        run->lat_max = lat;
+    }
+}
+
+/**
+ * @name bench_ipc_run
+ *
+ * @brief Receives one size in one mode, the sender runs whenever we wait
+ *
+ * @return IPC_OK, IPC_ERR_NOMEM if the run could not be set up, or the
+ * error that stopped the sender or the receiver
+ */
+static int bench_ipc_run(BENCH_IPC_RUN * run, unsigned char * dst)
+{
+    unsigned long long start;
+    unsigned int off;
+    unsigned int n;
+    IPC_MSG *msg;
+    int len = 0;
+    int ret = IPC_OK;
+
+    run->lat_sum = 0;
+    run->lat_max = 0;
+    run->sum = 0;
+    run->err = IPC_OK;
+    run->chan = ipc_chan_create(BENCH_IPC_SLOTS, BENCH_IPC_INLINE, IPC_CHAN_SPSC, NULL);
+    if (run->chan == NULL)
+    {
+        return IPC_ERR_NOMEM;
+    }
+
+    start = rdtsc();
+    if (kthread_create("bench-ipc", bench_ipc_sender, run) == NULL)
+    {
+        ipc_chan_destroy(run->chan);
+        return IPC_ERR_NOMEM;
+    }
+
+    for (n = 0; n < run->count; n++)
+    {
+        if (run->mode == BENCH_IPC_COPY)
+        {
+            for (off = 0; off < run->size; off += (unsigned int) len)
+            {
+                len = ipc_recv(run->chan, dst + off, run->size - off, 0);
+                if (len <= 0)
+                {
+                    break;
+                }
+            }
+            if (len <= 0)
+            {
+                /* An error of ours, or the sender's empty message */
+                ret = len;
+                break;
+            }
+            bench_ipc_lat(run, dst);
+            run->sum += bench_ipc_sum(dst, run->size);
+            continue;
+        }
+
+        ret = ipc_recv_begin(run->chan, &msg, 0);
+        if (ret != IPC_OK)
+        {
+            break;
+        }
+        if (msg->len == 0)
+        {
+            /* The sender failed */
+            ipc_recv_end(run->chan, msg);
+            break;
+        }
+        if (msg->flags & IPC_MSG_PAGES)
+        {
+            bench_ipc_lat(run, msg->pages);
+            run->sum += bench_ipc_sum(msg->pages, msg->len);
+            ipc_page_free(msg->pages, msg->len);
+        }
+        else
+        {
+            bench_ipc_lat(run, IPC_MSG_DATA(msg));
+            run->sum += bench_ipc_sum(IPC_MSG_DATA(msg), msg->len);
+        }
+        ipc_recv_end(run->chan, msg);
+    }
+    run->cycles = rdtsc() - start;
+
+    /* Sending the last message does not sleep, so we only got it once the
+     * sender had returned and was done with the channel */
+    ipc_chan_get_stats(run->chan, &run->stats);
+    ipc_chan_destroy(run->chan);
+    return (run->err != IPC_OK) ? run->err : ret;
+}
+
+/**
+ * @name bench_ipc_print
+ *
+ * @brief Prints throughput, average / max latency and the sender / receiver
+ * sleeps of a run
+ */
+static void bench_ipc_print(const char * name, const BENCH_IPC_RUN * run)
+{
+    unsigned long long us = tsc_cycles_to_us(run->cycles);
+    unsigned long long bytes = (unsigned long long) run->size * run->count;
+
+    if (us == 0)
+    {
+        us = 1;
+    }
+    kprintf("  %s %6u MiB/s, latency avg %6u us max %6u us, %u/%u waits\n",
+            name, (unsigned int) (div_u64_rem(bytes * 1000000ULL, (unsigned int) us, NULL) >> 20),
+            (unsigned int) tsc_cycles_to_us(div_u64_rem(run->lat_sum, run->count, NULL)),
+            (unsigned int) tsc_cycles_to_us(run->lat_max),
+            run->stats.send_waits, run->stats.recv_waits);
+}
+
+void bench_ipc(void)
+{
+    unsigned int pages = BENCH_IPC_MAX_SIZE / PAGE_SIZE;
+    unsigned char *src;
+    unsigned char *dst;
+    BENCH_IPC_RUN copy;
+    BENCH_IPC_RUN zero;
+    unsigned int size;
+    int ret;
+
+    if (tsc_khz() == 0)
+    {
+        tsc_calibrate();
+    }
+
+    src = pmm_alloc_pages(pages);
+    dst = pmm_alloc_pages(pages);
+    if ((src == NULL) || (dst == NULL))
+    {
+        kprintf("ipc: out of memory\n");
+        goto out;
+    }
+
+    kprintf("ipc: SPSC ring of %u slots, %u B inline, TSC %u kHz\n",
+            BENCH_IPC_SLOTS, BENCH_IPC_INLINE, tsc_khz());
+    for (size = BENCH_IPC_MIN_SIZE; size <= BENCH_IPC_MAX_SIZE; size <<= 2)
+    {
+        copy.mode = BENCH_IPC_COPY;
+        copy.size = size;
+        copy.count = BENCH_IPC_BYTES / size;
+        if (copy.count > BENCH_IPC_MAX_MSGS)
+        {
+            copy.count = BENCH_IPC_MAX_MSGS;
+        }
+        if (copy.count < BENCH_IPC_MIN_MSGS)
+        {
+            copy.count = BENCH_IPC_MIN_MSGS;
+        }
+        copy.buf = src;
+        zero = copy;
+        zero.mode = BENCH_IPC_ZERO_COPY;
+
+        ret = bench_ipc_run(&copy, dst);
+        if (ret == IPC_OK)
+        {
+            ret = bench_ipc_run(&zero, dst);
+        }
+        if (ret != IPC_OK)
+        {
+            kprintf("ipc: %u B messages failed %d\n", size, ret);
+            break;
+        }
+
+        kprintf("ipc: %u B x %u messages\n", size, copy.count);
+        bench_ipc_print("copy    ", &copy);
+        bench_ipc_print((size <= BENCH_IPC_INLINE) ? "in place" : "granted ", &zero);
+    }
+
+out:
+    if (src != NULL)
+    {
+        pmm_free_pages(src, pages);
+    }
+    if (dst != NULL)
+    {
+        pmm_free_pages(dst, pages);
+    }
+}
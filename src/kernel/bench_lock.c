@@ -0,0 +1,177 @@
+/**
+ * @file bench_lock.c
+ *
+ * @brief Lock contention benchmark, spinning against the sleeping mutex
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "tsc.h"
+#include "kprintf.h"
+#include "sched.h"
+#include "wait.h"
+#include "mutex.h"
+#include "serial_port.h"
+#include "bench.h"
+
+/******************************************* Defines */
+#define BENCH_LOCK_THREADS      4U
+#define BENCH_LOCK_ROUNDS       32U
+
+/* Modes */
+#define BENCH_LOCK_SPIN         0U      /**< trylock, yield, retry */
+#define BENCH_LOCK_MUTEX        1U      /**< mutex_lock() */
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct BENCH_LOCK_RUN
+ * @brief One mode, shared by the contending threads
+ */
+typedef struct _BENCH_LOCK_RUN
+{
+    unsigned int        mode;
+    MUTEX               lock;
+    unsigned int        running;      /**< Threads not finished */
+    COMPLETION          done;         /**< Signalled by the last thread */
+    unsigned long long  wasted;       /**< On-CPU cycles spent acquiring */
+    unsigned int        retries;      /**< Failed trylocks, spin mode */
+} BENCH_LOCK_RUN;
+
+/**
+ * @struct BENCH_LOCK_THREAD
+ * @brief Argument of one contending thread
+ */
+typedef struct _BENCH_LOCK_THREAD
+{
+    BENCH_LOCK_RUN     *run;
+    char                tag;          /**< Written while holding the lock */
+} BENCH_LOCK_THREAD;
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+static BENCH_LOCK_THREAD bench_lock_threads[BENCH_LOCK_THREADS];
+
+/******************************************* Functions */
+/**
+ * @name bench_lock_thread
+ *
+ * @brief Takes the lock BENCH_LOCK_ROUNDS times and sleeps on the UART
+ * while holding it
+ */
+static void bench_lock_thread(void * arg)
+{
+    BENCH_LOCK_THREAD *t = arg;
+    BENCH_LOCK_RUN *run = t->run;
+    TASK *self = sched_current();
+    unsigned long long before;
+    unsigned int i;
+
+    for (i = 0; i < BENCH_LOCK_ROUNDS; i++)
+    {
+        before = sched_task_cycles(self);
+        if (run->mode == BENCH_LOCK_SPIN)
+        {
+            /* Spinning without yielding never lets the owner back on */
+            while (!mutex_trylock(&run->lock))
+            {
+                run->retries++;
+                sched_yield();
+            }
+        }
+        else
+        {
+            mutex_lock(&run->lock);
+        }
+        run->wasted += sched_task_cycles(self) - before;
+
+        serial_write(SERIAL_COM1_BASE, &t->tag, 1);
+        serial_flush();
+        mutex_unlock(&run->lock);
+
+        /* What a preemptive kernel would do: the woken waiter gets a turn */
+        sched_yield();
+    }
+
+    if (--run->running == 0)
+    {
+        complete(&run->done);
+    }
+}
+
+/**
+ * @name bench_lock_run
+ *
+ * @brief Runs the threads in one mode and waits for them
+ *
+ * @return The elapsed cycles, 0 if the threads could not be created
+ */
+static unsigned long long bench_lock_run(BENCH_LOCK_RUN * run, unsigned int mode)
+{
+    unsigned long long start;
+    unsigned int i;
+
+    run->mode = mode;
+    mutex_init(&run->lock);
+    completion_init(&run->done);
+    run->running = 0;
+    run->wasted = 0;
+    run->retries = 0;
+
+    start = rdtsc();
+    for (i = 0; i < BENCH_LOCK_THREADS; i++)
+    {
+        bench_lock_threads[i].run = run;
+        bench_lock_threads[i].tag = (char) ('0' + i);
+        if (kthread_create("bench-lock", bench_lock_thread, &bench_lock_threads[i]) == NULL)
+        {
+            break;
+        }
+        run->running++;
+    }
+    if (run->running == 0)
+    {
+        return 0;
+    }
+
+    wait_for_completion(&run->done);
+    start = rdtsc() - start;
+
+    /* complete() does not sleep: the last thread ran on until it returned */
+    kprintf("\n");
+    return start;
+}
+
+void bench_lock(void)
+{
+    unsigned int locks = BENCH_LOCK_THREADS * BENCH_LOCK_ROUNDS;
+    unsigned long long spin_cycles;
+    unsigned long long mutex_cycles;
+    BENCH_LOCK_RUN spin;
+    BENCH_LOCK_RUN mtx;
+
+    if (tsc_khz() == 0)
+    {
+        tsc_calibrate();
+    }
+
+    kprintf("lock: %u threads x %u rounds, holding the lock across a serial flush\n",
+            BENCH_LOCK_THREADS, BENCH_LOCK_ROUNDS);
+    kprintf("  spin  ");
+    spin_cycles = bench_lock_run(&spin, BENCH_LOCK_SPIN);
+    kprintf("  mutex ");
+    mutex_cycles = bench_lock_run(&mtx, BENCH_LOCK_MUTEX);
+    if ((spin_cycles == 0) || (mutex_cycles == 0))
+    {
+        kprintf("lock: out of memory\n");
+        return;
+    }
+
+    kprintf("  spin   %8u cycles wasted per lock, %7u us total, %u retries\n",
+            (unsigned int) div_u64_rem(spin.wasted, locks, NULL),
+            (unsigned int) tsc_cycles_to_us(spin_cycles), spin.retries);
+    kprintf("  mutex  %8u cycles wasted per lock, %7u us total, %u sleeps\n",
+            (unsigned int) div_u64_rem(mtx.wasted, locks, NULL),
+            (unsigned int) tsc_cycles_to_us(mutex_cycles), mtx.lock.stats.sleeps);
+}
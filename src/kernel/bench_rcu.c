@@ -0,0 +1,298 @@
+/**
+ * @file bench_rcu.c
+ *
+ * @brief Read-mostly table benchmark, RCU readers against locked ones
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "tsc.h"
+#include "kstring.h"
+#include "kprintf.h"
+#include "kmalloc.h"
+#include "sched.h"
+#include "wait.h"
+#include "mutex.h"
+#include "rcu.h"
+#include "bench.h"
+
+/******************************************* Defines */
+#define BENCH_RCU_MAX_READERS   4U
+/** Lookups per reader */
+#define BENCH_RCU_READS         20000U
+/** Lookups between yields, the writer replaces the table in between */
+#define BENCH_RCU_BATCH         500U
+#define BENCH_RCU_ENTRIES       16U
+
+/* Modes */
+#define BENCH_RCU_MODE_RCU      0U      /**< rcu_read_lock() */
+#define BENCH_RCU_MODE_MUTEX    1U      /**< mutex_lock() */
+#define BENCH_RCU_MODE_IRQ      2U      /**< Interrupts off, as the IRQ table was */
+#define BENCH_RCU_NR_MODES      3U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct BENCH_RCU_TABLE
+ * @brief The shared table, replaced as a whole under RCU
+ */
+typedef struct _BENCH_RCU_TABLE
+{
+    RCU_HEAD            rcu;
+    unsigned int        gen;
+    unsigned int        val[BENCH_RCU_ENTRIES];
+} BENCH_RCU_TABLE;
+
+/**
+ * @struct BENCH_RCU_RUN
+ * @brief One mode and reader count, shared by the readers and the writer
+ */
+typedef struct _BENCH_RCU_RUN
+{
+    unsigned int        mode;
+    BENCH_RCU_TABLE    *table;
+    MUTEX               lock;         /**< Mutex mode */
+    unsigned int        running;      /**< Readers not finished */
+    unsigned int        threads;      /**< Readers and writer not finished */
+    COMPLETION          done;         /**< Signalled by the last thread */
+    unsigned long long  cycles;       /**< Spent in lookups, all readers */
+    unsigned int        updates;
+    unsigned int        sum;          /**< Keeps the lookups */
+} BENCH_RCU_RUN;
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+
+/******************************************* Functions */
+/**
+ * @name bench_rcu_exit
+ *
+ * @brief Ends a thread, the last one wakes the benchmark
+ */
+static void bench_rcu_exit(BENCH_RCU_RUN * run)
+{
+    if (--run->threads == 0)
+    {
+        complete(&run->done);
+    }
+}
+
+/**
+ * @name bench_rcu_lookup
+ *
+ * @brief One reader-side access to the table
+ */
+static unsigned int bench_rcu_lookup(BENCH_RCU_RUN * run, unsigned int i)
+{
+    BENCH_RCU_TABLE *table;
+    unsigned int flags;
+    unsigned int val;
+
+    switch (run->mode)
+    {
+    case BENCH_RCU_MODE_RCU:
+        rcu_read_lock();
+        table = rcu_dereference(run->table);
+        val = table->val[i % BENCH_RCU_ENTRIES] + table->gen;
+        rcu_read_unlock();
+        break;
+    case BENCH_RCU_MODE_MUTEX:
+        mutex_lock(&run->lock);
+        val = run->table->val[i % BENCH_RCU_ENTRIES] + run->table->gen;
+        mutex_unlock(&run->lock);
+        break;
+    default:
+        flags = local_irq_save();
+        val = run->table->val[i % BENCH_RCU_ENTRIES] + run->table->gen;
+        local_irq_restore(flags);
+        break;
+    }
+    return val;
+}
+
+/**
+ * @name bench_rcu_reader
+ *
+ * @brief Looks up BENCH_RCU_READS entries, yielding every batch
+ */
+static void bench_rcu_reader(void * arg)
+{
+    BENCH_RCU_RUN *run = arg;
+    unsigned long long start;
+    unsigned int sum = 0;
+    unsigned int i;
+    unsigned int j;
+
+    for (i = 0; i < BENCH_RCU_READS; i += BENCH_RCU_BATCH)
+    {
+        start = rdtsc();
+        for (j = 0; j < BENCH_RCU_BATCH; j++)
+        {
+            sum += bench_rcu_lookup(run, i + j);
+        }
+        run->cycles += rdtsc() - start;
+        sched_yield();
+    }
+
+    run->sum += sum;
+    run->running--;
+    bench_rcu_exit(run);
+}
+
+/**
+ * @name bench_rcu_free
+ *
+ * @brief Frees a replaced table after the grace period
+ */
+static void bench_rcu_free(RCU_HEAD * head)
+{
+    kfree(CONTAINER_OF(head, BENCH_RCU_TABLE, rcu));
+}
+
+/**
+ * @name bench_rcu_writer
+ *
+ * @brief Updates the table between reader batches until the readers are
+ * done
+ */
+static void bench_rcu_writer(void * arg)
+{
+    BENCH_RCU_RUN *run = arg;
+    BENCH_RCU_TABLE *old;
+    BENCH_RCU_TABLE *table;
+    unsigned int flags;
+
+    while (run->running != 0)
+    {
+        switch (run->mode)
+        {
+        case BENCH_RCU_MODE_RCU:
+            /* Copy, update, publish, retire the old copy */
+            table = kmalloc(sizeof(*table));
+            if (table == NULL)
+            {
+                break;
+            }
+            old = run->table;
+            memcpy(table, old, sizeof(*table));
+            table->gen++;
+            table->val[table->gen % BENCH_RCU_ENTRIES] = table->gen;
+            rcu_assign_pointer(run->table, table);
+            call_rcu(&old->rcu, bench_rcu_free);
+            break;
+        case BENCH_RCU_MODE_MUTEX:
+            mutex_lock(&run->lock);
+            run->table->gen++;
+            run->table->val[run->table->gen % BENCH_RCU_ENTRIES] = run->table->gen;
+            mutex_unlock(&run->lock);
+            break;
+        default:
+            flags = local_irq_save();
+            run->table->gen++;
+            run->table->val[run->table->gen % BENCH_RCU_ENTRIES] = run->table->gen;
+            local_irq_restore(flags);
+            break;
+        }
+        run->updates++;
+        sched_yield();
+    }
+    bench_rcu_exit(run);
+}
+
+/**
+ * @name bench_rcu_run
+ *
+ * @brief Runs readers and the writer in one mode
+ *
+ * @return Cycles per lookup, 0 if the run could not be set up
+ */
+static unsigned int bench_rcu_run(BENCH_RCU_RUN * run, unsigned int mode, unsigned int readers)
+{
+    unsigned int i;
+
+    run->mode = mode;
+    run->table = kzalloc(sizeof(*run->table));
+    if (run->table == NULL)
+    {
+        return 0;
+    }
+    mutex_init(&run->lock);
+    completion_init(&run->done);
+    run->running = 0;
+    run->threads = 0;
+    run->cycles = 0;
+    run->updates = 0;
+
+    for (i = 0; i < readers; i++)
+    {
+        if (kthread_create("bench-rcu-rd", bench_rcu_reader, run) == NULL)
+        {
+            break;
+        }
+        run->running++;
+        run->threads++;
+    }
+    if ((run->running != 0) && (kthread_create("bench-rcu-wr", bench_rcu_writer, run) != NULL))
+    {
+        run->threads++;
+    }
+
+    if (run->threads != 0)
+    {
+        wait_for_completion(&run->done);
+    }
+
+    /* complete() does not sleep, so the last thread has returned; wait for
+     * the callbacks freeing the replaced tables */
+    rcu_barrier();
+    kfree(run->table);
+
+    if (i != readers)
+    {
+        return 0;
+    }
+    return (unsigned int) div_u64_rem(run->cycles, readers * BENCH_RCU_READS, NULL);
+}
+
+void bench_rcu(void)
+{
+    const RCU_STATS *st = rcu_get_stats();
+    unsigned int cycles[BENCH_RCU_NR_MODES];
+    unsigned int gp = st->gp_completed;
+    unsigned int invoked = st->invoked;
+    unsigned int updates = 0;
+    unsigned int readers;
+    unsigned int mode;
+    BENCH_RCU_RUN run;
+
+    if (tsc_khz() == 0)
+    {
+        tsc_calibrate();
+    }
+
+    kprintf("rcu: %u lookups per reader, the table is updated every %u\n",
+            BENCH_RCU_READS, BENCH_RCU_BATCH);
+    kprintf("  cycles per lookup   readers      rcu    mutex  irq-off\n");
+    for (readers = 1; readers <= BENCH_RCU_MAX_READERS; readers <<= 1)
+    {
+        for (mode = 0; mode < BENCH_RCU_NR_MODES; mode++)
+        {
+            cycles[mode] = bench_rcu_run(&run, mode, readers);
+            if (cycles[mode] == 0)
+            {
+                kprintf("rcu: out of memory\n");
+                return;
+            }
+            if (mode == BENCH_RCU_MODE_RCU)
+            {
+                updates += run.updates;
+            }
+        }
+        kprintf("                      %7u %8u %8u %8u\n", readers,
+                cycles[BENCH_RCU_MODE_RCU], cycles[BENCH_RCU_MODE_MUTEX],
+                cycles[BENCH_RCU_MODE_IRQ]);
+    }
+    kprintf("  rcu: %u tables replaced, %u grace periods, %u callbacks run\n",
+            updates, st->gp_completed - gp, st->invoked - invoked);
+}
@@ -0,0 +1,84 @@
+/**
+ * @file bench_trace.c
+ *
+ * @brief Cost of the function tracer per call
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "tsc.h"
+#include "kprintf.h"
+#include "ftrace.h"
+#include "bench.h"
+
+/******************************************* Defines */
+#define BENCH_TRACE_CALLS       100000U
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+static volatile unsigned int bench_trace_sink;
+
+/******************************************* Functions */
+/**
+ * @name bench_trace_leaf
+ *
+ * @brief Smallest traceable function
+ */
+static void bench_trace_leaf(unsigned int n)
+{
+    bench_trace_sink = n;
+}
+
+/**
+ * @name bench_trace_nopad
+ *
+ * @brief The same without an entry pad, the baseline
+ */
+__attribute__((patchable_function_entry(0, 0)))
+static void bench_trace_nopad(unsigned int n)
+{
+    bench_trace_sink = n;
+}
+
+/**
+ * @name bench_trace_loop
+ *
+ * @brief Returns the cycles per call of fn
+ */
+static unsigned int bench_trace_loop(void (*fn)(unsigned int n))
+{
+    unsigned long long start;
+    unsigned int n;
+
+    start = rdtsc();
+    for (n = 0; n < BENCH_TRACE_CALLS; n++)
+    {
+        fn(n);
+    }
+    return (unsigned int) div_u64_rem(rdtsc() - start, BENCH_TRACE_CALLS, NULL);
+}
+
+void bench_trace(void)
+{
+    unsigned int nopad;
+    unsigned int off;
+    unsigned int on;
+
+    nopad = bench_trace_loop(bench_trace_nopad);
+    off = bench_trace_loop(bench_trace_leaf);
+
+    if (ftrace_enable("bench_trace_leaf") < 0)
+    {
+        kprintf("trace: bench_trace_leaf has no patch site\n");
+        return;
+    }
+    on = bench_trace_loop(bench_trace_leaf);
+    ftrace_disable("bench_trace_leaf");
+
+    kprintf("trace: %u calls, %u patch sites\n", BENCH_TRACE_CALLS, ftrace_get_stats()->sites);
+    kprintf("  no pad   %6u cycles per call\n", nopad);
+    kprintf("  disabled %6u cycles per call\n", off);
+    kprintf("  traced   %6u cycles per call\n", on);
+}
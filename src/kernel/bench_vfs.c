@@ -0,0 +1,178 @@
+/**
+ * @file bench_vfs.c
+ *
+ * @brief Cold versus warm cache benchmark for the VFS
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "tsc.h"
+#include "kstring.h"
+#include "kmalloc.h"
+#include "kprintf.h"
+#include "vfs.h"
+#include "bench.h"
+
+/******************************************* Defines */
+/** Read size of the sequential read passes */
+#define BENCH_VFS_CHUNK         (64U * 1024U)
+/** Path walks per lookup pass */
+#define BENCH_VFS_LOOKUPS       1000U
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+/** Benchmark file, the first one that exists is used */
+static const char * const bench_vfs_files[] =
+{
+    "/disk/bench.bin",
+    "/etc/motd",
+};
+
+/** Paths for the lookup passes, the last one does not exist */
+static const char * const bench_vfs_paths[] =
+{
+    "/disk/etc/os.conf",
+    "/etc/os.conf",
+    "/disk/no/such/file",
+};
+
+/******************************************* Functions */
+
+/**
+ * @name bench_vfs_report
+ *
+ * @brief Prints cycles and throughput of one pass over bytes bytes
+ */
+static void bench_vfs_report(const char * what, unsigned int bytes, unsigned long long cycles)
+{
+    unsigned long long us = tsc_cycles_to_us(cycles);
+
+    if (us == 0)
+    {
+        us = 1;
+    }
+    kprintf("  %s %10u cycles %8u KiB/s\n", what, (unsigned int) cycles,
+            (unsigned int) (div_u64_rem((unsigned long long) bytes * 1000000ULL,
+                                        (unsigned int) us, NULL) >> 10));
+}
+
+/**
+ * @name bench_vfs_read_pass
+ *
+ * @brief Reads the whole file sequentially, returns the cycles taken
+ */
+static unsigned long long bench_vfs_read_pass(VFS_FILE * file, void * buf)
+{
+    unsigned long long start = rdtsc();
+
+    vfs_seek(file, 0);
+    while (vfs_read(file, buf, BENCH_VFS_CHUNK) > 0)
+    {
+    }
+    return rdtsc() - start;
+}
+
+/**
+ * @name bench_vfs_lookup_pass
+ *
+ * @brief Walks every benchmark path BENCH_VFS_LOOKUPS times
+ */
+static unsigned long long bench_vfs_lookup_pass(unsigned int rounds)
+{
+    unsigned long long start = rdtsc();
+    VFS_FILE *file;
+    unsigned int i;
+    unsigned int p;
+
+    for (i = 0; i < rounds; i++)
+    {
+        for (p = 0; p < ARRAY_SIZE(bench_vfs_paths); p++)
+        {
+            file = vfs_open(bench_vfs_paths[p], NULL);
+            if (file != NULL)
+            {
+                vfs_close(file);
+            }
+        }
+    }
+    return rdtsc() - start;
+}
+
+void bench_vfs_read(void)
+{
+    const VFS_STATS *stats = vfs_get_stats();
+    VFS_FILE *file = NULL;
+    unsigned long long cycles;
+    unsigned char *buf;
+    const volatile unsigned int *map;
+    unsigned int sum = 0;
+    unsigned int size;
+    unsigned int i;
+
+    if (tsc_khz() == 0)
+    {
+        tsc_calibrate();
+    }
+
+    for (i = 0; (i < ARRAY_SIZE(bench_vfs_files)) && (file == NULL); i++)
+    {
+        file = vfs_open(bench_vfs_files[i], NULL);
+    }
+    buf = kmalloc(BENCH_VFS_CHUNK);
+    if ((file == NULL) || (buf == NULL))
+    {
+        kprintf("vfs: nothing to benchmark\n");
+        kfree(buf);
+        if (file != NULL)
+        {
+            vfs_close(file);
+        }
+        return;
+    }
+    size = file->inode->size;
+    kprintf("vfs: %s, %u bytes, TSC %u kHz\n", bench_vfs_files[i - 1U], size, tsc_khz());
+
+    /* Cold pass fills the page cache, the warm one only copies */
+    bench_vfs_report("read cold ", size, bench_vfs_read_pass(file, buf));
+    bench_vfs_report("read warm ", size, bench_vfs_read_pass(file, buf));
+
+    /* Same bytes through the mapping, nothing is copied */
+    map = vfs_mmap(file, 0, size);
+    if (map != NULL)
+    {
+        cycles = rdtsc();
+        for (i = 0; i < size / sizeof(*map); i++)
+        {
+            sum += map[i];
+        }
+        cycles = rdtsc() - cycles;
+        vfs_munmap((void *) map, size);
+        bench_vfs_report("mmap scan ", size, cycles);
+    }
+
+    /* Lower bound for the warm read: copying from one buffer to another */
+    cycles = rdtsc();
+    for (i = 0; i + BENCH_VFS_CHUNK <= size; i += BENCH_VFS_CHUNK)
+    {
+        memcpy(buf, buf + (BENCH_VFS_CHUNK / 2U), BENCH_VFS_CHUNK / 2U);
+        memcpy(buf + (BENCH_VFS_CHUNK / 2U), buf, BENCH_VFS_CHUNK / 2U);
+    }
+    bench_vfs_report("memcpy    ", size, rdtsc() - cycles);
+
+    vfs_close(file);
+    kfree(buf);
+
+    kprintf("  lookup cold %10u cycles\n", (unsigned int) bench_vfs_lookup_pass(1));
+    cycles = bench_vfs_lookup_pass(BENCH_VFS_LOOKUPS);
+    kprintf("  lookup warm %10u cycles per walk\n",
+            (unsigned int) div_u64_rem(cycles, BENCH_VFS_LOOKUPS * ARRAY_SIZE(bench_vfs_paths),
+                                       NULL));
+
+    kprintf("vfs: dcache %u hits (%u negative) %u misses, %u entries (%u negative)\n",
+            stats->dcache_hits, stats->dcache_neg_hits, stats->dcache_misses,
+            stats->dcache_entries, stats->dcache_negative);
+    kprintf("vfs: page cache %u hits %u misses, %u pages cached, checksum %x\n",
+            stats->page_hits, stats->page_misses, stats->page_cached, sum);
+}
@@ -0,0 +1,147 @@
+/**
+ * @file console.c
+ *
+ * @brief Implementation of the kernel console
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "serial_port.h"
+#include "mutex.h"
+#include "rcu.h"
+#include "console.h"
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+static void console_screen_write(const char * buf, unsigned int len);
+static void console_com1_write(const char * buf, unsigned int len);
+
+static CONSOLE_SINK console_com1 =
+{
+    .name  = "com1",
+    .write = console_com1_write,
+    .flags = CONSOLE_SINK_SERIAL,
+};
+
+static CONSOLE_SINK console_screen =
+{
+    .name  = "screen",
+    .write = console_screen_write,
+    .next  = &console_com1,
+};
+
+/** Read under RCU, built in so kprintf() works from the first line of boot */
+static CONSOLE_SINK *console_sinks = &console_screen;
+
+/** Serialises the list updates */
+static MUTEX console_sinks_lock = MUTEX_INIT;
+
+/******************************************* Functions */
+/**
+ * @name console_screen_write
+ *
+ * @brief The screen sink
+ */
+static void console_screen_write(const char * buf, unsigned int len)
+{
+    fb_write((char *) buf, len, CONSOLE_FG_COLOR, CONSOLE_BG_COLOR);
+}
+
+/**
+ * @name console_com1_write
+ *
+ * @brief The COM1 sink, turns "\n" into "\r\n"
+ */
+static void console_com1_write(const char * buf, unsigned int len)
+{
+    unsigned int start = 0;
+    unsigned int i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (buf[i] == '\n')
+        {
+            serial_write(SERIAL_COM1_BASE, (char *) &buf[start], i - start);
+            serial_write(SERIAL_COM1_BASE, "\r\n", 2);
+            start = i + 1U;
+        }
+    }
+    serial_write(SERIAL_COM1_BASE, (char *) &buf[start], len - start);
+}
+
+/**
+ * @name console_fan_out
+ *
+ * @brief Writes to every sink having all of flags
+ */
+static void console_fan_out(const char * buf, unsigned int len, unsigned int flags)
+{
+    CONSOLE_SINK *sink;
+
+    rcu_read_lock();
+    for (sink = rcu_dereference(console_sinks); sink != NULL;
+         sink = rcu_dereference(sink->next))
+    {
+        if ((sink->flags & flags) == flags)
+        {
+            sink->write(buf, len);
+        }
+    }
+    rcu_read_unlock();
+}
+
+void console_write_serial(const char * buf, unsigned int len)
+{
+    console_fan_out(buf, len, CONSOLE_SINK_SERIAL);
+}
+
+void console_write(const char * buf, unsigned int len)
+{
+    console_fan_out(buf, len, 0);
+}
+
+int console_register(CONSOLE_SINK * sink)
+{
+    CONSOLE_SINK **link;
+
+    mutex_lock(&console_sinks_lock);
+    for (link = &console_sinks; *link != NULL; link = &(*link)->next)
+    {
+        if (*link == sink)
+        {
+            mutex_unlock(&console_sinks_lock);
+            return CONSOLE_ERR_BUSY;
+        }
+    }
+    sink->next = NULL;
+    rcu_assign_pointer(*link, sink);
+    mutex_unlock(&console_sinks_lock);
+    return CONSOLE_OK;
+}
+
+void console_unregister(CONSOLE_SINK * sink)
+{
+    CONSOLE_SINK **link;
+    int found = 0;
+
+    mutex_lock(&console_sinks_lock);
+    for (link = &console_sinks; *link != NULL; link = &(*link)->next)
+    {
+        if (*link == sink)
+        {
+            /* Writers on the sink keep following its next link */
+            rcu_assign_pointer(*link, sink->next);
+            found = 1;
+            break;
+        }
+    }
+    mutex_unlock(&console_sinks_lock);
+
+    if (found)
+    {
+        synchronize_rcu();
+    }
+}
@@ -0,0 +1,291 @@
+/**
+ * @file ftrace.c
+ *
+ * @brief Implementation of the function tracer
+ *
+ * @note Built without entry pads (see the makefile).
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "kstring.h"
+#include "kmalloc.h"
+#include "ksyms.h"
+#include "sched.h"
+#include "initcall.h"
+#include "ftrace.h"
+
+/******************************************* Defines */
+/** Opcode of call rel32 */
+#define FTRACE_OP_CALL          0xE8U
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+/** Pad addresses, from link.ld */
+extern const unsigned int ftrace_sites_start[];
+extern const unsigned int ftrace_sites_end[];
+
+/** The NOP a pad holds while its function is not traced */
+static const unsigned char ftrace_nop[FTRACE_PAD_SIZE] = { 0x0F, 0x1F, 0x44, 0x00, 0x00 };
+
+/** Sorted by address */
+static FTRACE_FUNC *ftrace_funcs;
+
+static FTRACE_STATS ftrace_stats;
+
+/** Set while a hook runs, functions it calls are not traced */
+static unsigned int ftrace_busy[CPU_MAX];
+
+/******************************************* Functions */
+/**
+ * @name ftrace_find
+ *
+ * @brief Returns the function of a pad
+ */
+static FTRACE_FUNC * ftrace_find(unsigned int site)
+{
+    unsigned int lo = 0;
+    unsigned int hi = ftrace_stats.sites;
+    unsigned int mid;
+
+    while (lo < hi)
+    {
+        mid = lo + ((hi - lo) / 2U);
+        if (ftrace_funcs[mid].addr == site)
+        {
+            return &ftrace_funcs[mid];
+        }
+        if (ftrace_funcs[mid].addr < site)
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+void ftrace_entry(unsigned int site, unsigned int * parent)
+{
+    FTRACE_FUNC *func;
+    FTRACE_FRAME *frame;
+    unsigned int flags;
+    TASK *task;
+
+    flags = local_irq_save();
+    if (ftrace_busy[cpu_id()])
+    {
+        local_irq_restore(flags);
+        return;
+    }
+    ftrace_busy[cpu_id()] = 1;
+
+    func = ftrace_find(site);
+    if ((func != NULL) && func->enabled)
+    {
+        func->calls++;
+
+        /* The frame lives in the thread, a traced call may sleep */
+        task = sched_current();
+        if (task->trace_depth < FTRACE_MAX_DEPTH)
+        {
+            frame = &task->trace[task->trace_depth++];
+            frame->func = func;
+            frame->ret = *parent;
+            *parent = (unsigned int) ftrace_return_tramp;
+            frame->start = rdtsc();
+        }
+        else
+        {
+            ftrace_stats.overflows++;
+        }
+    }
+
+    ftrace_busy[cpu_id()] = 0;
+    local_irq_restore(flags);
+}
+
+unsigned int ftrace_exit(void)
+{
+    unsigned long long now = rdtsc();
+    FTRACE_FRAME *frame;
+    unsigned int flags;
+    TASK *task;
+
+    flags = local_irq_save();
+    ftrace_busy[cpu_id()] = 1;
+
+    task = sched_current();
+    frame = &task->trace[--task->trace_depth];
+    frame->func->cycles += now - frame->start;
+
+    ftrace_busy[cpu_id()] = 0;
+    local_irq_restore(flags);
+    return frame->ret;
+}
+
+/**
+ * @name ftrace_patch
+ *
+ * @brief Writes the NOP or the call into a pad
+ *
+ * @note Runs with interrupts disabled and only one CPU, nothing executes
+ * the pad meanwhile.
+ */
+static void ftrace_patch(const FTRACE_FUNC * func, int enable)
+{
+    unsigned char *pad = (unsigned char *) func->addr;
+    unsigned char call[FTRACE_PAD_SIZE];
+    const unsigned char *code = ftrace_nop;
+    unsigned int rel;
+    unsigned int i;
+
+    if (enable)
+    {
+        rel = (unsigned int) ftrace_entry_tramp - (func->addr + FTRACE_PAD_SIZE);
+        call[0] = FTRACE_OP_CALL;
+        memcpy(&call[1], &rel, sizeof(rel));
+        code = call;
+    }
+
+    for (i = 0; i < FTRACE_PAD_SIZE; i++)
+    {
+        pad[i] = code[i];
+    }
+}
+
+/**
+ * @name ftrace_set
+ *
+ * @brief Enables or disables the functions matching pattern
+ */
+static int ftrace_set(const char * pattern, int enable)
+{
+    FTRACE_FUNC *func;
+    unsigned int matched = 0;
+    unsigned int flags;
+    unsigned int i;
+
+    flags = local_irq_save();
+    for (i = 0; i < ftrace_stats.sites; i++)
+    {
+        func = &ftrace_funcs[i];
+        if ((func->name == NULL) || !glob_match(pattern, func->name))
+        {
+            continue;
+        }
+        matched++;
+        if (func->enabled == (unsigned int) enable)
+        {
+            continue;
+        }
+        ftrace_patch(func, enable);
+        func->enabled = (unsigned int) enable;
+        if (enable)
+        {
+            ftrace_stats.enabled++;
+        }
+        else
+        {
+            ftrace_stats.enabled--;
+        }
+    }
+    local_irq_restore(flags);
+
+    return (matched != 0) ? (int) matched : FTRACE_ERR_NOENT;
+}
+
+int ftrace_enable(const char * pattern)
+{
+    return ftrace_set(pattern, 1);
+}
+
+int ftrace_disable(const char * pattern)
+{
+    return ftrace_set(pattern, 0);
+}
+
+void ftrace_reset(void)
+{
+    unsigned int flags;
+    unsigned int i;
+
+    flags = local_irq_save();
+    for (i = 0; i < ftrace_stats.sites; i++)
+    {
+        ftrace_funcs[i].calls = 0;
+        ftrace_funcs[i].cycles = 0;
+    }
+    ftrace_stats.overflows = 0;
+    local_irq_restore(flags);
+}
+
+void ftrace_for_each(void (*fn)(const FTRACE_FUNC * func))
+{
+    unsigned int i;
+
+    for (i = 0; i < ftrace_stats.sites; i++)
+    {
+        if (ftrace_funcs[i].calls != 0)
+        {
+            fn(&ftrace_funcs[i]);
+        }
+    }
+}
+
+const FTRACE_STATS * ftrace_get_stats(void)
+{
+    return &ftrace_stats;
+}
+
+/**
+ * @name ftrace_initcall
+ *
+ * @brief Builds the sorted function table and turns every pad into one NOP
+ */
+static int ftrace_initcall(void)
+{
+    unsigned int sites = (unsigned int) (ftrace_sites_end - ftrace_sites_start);
+    FTRACE_FUNC func;
+    unsigned int offset = 0;
+    unsigned int flags;
+    unsigned int i;
+    unsigned int j;
+
+    ftrace_funcs = kzalloc(sites * sizeof(*ftrace_funcs));
+    if ((sites != 0) && (ftrace_funcs == NULL))
+    {
+        return FTRACE_ERR_NOMEM;
+    }
+
+    /* Insertion sort, the sites come in link order and are nearly sorted */
+    for (i = 0; i < sites; i++)
+    {
+        func.addr = ftrace_sites_start[i];
+        func.name = ksym_lookup(func.addr, &offset);
+        if (offset != 0)
+        {
+            func.name = NULL;
+        }
+        for (j = i; (j > 0) && (ftrace_funcs[j - 1U].addr > func.addr); j--)
+        {
+            ftrace_funcs[j] = ftrace_funcs[j - 1U];
+        }
+        ftrace_funcs[j].addr = func.addr;
+        ftrace_funcs[j].name = func.name;
+    }
+    ftrace_stats.sites = sites;
+
+    flags = local_irq_save();
+    for (i = 0; i < sites; i++)
+    {
+        ftrace_patch(&ftrace_funcs[i], 0);
+    }
+    local_irq_restore(flags);
+    return 0;
+}
+INITCALL_CORE(ftrace_initcall);
@@ -0,0 +1,88 @@
+/**
+ * @file futex.c
+ *
+ * @brief Implementation of futex style waiting
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "sched.h"
+#include "futex.h"
+
+/******************************************* Defines */
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct FUTEX_WAITER
+ * @brief A sleeping thread, lives on its stack while it waits
+ */
+typedef struct _FUTEX_WAITER
+{
+    struct _FUTEX_WAITER  *next;
+    volatile unsigned int *addr;
+    TASK                  *task;
+    volatile unsigned int  woken;
+} FUTEX_WAITER;
+
+/******************************************* Macros */
+/** Words are 4 byte aligned, hash on the bits above */
+#define FUTEX_HASH(addr)        ((((unsigned int) (addr)) >> 2) & (FUTEX_HASH_BUCKETS - 1U))
+
+/******************************************* Static global defines */
+/* Protected by disabling interrupts */
+static FUTEX_WAITER *futex_buckets[FUTEX_HASH_BUCKETS];
+
+/******************************************* Functions */
+int futex_wait(volatile unsigned int * addr, unsigned int val)
+{
+    FUTEX_WAITER **bucket = &futex_buckets[FUTEX_HASH(addr)];
+    FUTEX_WAITER waiter;
+    unsigned int flags;
+
+    flags = local_irq_save();
+    if (*addr != val)
+    {
+        local_irq_restore(flags);
+        return FUTEX_ERR_AGAIN;
+    }
+
+    waiter.addr = addr;
+    waiter.task = sched_current();
+    waiter.woken = 0;
+    waiter.next = *bucket;
+    *bucket = &waiter;
+
+    /* The waker unlinks us before setting woken */
+    while (!waiter.woken)
+    {
+        waiter.task->state = TASK_SLEEPING;
+        schedule();
+    }
+    local_irq_restore(flags);
+    return FUTEX_OK;
+}
+
+unsigned int futex_wake(volatile unsigned int * addr, unsigned int count)
+{
+    FUTEX_WAITER **link = &futex_buckets[FUTEX_HASH(addr)];
+    FUTEX_WAITER *waiter;
+    unsigned int woken = 0;
+    unsigned int flags;
+
+    flags = local_irq_save();
+    while (((waiter = *link) != NULL) && (woken < count))
+    {
+        if (waiter->addr != addr)
+        {
+            link = &waiter->next;
+            continue;
+        }
+        *link = waiter->next;
+        waiter->woken = 1;
+        sched_wake(waiter->task);
+        woken++;
+    }
+    local_irq_restore(flags);
+    return woken;
+}
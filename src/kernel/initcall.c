@@ -0,0 +1,259 @@
+/**
+ * @file initcall.c
+ *
+ * @brief Implementation of the initcall levels and the boot timeline
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "tsc.h"
+#include "kstring.h"
+#include "kprintf.h"
+#include "console.h"
+#include "sched.h"
+#include "workqueue.h"
+#include "wait.h"
+#include "initcall.h"
+
+/******************************************* Defines */
+/* Per initcall state */
+#define INITCALL_STATE_NONE     0U      /**< Not run yet */
+#define INITCALL_STATE_RUNNING  1U
+#define INITCALL_STATE_DONE     2U
+
+/** Line buffer of the report */
+#define INITCALL_LINE_MAX       96U
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+/* From link.ld, the .initcall<level> sections in level order */
+extern const INITCALL initcall_start[];
+extern const INITCALL initcall_end[];
+
+/** TSC stored by the first instructions of loader.s */
+extern unsigned long long boot_tsc;
+
+/** Threads waiting for an initcall another thread is running */
+static WAIT_QUEUE initcall_wait = WAIT_QUEUE_INIT;
+
+static INITCALL_RECORD initcall_records[INITCALL_MAX_RECORDS];
+
+static unsigned int initcall_nr_records;
+
+static void initcall_async(WORK * work);
+
+/** Runs the asynchronous initcalls in the kworker */
+static WORK initcall_async_work = WORK_INIT(initcall_async);
+
+/******************************************* Functions */
+
+/**
+ * @name initcall_record
+ *
+ * @brief Appends an entry to the boot timeline
+ */
+static INITCALL_RECORD * initcall_record(const char * name, unsigned int level,
+                                         unsigned int flags)
+{
+    INITCALL_RECORD *rec;
+
+    if (initcall_nr_records == INITCALL_MAX_RECORDS)
+    {
+        return NULL;
+    }
+    rec = &initcall_records[initcall_nr_records++];
+    rec->name = name;
+    rec->level = level;
+    rec->flags = flags;
+    rec->ret = 0;
+    rec->start = rdtsc();
+    rec->end = rec->start;
+    return rec;
+}
+
+/**
+ * @name initcall_invoke
+ *
+ * @brief Runs one initcall and records it
+ */
+static int initcall_invoke(const INITCALL * ic)
+{
+    INITCALL_STATE *st = ic->state;
+    INITCALL_RECORD *rec;
+    int ret;
+
+    /* Running in another thread that went to sleep, wait for it */
+    wait_event(&initcall_wait, st->state != INITCALL_STATE_RUNNING);
+    if (st->state == INITCALL_STATE_DONE)
+    {
+        return st->ret;
+    }
+    st->state = INITCALL_STATE_RUNNING;
+
+    rec = initcall_record(ic->name, ic->level, ic->flags);
+    ret = ic->fn();
+    if (rec != NULL)
+    {
+        rec->end = rdtsc();
+        rec->ret = ret;
+    }
+
+    st->ret = ret;
+    st->state = INITCALL_STATE_DONE;
+    if (waitqueue_active(&initcall_wait))
+    {
+        wake_up_all(&initcall_wait);
+    }
+    return ret;
+}
+
+void initcall_run_all(void)
+{
+    const INITCALL *ic;
+    INITCALL_RECORD *rec;
+
+    /* Entry of the boot timeline, nothing ran before the loader */
+    rec = initcall_record("loader", 0, INITCALL_SYNC);
+    if (rec != NULL)
+    {
+        rec->start = boot_tsc;
+        rec->end = boot_tsc;
+    }
+    initcall_record("kmain", 0, INITCALL_SYNC);
+
+    for (ic = initcall_start; ic < initcall_end; ic++)
+    {
+        if (ic->flags == INITCALL_SYNC)
+        {
+            if (initcall_invoke(ic) < 0)
+            {
+                kprintf("initcall: %s failed %d\n", ic->name, ic->state->ret);
+            }
+        }
+    }
+    queue_work(&initcall_async_work);
+}
+
+void initcall_mark_ready(void)
+{
+    initcall_record("ready", INITCALL_NR_LEVELS, INITCALL_SYNC);
+}
+
+/**
+ * @name initcall_async
+ *
+ * @brief Runs the asynchronous initcalls, then sends the timeline to COM1
+ */
+static void initcall_async(WORK * work)
+{
+    const INITCALL *ic;
+
+    (void) work;
+
+    for (ic = initcall_start; ic < initcall_end; ic++)
+    {
+        if (ic->flags & INITCALL_ASYNC)
+        {
+            initcall_invoke(ic);
+        }
+    }
+    initcall_report(console_write_serial);
+}
+
+int initcall_sync(const char * name)
+{
+    const INITCALL *ic;
+
+    for (ic = initcall_start; ic < initcall_end; ic++)
+    {
+        if (strcmp(ic->name, name) == 0)
+        {
+            return initcall_invoke(ic);
+        }
+    }
+    return INITCALL_ERR_NOENT;
+}
+
+void initcall_sync_all(void)
+{
+    const INITCALL *ic;
+
+    for (ic = initcall_start; ic < initcall_end; ic++)
+    {
+        initcall_invoke(ic);
+    }
+}
+
+/**
+ * @name initcall_mode
+ *
+ * @brief Suffix of a timeline line
+ */
+static const char * initcall_mode(unsigned int flags)
+{
+    if (flags & INITCALL_ASYNC)
+    {
+        return " [async]";
+    }
+    if (flags & INITCALL_DEFERRED)
+    {
+        return " [deferred]";
+    }
+    return "";
+}
+
+void initcall_report(INITCALL_OUT out)
+{
+    char line[INITCALL_LINE_MAX];
+    const INITCALL_RECORD *rec;
+    unsigned long long sync_cycles = 0;
+    unsigned long long ready = 0;
+    unsigned int len;
+    unsigned int i;
+
+    if (tsc_khz() == 0)
+    {
+        tsc_calibrate();
+    }
+
+    len = ksnprintf(line, sizeof(line),
+                    "boot timeline, TSC %u kHz, loader entered %u ms after reset\n",
+                    tsc_khz(),
+                    (unsigned int) div_u64_rem(tsc_cycles_to_us(boot_tsc), 1000U, NULL));
+    out(line, len);
+    len = ksnprintf(line, sizeof(line), "     start us   took us  lvl  name\n");
+    out(line, len);
+
+    for (i = 0; i < initcall_nr_records; i++)
+    {
+        rec = &initcall_records[i];
+        len = ksnprintf(line, sizeof(line), "  %10u %9u  %3u  %s%s",
+                        (unsigned int) tsc_cycles_to_us(rec->start - boot_tsc),
+                        (unsigned int) tsc_cycles_to_us(rec->end - rec->start),
+                        rec->level, rec->name, initcall_mode(rec->flags));
+        out(line, len);
+        if (rec->ret < 0)
+        {
+            len = ksnprintf(line, sizeof(line), " failed %d", rec->ret);
+            out(line, len);
+        }
+        out("\n", 1);
+
+        if (strcmp(rec->name, "ready") == 0)
+        {
+            ready = rec->start - boot_tsc;
+        }
+        else if (rec->flags == INITCALL_SYNC)
+        {
+            sync_cycles += rec->end - rec->start;
+        }
+    }
+
+    len = ksnprintf(line, sizeof(line),
+                    "ready after %u us, %u us of it in synchronous initcalls\n",
+                    (unsigned int) tsc_cycles_to_us(ready),
+                    (unsigned int) tsc_cycles_to_us(sync_cycles));
+    out(line, len);
+}
@@ -0,0 +1,199 @@
+/**
+ * @file input.c
+ *
+ * @brief Implementation of the input rings and the lazy decoding consumer
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "kstring.h"
+#include "keyboard.h"
+#include "sched.h"
+#include "wait.h"
+#include "input.h"
+
+/******************************************* Defines */
+#define INPUT_RING_MASK         (INPUT_RING_SIZE - 1U)
+
+/* Serial bytes that need translating */
+#define INPUT_SERIAL_CR         '\r'
+#define INPUT_SERIAL_DEL        0x7F
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+static INPUT_RING input_rings[INPUT_NR_SOURCES];
+
+static INPUT_STATS input_stats[INPUT_NR_SOURCES];
+
+/** Readers sleeping in input_getc() */
+static WAIT_QUEUE input_wait = WAIT_QUEUE_INIT;
+
+/******************************************* Functions */
+void input_push(unsigned int src, unsigned int code)
+{
+    INPUT_RING *ring = &input_rings[src];
+    unsigned int head = ring->head;
+    INPUT_EVENT *ev;
+
+    if (head - ring->tail >= INPUT_RING_SIZE)
+    {
+        ring->dropped++;
+        return;
+    }
+
+    ev = &ring->ev[head & INPUT_RING_MASK];
+    ev->tsc = rdtsc();
+    ev->code = code;
+
+    /* The event must be visible before the consumer can see the new head */
+    wmb();
+    ring->head = head + 1U;
+
+    if (waitqueue_active(&input_wait))
+    {
+        wake_up(&input_wait);
+    }
+}
+
+/**
+ * @name input_pending
+ *
+ * @brief Returns 1 if any ring holds an event
+ */
+static int input_pending(void)
+{
+    unsigned int src;
+
+    for (src = 0; src < INPUT_NR_SOURCES; src++)
+    {
+        if (input_rings[src].head != input_rings[src].tail)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @name input_pop
+ *
+ * @brief Takes the oldest event of a ring and accounts its latency
+ *
+ * @return 1 if an event was returned, 0 if the ring is empty
+ */
+static int input_pop(unsigned int src, INPUT_EVENT * out)
+{
+    INPUT_RING *ring = &input_rings[src];
+    INPUT_STATS *stats = &input_stats[src];
+    unsigned int tail = ring->tail;
+    unsigned long long lat;
+
+    if (tail == ring->head)
+    {
+        return 0;
+    }
+    rmb();
+    *out = ring->ev[tail & INPUT_RING_MASK];
+
+    /* Done reading the slot before handing it back to the producer */
+    barrier();
+    ring->tail = tail + 1U;
+
+    lat = rdtsc() - out->tsc;
+    stats->events++;
+    stats->lat_sum += lat;
+    if ((stats->lat_min == 0) || (lat < stats->lat_min))
+    {
+        stats->lat_min = lat;
+    }
+    if (lat > stats->lat_max)
+    {
+        stats->lat_max = lat;
+    }
+    return 1;
+}
+
+/**
+ * @name input_decode
+ *
+ * @brief Turns a raw event into a character, or -1 if it produces none
+ */
+static int input_decode(unsigned int src, unsigned int code)
+{
+    if (src == INPUT_SRC_KEYBOARD)
+    {
+        return keyboard_decode((unsigned char) code);
+    }
+
+    /* Terminals send CR for Enter and DEL for Backspace */
+    switch (code)
+    {
+    case INPUT_SERIAL_CR:
+        return '\n';
+    case INPUT_SERIAL_DEL:
+        return INPUT_CHAR_BACKSPACE;
+    default:
+        return (int) code;
+    }
+}
+
+int input_trygetc(void)
+{
+    INPUT_EVENT ev;
+    unsigned int src;
+    int c;
+
+    for (src = 0; src < INPUT_NR_SOURCES; src++)
+    {
+        while (input_pop(src, &ev))
+        {
+            c = input_decode(src, ev.code);
+            if (c >= 0)
+            {
+                input_stats[src].chars++;
+                return c;
+            }
+        }
+    }
+    return -1;
+}
+
+int input_getc(void)
+{
+    int c;
+
+    while (1)
+    {
+        c = input_trygetc();
+        if (c >= 0)
+        {
+            return c;
+        }
+
+        /* Other threads run meanwhile, the scheduler halts when none can */
+        wait_event(&input_wait, input_pending());
+    }
+}
+
+const INPUT_STATS * input_get_stats(unsigned int src)
+{
+    input_stats[src].dropped = input_rings[src].dropped;
+    return &input_stats[src];
+}
+
+void input_reset_stats(void)
+{
+    unsigned int flags;
+    unsigned int src;
+
+    /* dropped belongs to the producer, keep its handler out meanwhile */
+    flags = local_irq_save();
+    for (src = 0; src < INPUT_NR_SOURCES; src++)
+    {
+        memset(&input_stats[src], 0, sizeof(input_stats[src]));
+        input_rings[src].dropped = 0;
+    }
+    local_irq_restore(flags);
+}
@@ -0,0 +1,366 @@
+/**
+ * @file ipc.c
+ *
+ * @brief Implementation of the message channels
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "kstring.h"
+#include "pmm.h"
+#include "futex.h"
+#include "ipc.h"
+
+/******************************************* Defines */
+/** Largest ring */
+#define IPC_MAX_SLOTS           4096U
+/** Largest inline payload */
+#define IPC_MAX_INLINE          PAGE_SIZE
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct IPC_CHAN
+ * @brief Channel header, at the start of its pages, the slots follow
+ *
+ * @par Senders and the receiver each write one cache line only; the
+ * read-only part sits on a third one.
+ */
+struct _IPC_CHAN
+{
+    /* Written by senders */
+    volatile unsigned int head __attribute__((aligned(CACHE_LINE_SIZE)));
+    volatile unsigned int send_waiters;
+    volatile unsigned int sent;
+    volatile unsigned int granted;
+    volatile unsigned int send_waits;
+
+    /* Written by the receiver */
+    volatile unsigned int tail __attribute__((aligned(CACHE_LINE_SIZE)));
+    volatile unsigned int recv_waiters;
+    unsigned int          received;
+    unsigned int          recv_waits;
+
+    /* Set at creation */
+    unsigned int          nr_slots __attribute__((aligned(CACHE_LINE_SIZE)));
+    unsigned int          slot_size;
+    unsigned int          flags;
+    unsigned int          npages;     /**< Pages of header and ring */
+    unsigned char        *slots;
+};
+
+/******************************************* Macros */
+#define IPC_PAGES(len)          (ALIGN_UP((len), PAGE_SIZE) >> PAGE_SHIFT)
+
+/******************************************* Functions */
+/**
+ * @name ipc_slot
+ *
+ * @brief Slot of a ring position
+ */
+static inline IPC_MSG * ipc_slot(const IPC_CHAN * chan, unsigned int pos)
+{
+    return (IPC_MSG *) (chan->slots + (pos & (chan->nr_slots - 1U)) * chan->slot_size);
+}
+
+/**
+ * @name ipc_count
+ *
+ * @brief Bumps a sender counter, locked only if senders can race on it
+ */
+static inline void ipc_count(IPC_CHAN * chan, volatile unsigned int * counter)
+{
+    if (chan->flags & IPC_CHAN_MPSC)
+    {
+        atomic_add(counter, 1);
+    }
+    else
+    {
+        (*counter)++;
+    }
+}
+
+IPC_CHAN * ipc_chan_create(unsigned int nr_slots, unsigned int max_inline,
+                           unsigned int flags, int * err)
+{
+    unsigned int header = ALIGN_UP(sizeof(IPC_CHAN), CACHE_LINE_SIZE);
+    unsigned int slot_size;
+    unsigned int npages;
+    unsigned int pos;
+    IPC_CHAN *chan;
+
+    if ((nr_slots < 2U) || (nr_slots > IPC_MAX_SLOTS) || (nr_slots & (nr_slots - 1U)) ||
+        (max_inline > IPC_MAX_INLINE))
+    {
+        if (err != NULL)
+        {
+            *err = IPC_ERR_INVAL;
+        }
+        return NULL;
+    }
+
+    slot_size = ALIGN_UP(sizeof(IPC_MSG) + max_inline, CACHE_LINE_SIZE);
+    npages = IPC_PAGES(header + nr_slots * slot_size);
+    chan = pmm_alloc_pages(npages);
+    if (chan == NULL)
+    {
+        if (err != NULL)
+        {
+            *err = IPC_ERR_NOMEM;
+        }
+        return NULL;
+    }
+
+    memset(chan, 0, header);
+    chan->nr_slots = nr_slots;
+    chan->slot_size = slot_size;
+    chan->flags = flags;
+    chan->npages = npages;
+    chan->slots = (unsigned char *) chan + header;
+
+    /* Every slot starts free for the first lap */
+    for (pos = 0; pos < nr_slots; pos++)
+    {
+        ipc_slot(chan, pos)->seq = pos;
+    }
+
+    if (err != NULL)
+    {
+        *err = IPC_OK;
+    }
+    return chan;
+}
+
+void ipc_chan_destroy(IPC_CHAN * chan)
+{
+    IPC_MSG *msg;
+    unsigned int pos;
+
+    /* Committed and never received */
+    for (pos = chan->tail; ; pos++)
+    {
+        msg = ipc_slot(chan, pos);
+        if (msg->seq != pos + 1U)
+        {
+            break;
+        }
+        if (msg->flags & IPC_MSG_PAGES)
+        {
+            pmm_free_pages(msg->pages, msg->npages);
+        }
+    }
+    pmm_free_pages(chan, chan->npages);
+}
+
+unsigned int ipc_chan_max_inline(const IPC_CHAN * chan)
+{
+    return chan->slot_size - sizeof(IPC_MSG);
+}
+
+int ipc_send_begin(IPC_CHAN * chan, IPC_MSG ** msg, unsigned int flags)
+{
+    IPC_MSG *slot;
+    unsigned int pos;
+    unsigned int seq;
+    int diff;
+
+    pos = chan->head;
+    while (1)
+    {
+        slot = ipc_slot(chan, pos);
+        seq = slot->seq;
+        diff = (int) (seq - pos);
+        if (diff == 0)
+        {
+            if (!(chan->flags & IPC_CHAN_MPSC))
+            {
+                chan->head = pos + 1U;
+                break;
+            }
+            if (cmpxchg(&chan->head, pos, pos + 1U) == pos)
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            /* Full: the slot still holds the message of the last lap */
+            if (flags & IPC_NONBLOCK)
+            {
+                return IPC_ERR_AGAIN;
+            }
+            ipc_count(chan, &chan->send_waits);
+            atomic_add(&chan->send_waiters, 1);
+            futex_wait(&slot->seq, seq);
+            atomic_add(&chan->send_waiters, (unsigned int) -1);
+        }
+        /* Otherwise another sender took it, try the next one */
+        pos = chan->head;
+    }
+
+    slot->pos = pos;
+    slot->len = 0;
+    slot->flags = 0;
+    slot->pages = NULL;
+    slot->npages = 0;
+    *msg = slot;
+    return IPC_OK;
+}
+
+void ipc_send_commit(IPC_CHAN * chan, IPC_MSG * msg)
+{
+    msg->tsc = rdtsc();
+    ipc_count(chan, &chan->sent);
+    if (msg->flags & IPC_MSG_PAGES)
+    {
+        ipc_count(chan, &chan->granted);
+    }
+
+    wmb();
+    msg->seq = msg->pos + 1U;
+
+    /* Publish before looking for sleepers, futex_wait() rechecks seq */
+    mb();
+    if (chan->recv_waiters != 0)
+    {
+        futex_wake(&msg->seq, FUTEX_WAKE_ALL);
+    }
+}
+
+int ipc_recv_begin(IPC_CHAN * chan, IPC_MSG ** msg, unsigned int flags)
+{
+    unsigned int pos = chan->tail;
+    IPC_MSG *slot = ipc_slot(chan, pos);
+    unsigned int seq;
+
+    while ((seq = slot->seq) != pos + 1U)
+    {
+        if (flags & IPC_NONBLOCK)
+        {
+            return IPC_ERR_AGAIN;
+        }
+        chan->recv_waits++;
+        atomic_add(&chan->recv_waiters, 1);
+        futex_wait(&slot->seq, seq);
+        atomic_add(&chan->recv_waiters, (unsigned int) -1);
+    }
+
+    rmb();
+    *msg = slot;
+    return IPC_OK;
+}
+
+void ipc_recv_end(IPC_CHAN * chan, IPC_MSG * msg)
+{
+    chan->tail = msg->pos + 1U;
+    chan->received++;
+
+    /* Free for the sender of the next lap */
+    barrier();
+    msg->seq = msg->pos + chan->nr_slots;
+
+    mb();
+    if (chan->send_waiters != 0)
+    {
+        futex_wake(&msg->seq, FUTEX_WAKE_ALL);
+    }
+}
+
+int ipc_send(IPC_CHAN * chan, const void * buf, unsigned int len, unsigned int flags)
+{
+    IPC_MSG *msg;
+    int ret;
+
+    if (len > ipc_chan_max_inline(chan))
+    {
+        return IPC_ERR_MSGSIZE;
+    }
+
+    ret = ipc_send_begin(chan, &msg, flags);
+    if (ret != IPC_OK)
+    {
+        return ret;
+    }
+    memcpy(IPC_MSG_DATA(msg), buf, len);
+    msg->len = len;
+    ipc_send_commit(chan, msg);
+    return IPC_OK;
+}
+
+int ipc_recv(IPC_CHAN * chan, void * buf, unsigned int size, unsigned int flags)
+{
+    IPC_MSG *msg;
+    int len;
+    int ret;
+
+    ret = ipc_recv_begin(chan, &msg, flags);
+    if (ret != IPC_OK)
+    {
+        return ret;
+    }
+
+    /* Too large: leave it queued */
+    if (msg->len > size)
+    {
+        return IPC_ERR_MSGSIZE;
+    }
+
+    len = (int) msg->len;
+    if (msg->flags & IPC_MSG_PAGES)
+    {
+        memcpy(buf, msg->pages, msg->len);
+        pmm_free_pages(msg->pages, msg->npages);
+    }
+    else
+    {
+        memcpy(buf, IPC_MSG_DATA(msg), msg->len);
+    }
+    ipc_recv_end(chan, msg);
+    return len;
+}
+
+void * ipc_page_alloc(unsigned int len)
+{
+    if ((len == 0) || (len > IPC_GRANT_MAX_PAGES * PAGE_SIZE))
+    {
+        return NULL;
+    }
+    return pmm_alloc_pages(IPC_PAGES(len));
+}
+
+void ipc_page_free(void * pages, unsigned int len)
+{
+    pmm_free_pages(pages, IPC_PAGES(len));
+}
+
+int ipc_send_pages(IPC_CHAN * chan, void * pages, unsigned int len, unsigned int flags)
+{
+    IPC_MSG *msg;
+    int ret;
+
+    if ((pages == NULL) || (len == 0) || (len > IPC_GRANT_MAX_PAGES * PAGE_SIZE))
+    {
+        return IPC_ERR_INVAL;
+    }
+
+    ret = ipc_send_begin(chan, &msg, flags);
+    if (ret != IPC_OK)
+    {
+        return ret;
+    }
+    msg->flags = IPC_MSG_PAGES;
+    msg->pages = pages;
+    msg->npages = IPC_PAGES(len);
+    msg->len = len;
+    ipc_send_commit(chan, msg);
+    return IPC_OK;
+}
+
+void ipc_chan_get_stats(const IPC_CHAN * chan, IPC_STATS * stats)
+{
+    stats->sent = chan->sent;
+    stats->granted = chan->granted;
+    stats->send_waits = chan->send_waits;
+    stats->received = chan->received;
+    stats->recv_waits = chan->recv_waits;
+}
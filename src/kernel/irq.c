@@ -0,0 +1,284 @@
+/**
+ * @file irq.c
+ *
+ * @brief Implementation of the PIC setup and interrupt dispatch
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "io.h"
+#include "kprintf.h"
+#include "kmalloc.h"
+#include "idt.h"
+#include "irq.h"
+#include "softirq.h"
+#include "rcu.h"
+#include "initcall.h"
+
+/******************************************* Defines */
+/** Unused port, writing to it gives the PIC time to settle */
+#define IRQ_IO_WAIT_PORT        0x80
+
+/** Lines where the PIC reports spurious interrupts */
+#define IRQ_SPURIOUS_MASTER     7U
+#define IRQ_SPURIOUS_SLAVE      15U
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+/**
+ * @struct IRQ_ACTION
+ * @brief Registered handler of a line, never changed once published
+ */
+typedef struct _IRQ_ACTION
+{
+    IRQ_HANDLER  handler;
+    void        *ctx;                 /**< Handler argument */
+} IRQ_ACTION;
+
+/** Read under RCU by the dispatch, NULL if the line is free */
+static IRQ_ACTION *irq_actions[IRQ_COUNT];
+
+static IRQ_STATS irq_stats;
+
+static const char * const irq_exception_names[IDT_NR_EXCEPTIONS] =
+{
+    "divide error", "debug", "NMI", "breakpoint", "overflow", "bound range",
+    "invalid opcode", "device not available", "double fault", "coprocessor overrun",
+    "invalid TSS", "segment not present", "stack fault", "general protection",
+    "page fault", "reserved", "x87 fault", "alignment check", "machine check",
+    "SIMD fault", "virtualization", "control protection", "reserved", "reserved",
+    "reserved", "reserved", "reserved", "reserved", "reserved", "VMM communication",
+    "security", "reserved",
+};
+
+/******************************************* Functions */
+
+/**
+ * @name irq_io_wait
+ *
+ * @brief Short delay between PIC initialisation words
+ */
+static void irq_io_wait(void)
+{
+    outb(IRQ_IO_WAIT_PORT, 0);
+}
+
+void irq_init(void)
+{
+    idt_install();
+
+    /* ICW1: start initialisation of both PICs */
+    outb(PIC1_COMMAND, PIC_ICW1_INIT_ICW4);
+    irq_io_wait();
+    outb(PIC2_COMMAND, PIC_ICW1_INIT_ICW4);
+    irq_io_wait();
+    /* ICW2: vector offsets */
+    outb(PIC1_DATA, IDT_IRQ_BASE);
+    irq_io_wait();
+    outb(PIC2_DATA, IDT_IRQ_BASE + 8U);
+    irq_io_wait();
+    /* ICW3: slave on line 2 of the master, and its cascade identity */
+    outb(PIC1_DATA, 1U << IRQ_CASCADE);
+    irq_io_wait();
+    outb(PIC2_DATA, IRQ_CASCADE);
+    irq_io_wait();
+    /* ICW4 */
+    outb(PIC1_DATA, PIC_ICW4_8086);
+    irq_io_wait();
+    outb(PIC2_DATA, PIC_ICW4_8086);
+    irq_io_wait();
+
+    /* Everything masked except the cascade */
+    outb(PIC1_DATA, (unsigned char) ~(1U << IRQ_CASCADE));
+    outb(PIC2_DATA, 0xFF);
+}
+
+int irq_register(unsigned int irq, IRQ_HANDLER handler, void * ctx)
+{
+    IRQ_ACTION *action;
+
+    if ((irq >= IRQ_COUNT) || (handler == NULL))
+    {
+        return IRQ_ERR_INVAL;
+    }
+    if (rcu_dereference(irq_actions[irq]) != NULL)
+    {
+        return IRQ_ERR_BUSY;
+    }
+
+    action = kmalloc(sizeof(*action));
+    if (action == NULL)
+    {
+        return IRQ_ERR_NOMEM;
+    }
+    action->handler = handler;
+    action->ctx = ctx;
+
+    /* Publishes the initialised action, or loses a race for the line */
+    wmb();
+    if (cmpxchg_ptr((void * volatile *) &irq_actions[irq], NULL, action) != NULL)
+    {
+        kfree(action);
+        return IRQ_ERR_BUSY;
+    }
+    return IRQ_OK;
+}
+
+void irq_unregister(unsigned int irq)
+{
+    IRQ_ACTION *action;
+
+    if (irq >= IRQ_COUNT)
+    {
+        return;
+    }
+    irq_mask(irq);
+
+    action = xchg_ptr((void * volatile *) &irq_actions[irq], NULL);
+    if (action == NULL)
+    {
+        return;
+    }
+
+    /* A handler that already loaded the action may still be running */
+    synchronize_rcu();
+    kfree(action);
+}
+
+void irq_unmask(unsigned int irq)
+{
+    unsigned short port = (irq < 8U) ? PIC1_DATA : PIC2_DATA;
+    unsigned int flags;
+
+    if (irq >= IRQ_COUNT)
+    {
+        return;
+    }
+    flags = local_irq_save();
+    outb(port, inb(port) & ~(1U << (irq & 7U)));
+    local_irq_restore(flags);
+}
+
+void irq_mask(unsigned int irq)
+{
+    unsigned short port = (irq < 8U) ? PIC1_DATA : PIC2_DATA;
+    unsigned int flags;
+
+    if (irq >= IRQ_COUNT)
+    {
+        return;
+    }
+    flags = local_irq_save();
+    outb(port, inb(port) | (1U << (irq & 7U)));
+    local_irq_restore(flags);
+}
+
+const IRQ_STATS * irq_get_stats(void)
+{
+    return &irq_stats;
+}
+
+/**
+ * @name irq_is_spurious
+ *
+ * @brief Checks the in-service register for a spurious IRQ 7 or 15
+ */
+static int irq_is_spurious(unsigned int irq)
+{
+    unsigned short port = (irq < 8U) ? PIC1_COMMAND : PIC2_COMMAND;
+
+    outb(port, PIC_OCW3_READ_ISR);
+    return !(inb(port) & (1U << (irq & 7U)));
+}
+
+/**
+ * @name irq_exception
+ *
+ * @brief Reports a CPU exception and stops
+ */
+static void irq_exception(INTERRUPT_FRAME * frame)
+{
+    unsigned int cr2;
+
+    asm volatile ("mov %%cr2, %0" : "=r" (cr2));
+    kprintf("\nexception %u (%s) error %x\n", frame->vector,
+            irq_exception_names[frame->vector], frame->error_code);
+    kprintf("  eip %08x cs %04x eflags %08x cr2 %08x\n",
+            frame->eip, frame->cs, frame->eflags, cr2);
+    kprintf("  eax %08x ebx %08x ecx %08x edx %08x\n",
+            frame->eax, frame->ebx, frame->ecx, frame->edx);
+    kprintf("  esi %08x edi %08x ebp %08x esp %08x\n",
+            frame->esi, frame->edi, frame->ebp, frame->esp);
+
+    while (1)
+    {
+        asm volatile ("cli; hlt");
+    }
+}
+
+void interrupt_dispatch(INTERRUPT_FRAME * frame)
+{
+    IRQ_ACTION *action;
+    unsigned int irq;
+
+    if (frame->vector < IDT_NR_EXCEPTIONS)
+    {
+        irq_exception(frame);
+        return;
+    }
+
+    irq = frame->vector - IDT_IRQ_BASE;
+    if (irq >= IRQ_COUNT)
+    {
+        return;
+    }
+
+    if (((irq == IRQ_SPURIOUS_MASTER) || (irq == IRQ_SPURIOUS_SLAVE)) &&
+        irq_is_spurious(irq))
+    {
+        /* The master did raise the cascade line for a spurious slave IRQ */
+        if (irq == IRQ_SPURIOUS_SLAVE)
+        {
+            outb(PIC1_COMMAND, PIC_EOI);
+        }
+        irq_stats.spurious++;
+        return;
+    }
+
+    irq_enter();
+    irq_stats.count[irq]++;
+    rcu_read_lock();
+    action = rcu_dereference(irq_actions[irq]);
+    if (action != NULL)
+    {
+        action->handler(irq, action->ctx);
+    }
+    else
+    {
+        irq_stats.unhandled++;
+    }
+    rcu_read_unlock();
+
+    if (irq >= 8U)
+    {
+        outb(PIC2_COMMAND, PIC_EOI);
+    }
+    outb(PIC1_COMMAND, PIC_EOI);
+
+    /* Bottom halves, with the line free to fire again */
+    irq_exit();
+}
+
+/**
+ * @name irq_initcall
+ *
+ * @brief Installs the IDT and remaps the PICs
+ */
+static int irq_initcall(void)
+{
+    irq_init();
+    return 0;
+}
+INITCALL_EARLY(irq_initcall);
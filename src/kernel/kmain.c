@@ -1,21 +1,28 @@
 
+#include "os_common.h"
 #include "io.h"
 #include "fb.h"
 #include "serial_port.h"
-#include "gdt.h"
-
-/* Frame buffer write test */
-/*#define TEST_2 */
-/* Serial buffer write test */
-#define TEST_3
-/* GDT test */
-#define TEST_4
-
-/* The C function */
-int sum_of_three(int arg1, int arg2, int arg3)
-{
-    return arg1 + arg2 + arg3;
-}
+#include "multiboot.h"
+#include "initramfs.h"
+#include "pmm.h"
+#include "paging.h"
+#include "blk.h"
+#include "virtio_blk.h"
+#include "vfs.h"
+#include "ext2.h"
+#include "cpu.h"
+#include "console.h"
+#include "shell.h"
+#include "fbcon.h"
+#include "initcall.h"
+#include "sched.h"
+
+/* Bytes read per vfs_read() when printing the motd */
+#define MOTD_CHUNK      128U
+
+/* Boot information from GRUB, NULL if we were not booted by multiboot */
+static MULTIBOOT_INFO *boot_mb_info;
 
 void init_serial_com1(void)
 {
@@ -30,8 +37,9 @@ void init_serial_com1(void)
     line_config = PACK_SERIAL_PORT_CONFIG(0, 0, 0, 0, 3);  /* 0x03 */
     serial_configure_line(SERIAL_COM1_BASE, line_config);
 
-    /* Configure FIFO: Enable, clear both buffers, 14-byte trigger, 16-byte buffer */
-    buffer_config = PACK_SERIAL_BUFFER_CONFIG(3, 0, 0, 1, 1, 1);  /* 0xC7 */
+    /* Configure FIFO: Enable, clear both buffers, 1-byte trigger, 16-byte buffer.
+     * A deeper trigger would hold typed bytes back until the FIFO timeout */
+    buffer_config = PACK_SERIAL_BUFFER_CONFIG(0, 0, 0, 1, 1, 1);  /* 0x07 */
     serial_configure_buffer(SERIAL_COM1_BASE, buffer_config);
 
     /* Configure modem: DTR + RTS enabled, AO2 for interrupts */
@@ -39,59 +47,139 @@ void init_serial_com1(void)
     serial_configure_modem(SERIAL_COM1_BASE, modem_config);
 }
 
-int main()
+/**
+ * @name serial_initcall
+ *
+ * @brief COM1 comes first so every later initcall can report over it
+ */
+static int serial_initcall(void)
 {
-#ifdef TEST_1
-    /* Print 'H' at top left (row 0, col 0), white on black */
-    fb_write_cell(PACK_FRAMEBUF_LOCATION(0, 0), 'H', FB_WHITE, FB_BLACK);
-    fb_move_cursor(PACK_CURSOR_LOCATION(0, 0));
-
-    /* Print 'i' at row 0, col 1, green on black */
-    fb_write_cell(PACK_FRAMEBUF_LOCATION(0, 1), 'i', FB_GREEN, FB_BLACK);
-    fb_move_cursor(PACK_CURSOR_LOCATION(0, 1));
-
-    /* Print '!' at row 4, col 10, light red on blue */
-    fb_write_cell(PACK_FRAMEBUF_LOCATION(4, 10), '!', FB_LIGHT_RED, FB_BLUE);
-    fb_move_cursor(PACK_CURSOR_LOCATION(4, 10));
-    /* printing "MY OS" */
-    fb_write_cell(PACK_FRAMEBUF_LOCATION(5, 2), 'M', FB_LIGHT_RED, FB_BLUE);
-    fb_move_cursor(PACK_CURSOR_LOCATION(5, 2));
-    fb_write_cell(PACK_FRAMEBUF_LOCATION(5, 3), 'Y', FB_LIGHT_RED, FB_BLUE);
-    fb_move_cursor(PACK_CURSOR_LOCATION(5, 3));
-    fb_write_cell(PACK_FRAMEBUF_LOCATION(5, 4), ' ', FB_LIGHT_RED, FB_BLUE);
-    fb_move_cursor(PACK_CURSOR_LOCATION(5, 4));
-    fb_write_cell(PACK_FRAMEBUF_LOCATION(5, 5), 'O', FB_LIGHT_RED, FB_BLUE);
-    fb_move_cursor(PACK_CURSOR_LOCATION(5, 5));
-    fb_write_cell(PACK_FRAMEBUF_LOCATION(5, 6), 'S', FB_LIGHT_RED, FB_BLUE);
-    fb_move_cursor(PACK_CURSOR_LOCATION(5, 6));
-#endif /* TEST_1 */
-
-#ifdef TEST_2
-    char message[] = "Hello world!";
-    fb_write(message, sizeof(message), DEFAULT_FG_COLOR, DEFAULT_BG_COLOUR);
-
-    fb_write("\r\n", 2, DEFAULT_FG_COLOR, FB_BLUE);
-
-    char os_message[] = "my os!";
-    fb_write(os_message, sizeof(os_message), FB_CYAN, FB_LIGHT_RED);
-#endif /* TEST_2 */
-
-#ifdef TEST_3
     init_serial_com1();
-    char serial_message[] = "Hello serial port!\n";
-    serial_write(SERIAL_COM1_BASE, serial_message, sizeof(serial_message) - 1);
-    serial_write(SERIAL_COM1_BASE, "\r\n", 2);
+    return 0;
+}
+INITCALL_EARLY(serial_initcall);
+
+/**
+ * @name memory_initcall
+ *
+ * @brief Page allocator and paging
+ */
+static int memory_initcall(void)
+{
+    pmm_init(boot_mb_info);
+    paging_init(pmm_memory_end());
+    return 0;
+}
+INITCALL_MEMORY(memory_initcall);
+
+/**
+ * @name fbcon_initcall
+ *
+ * @brief Stays in VGA text mode unless the boot loader set a 32 bpp mode
+ */
+static int fbcon_initcall(void)
+{
+    int ret;
+
+    if (boot_mb_info == NULL)
+    {
+        return 0;
+    }
+    ret = fbcon_init(boot_mb_info);
+    return (ret == FBCON_ERR_NOFB) ? 0 : ret;
+}
+INITCALL_CONSOLE(fbcon_initcall);
+
+/**
+ * @name rootfs_initcall
+ *
+ * @brief Mounts the first multiboot module as the initramfs on "/"
+ */
+static int rootfs_initcall(void)
+{
+    MULTIBOOT_MODULE *mod;
 
-    char os_serial_message[7] = "my os!\n";
-    serial_write(SERIAL_COM1_BASE, os_serial_message, sizeof(os_serial_message) - 1);
-#endif /* TEST 3 */
+    vfs_init();
+    initramfs_register_vfs();
+    ext2_register_vfs();
 
-#ifdef TEST_4
-    fb_write("Before GDT install\n", 19, DEFAULT_FG_COLOR, DEFAULT_BG_COLOUR);
-    gdt_install();
-    fb_write("After GDT install\n", 18, DEFAULT_FG_COLOR, DEFAULT_BG_COLOUR);
-#endif /* TEST_4 */
-    while (1) { asm volatile ("hlt");}
+    if ((boot_mb_info != NULL) && (boot_mb_info->flags & MULTIBOOT_INFO_MODS) &&
+        (boot_mb_info->mods_count != 0))
+    {
+        mod = (MULTIBOOT_MODULE *) boot_mb_info->mods_addr;
+        initramfs_mount((void *) mod->mod_start, mod->mod_end - mod->mod_start);
+    }
+
+    return vfs_mount("/", "initramfs", NULL);
+}
+INITCALL_FS(rootfs_initcall);
+
+/**
+ * @name disk_initcall
+ *
+ * @brief Mounts an ext2 virtio disk on "/disk"
+ *
+ * @par Probing polls the device, and nothing at boot reads the disk, so this
+ * waits until something needs it.
+ */
+static int disk_initcall(void)
+{
+    BLK_DEVICE *dev;
+    int ret;
+
+    ret = virtio_blk_init();
+    if (ret != BLK_OK)
+    {
+        return ret;
+    }
+    dev = blk_find("vda");
+    if (dev == NULL)
+    {
+        return BLK_ERR_NODEV;
+    }
+    return vfs_mount("/disk", "ext2", dev);
+}
+INITCALL_DEFINE(INITCALL_LEVEL_DEVICE, disk_initcall, INITCALL_DEFERRED);
+
+/**
+ * @name motd_initcall
+ *
+ * @brief Prints /etc/motd from the initramfs
+ */
+static int motd_initcall(void)
+{
+    char buf[MOTD_CHUNK];
+    VFS_FILE *file;
+    int err;
+    int len;
+
+    file = vfs_open("/etc/motd", &err);
+    if (file == NULL)
+    {
+        return err;
+    }
+    while ((len = vfs_read(file, buf, sizeof(buf))) > 0)
+    {
+        console_write(buf, (unsigned int) len);
+    }
+    vfs_close(file);
+    return 0;
+}
+INITCALL_LATE(motd_initcall);
+
+int kmain(unsigned int mb_magic, MULTIBOOT_INFO * mb_info)
+{
+    boot_mb_info = (mb_magic == MULTIBOOT_BOOTLOADER_MAGIC) ? mb_info : NULL;
+
+    /* The boot thread becomes the first task */
+    sched_init();
+    initcall_run_all();
+
+    /* Input arrives by interrupt from here on */
+    local_irq_enable();
+    initcall_mark_ready();
+
+    shell_run();
 
     return 0;
-}
\ No newline at end of file
+}
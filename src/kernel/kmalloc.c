@@ -0,0 +1,199 @@
+/**
+ * @file kmalloc.c
+ *
+ * @brief Implementation of the kernel heap
+ *
+ * @par Every heap page starts with a KMALLOC_PAGE header, which is how kfree()
+ * finds the size of an object. A page of a size class is cut into objects
+ * after the header and keeps its own free list. A large allocation takes
+ * contiguous pages and returns the memory just after the header.
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "kstring.h"
+#include "pmm.h"
+#include "kmalloc.h"
+
+/******************************************* Defines */
+#define KMALLOC_MAGIC_SLAB      0x534C4142U  /* "SLAB" */
+#define KMALLOC_MAGIC_LARGE     0x4C415247U  /* "LARG" */
+
+/** Size classes 16, 32, ... 2048 */
+#define KMALLOC_NR_CLASSES      8U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct KMALLOC_PAGE
+ * @brief Header at the start of every heap page
+ */
+typedef struct _KMALLOC_PAGE
+{
+    unsigned int          magic;      /**< KMALLOC_MAGIC_* */
+    unsigned int          size;       /**< Object size, or pages for large */
+    void                 *free;       /**< Free objects of this page */
+    struct _KMALLOC_PAGE *next;       /**< Next page of the class with free objects */
+} KMALLOC_PAGE;
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+/** Pages with free objects, per size class */
+static KMALLOC_PAGE *kmalloc_partial[KMALLOC_NR_CLASSES];
+
+static KMALLOC_STATS kmalloc_stats;
+
+/******************************************* Functions */
+
+/**
+ * @name kmalloc_class
+ *
+ * @brief Returns the size class index for size
+ */
+static unsigned int kmalloc_class(unsigned int size)
+{
+    unsigned int cls = 0;
+    unsigned int cls_size = KMALLOC_MIN_SIZE;
+
+    while (cls_size < size)
+    {
+        cls_size <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+/**
+ * @name kmalloc_new_slab
+ *
+ * @brief Gets a page for a size class and threads its objects on a free list
+ */
+static KMALLOC_PAGE * kmalloc_new_slab(unsigned int cls)
+{
+    KMALLOC_PAGE *page = pmm_alloc_page();
+    unsigned int size = KMALLOC_MIN_SIZE << cls;
+    unsigned int offset;
+    void **obj;
+
+    if (page == NULL)
+    {
+        return NULL;
+    }
+
+    page->magic = KMALLOC_MAGIC_SLAB;
+    page->size = size;
+    page->free = NULL;
+    page->next = NULL;
+
+    /* Objects are size aligned, the first one after the header */
+    for (offset = PAGE_SIZE - size; offset >= ALIGN_UP(sizeof(*page), size); offset -= size)
+    {
+        obj = (void **) ((unsigned char *) page + offset);
+        *obj = page->free;
+        page->free = obj;
+    }
+
+    kmalloc_stats.slab_pages++;
+    return page;
+}
+
+void * kmalloc(unsigned int size)
+{
+    KMALLOC_PAGE *page;
+    unsigned int pages;
+    unsigned int cls;
+    void **obj;
+
+    if (size == 0)
+    {
+        return NULL;
+    }
+
+    if (size > KMALLOC_MAX_SMALL)
+    {
+        pages = ALIGN_UP(size + sizeof(*page), PAGE_SIZE) >> PAGE_SHIFT;
+        page = pmm_alloc_pages(pages);
+        if (page == NULL)
+        {
+            return NULL;
+        }
+        page->magic = KMALLOC_MAGIC_LARGE;
+        page->size = pages;
+        kmalloc_stats.large_pages += pages;
+        kmalloc_stats.allocs++;
+        return page + 1;
+    }
+
+    cls = kmalloc_class(size);
+    page = kmalloc_partial[cls];
+    if (page == NULL)
+    {
+        page = kmalloc_new_slab(cls);
+        if (page == NULL)
+        {
+            return NULL;
+        }
+        kmalloc_partial[cls] = page;
+    }
+
+    obj = page->free;
+    page->free = *obj;
+    if (page->free == NULL)
+    {
+        /* Full pages drop off the list, kfree puts them back */
+        kmalloc_partial[cls] = page->next;
+        page->next = NULL;
+    }
+
+    kmalloc_stats.allocs++;
+    return obj;
+}
+
+void * kzalloc(unsigned int size)
+{
+    void *ptr = kmalloc(size);
+
+    if (ptr != NULL)
+    {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+void kfree(void * ptr)
+{
+    KMALLOC_PAGE *page;
+    unsigned int cls;
+    void **obj = ptr;
+
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    page = (KMALLOC_PAGE *) ((unsigned int) ptr & PAGE_MASK);
+    kmalloc_stats.frees++;
+
+    if (page->magic == KMALLOC_MAGIC_LARGE)
+    {
+        kmalloc_stats.large_pages -= page->size;
+        page->magic = 0;
+        pmm_free_pages(page, page->size);
+        return;
+    }
+
+    cls = kmalloc_class(page->size);
+    if (page->free == NULL)
+    {
+        /* Page was full, it has a free object again */
+        page->next = kmalloc_partial[cls];
+        kmalloc_partial[cls] = page;
+    }
+    *obj = page->free;
+    page->free = obj;
+}
+
+const KMALLOC_STATS * kmalloc_get_stats(void)
+{
+    return &kmalloc_stats;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file kprintf.c
+ *
+ * @brief Implementation of the kernel's formatted output
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "console.h"
+#include "kprintf.h"
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+
+/******************************************* Functions */
+
+/**
+ * @name put_number
+ *
+ * @brief Appends an unsigned number in the given base to buf
+ */
+static unsigned int put_number(char * buf, unsigned int pos, unsigned int size,
+                               unsigned long long val, unsigned int base,
+                               unsigned int width, char pad, int negative)
+{
+    char tmp[24];
+    unsigned int len = 0;
+    unsigned int digit;
+
+    do
+    {
+        val = div_u64_rem(val, base, &digit);
+        tmp[len++] = "0123456789abcdef"[digit];
+    } while (val != 0);
+
+    if (negative)
+    {
+        if (pad == '0')
+        {
+            /* The sign goes before the zero padding */
+            if (pos + 1 < size)
+            {
+                buf[pos++] = '-';
+            }
+            if (width)
+            {
+                width--;
+            }
+        }
+        else
+        {
+            tmp[len++] = '-';
+        }
+    }
+
+    while ((width > len) && (pos + 1 < size))
+    {
+        buf[pos++] = pad;
+        width--;
+    }
+    while (len && (pos + 1 < size))
+    {
+        buf[pos++] = tmp[--len];
+    }
+    return pos;
+}
+
+unsigned int kvsnprintf(char * buf, unsigned int size, const char * fmt, va_list ap)
+{
+    unsigned int pos = 0;
+    unsigned long long uval;
+    long long sval;
+    unsigned int width;
+    unsigned int longs;
+    const char *str;
+    char pad;
+
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    for (; (*fmt != '\0') && (pos + 1 < size); fmt++)
+    {
+        if (*fmt != '%')
+        {
+            buf[pos++] = *fmt;
+            continue;
+        }
+
+        fmt++;
+        pad = ' ';
+        width = 0;
+        longs = 0;
+        if (*fmt == '0')
+        {
+            pad = '0';
+            fmt++;
+        }
+        while ((*fmt >= '0') && (*fmt <= '9'))
+        {
+            width = (width * 10U) + (unsigned int) (*fmt - '0');
+            fmt++;
+        }
+        while (*fmt == 'l')
+        {
+            longs++;
+            fmt++;
+        }
+
+        switch (*fmt)
+        {
+        case 'd':
+            sval = (longs >= 2) ? va_arg(ap, long long) : va_arg(ap, int);
+            uval = (sval < 0) ? (unsigned long long) -sval : (unsigned long long) sval;
+            pos = put_number(buf, pos, size, uval, 10, width, pad, sval < 0);
+            break;
+        case 'u':
+        case 'x':
+            uval = (longs >= 2) ? va_arg(ap, unsigned long long)
+                                : va_arg(ap, unsigned int);
+            pos = put_number(buf, pos, size, uval, (*fmt == 'u') ? 10 : 16,
+                             width, pad, 0);
+            break;
+        case 'p':
+            uval = (unsigned int) va_arg(ap, void *);
+            pos = put_number(buf, pos, size, uval, 16, 8, '0', 0);
+            break;
+        case 'c':
+            buf[pos++] = (char) va_arg(ap, int);
+            break;
+        case 's':
+            str = va_arg(ap, const char *);
+            if (str == NULL)
+            {
+                str = "(null)";
+            }
+            while ((*str != '\0') && (pos + 1 < size))
+            {
+                buf[pos++] = *str++;
+            }
+            break;
+        case '%':
+            buf[pos++] = '%';
+            break;
+        case '\0':
+            /* Format string ends in a lone '%' */
+            fmt--;
+            break;
+        default:
+            buf[pos++] = '%';
+            if (pos + 1 < size)
+            {
+                buf[pos++] = *fmt;
+            }
+            break;
+        }
+    }
+
+    buf[pos] = '\0';
+    return pos;
+}
+
+unsigned int ksnprintf(char * buf, unsigned int size, const char * fmt, ...)
+{
+    va_list ap;
+    unsigned int len;
+
+    va_start(ap, fmt);
+    len = kvsnprintf(buf, size, fmt, ap);
+    va_end(ap);
+    return len;
+}
+
+void kprintf(const char * fmt, ...)
+{
+    char buf[KPRINTF_BUF_SIZE];
+    va_list ap;
+    unsigned int len;
+
+    va_start(ap, fmt);
+    len = kvsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    console_write(buf, len);
+}
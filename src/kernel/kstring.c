@@ -0,0 +1,157 @@
+/**
+ * @file kstring.c
+ *
+ * @brief Implementation of the kernel's memory and string helpers
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "kstring.h"
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+
+/******************************************* Functions */
+void * memset(void * dst, int c, unsigned int len)
+{
+    unsigned char *d = dst;
+    unsigned int dwords = len >> 2;
+    unsigned int fill = (unsigned char) c * 0x01010101U;
+
+    /* rep stos does a whole cache line per few cycles on anything modern */
+    asm volatile ("rep stosl"
+                  : "+D" (d), "+c" (dwords)
+                  : "a" (fill)
+                  : "memory");
+    len &= 3U;
+    while (len--)
+    {
+        *d++ = (unsigned char) c;
+    }
+    return dst;
+}
+
+void * memcpy(void * dst, const void * src, unsigned int len)
+{
+    unsigned char *d = dst;
+    const unsigned char *s = src;
+    unsigned int dwords = len >> 2;
+
+    asm volatile ("rep movsl"
+                  : "+D" (d), "+S" (s), "+c" (dwords)
+                  :
+                  : "memory");
+    len &= 3U;
+    while (len--)
+    {
+        *d++ = *s++;
+    }
+    return dst;
+}
+
+void * memmove(void * dst, const void * src, unsigned int len)
+{
+    unsigned char *d = dst;
+    const unsigned char *s = src;
+
+    if ((d <= s) || (d >= s + len))
+    {
+        return memcpy(dst, src, len);
+    }
+
+    /* Overlapping with dst above src: copy backwards */
+    while (len--)
+    {
+        d[len] = s[len];
+    }
+    return dst;
+}
+
+int memcmp(const void * a, const void * b, unsigned int len)
+{
+    const unsigned char *pa = a;
+    const unsigned char *pb = b;
+    unsigned int i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (pa[i] != pb[i])
+        {
+            return pa[i] - pb[i];
+        }
+    }
+    return 0;
+}
+
+unsigned int strlen(const char * s)
+{
+    unsigned int len = 0;
+
+    while (s[len] != '\0')
+    {
+        len++;
+    }
+    return len;
+}
+
+int strcmp(const char * a, const char * b)
+{
+    while ((*a != '\0') && (*a == *b))
+    {
+        a++;
+        b++;
+    }
+    return (unsigned char) *a - (unsigned char) *b;
+}
+
+int strncmp(const char * a, const char * b, unsigned int n)
+{
+    while (n && (*a != '\0') && (*a == *b))
+    {
+        a++;
+        b++;
+        n--;
+    }
+    if (n == 0)
+    {
+        return 0;
+    }
+    return (unsigned char) *a - (unsigned char) *b;
+}
+
+int glob_match(const char * pattern, const char * s)
+{
+    const char *star = NULL;
+    const char *retry = NULL;
+
+    while (*s != '\0')
+    {
+        if (*pattern == '*')
+        {
+            /* Try matching nothing first, widen on a mismatch */
+            star = ++pattern;
+            retry = s;
+        }
+        else if ((*pattern == '?') || (*pattern == *s))
+        {
+            pattern++;
+            s++;
+        }
+        else if (star != NULL)
+        {
+            pattern = star;
+            s = ++retry;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    while (*pattern == '*')
+    {
+        pattern++;
+    }
+    return *pattern == '\0';
+}
@@ -0,0 +1,45 @@
+/**
+ * @file ksyms.c
+ *
+ * @brief Lookups in the kernel symbol table
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "ksyms.h"
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+
+/******************************************* Functions */
+const char * ksym_lookup(unsigned int addr, unsigned int * offset)
+{
+    unsigned int lo = 0;
+    unsigned int hi = ksym_count;
+    unsigned int mid;
+
+    /* Last entry at or below addr */
+    while (lo < hi)
+    {
+        mid = lo + ((hi - lo) / 2U);
+        if (ksym_table[mid].addr <= addr)
+        {
+            lo = mid + 1U;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if (lo == 0)
+    {
+        return NULL;
+    }
+
+    if (offset != NULL)
+    {
+        *offset = addr - ksym_table[lo - 1U].addr;
+    }
+    return ksym_table[lo - 1U].name;
+}
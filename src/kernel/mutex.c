@@ -0,0 +1,139 @@
+/**
+ * @file mutex.c
+ *
+ * @brief Implementation of sleeping mutexes
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "sched.h"
+#include "wait.h"
+#include "mutex.h"
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+
+/******************************************* Functions */
+void mutex_init(MUTEX * m)
+{
+    m->owner = NULL;
+    wait_queue_init(&m->wait);
+    m->pi.next = NULL;
+    m->pi.lent = 0;
+    m->stats.acquired = 0;
+    m->stats.contended = 0;
+    m->stats.spins = 0;
+    m->stats.sleeps = 0;
+}
+
+/**
+ * @name mutex_spin
+ *
+ * @brief Tries to take the mutex while its owner is running
+ *
+ * @return 1 if taken, 0 if the owner is off the CPU or the spin ran out
+ */
+static int mutex_spin(MUTEX * m, TASK * self)
+{
+    TASK *owner;
+    unsigned int i;
+
+    for (i = 0; i < MUTEX_SPIN_MAX; i++)
+    {
+        owner = m->owner;
+        if (owner == NULL)
+        {
+            if (cmpxchg_ptr(&m->owner, NULL, self) == NULL)
+            {
+                return 1;
+            }
+            continue;
+        }
+        if (!owner->on_cpu)
+        {
+            return 0;
+        }
+        cpu_relax();
+    }
+    return 0;
+}
+
+void mutex_lock(MUTEX * m)
+{
+    TASK *self = sched_current();
+    WAIT_ENTRY wait;
+    TASK *owner;
+    unsigned int sleeps = 0;
+    unsigned int flags;
+
+    if (cmpxchg_ptr(&m->owner, NULL, self) == NULL)
+    {
+        m->stats.acquired++;
+        return;
+    }
+
+    if (mutex_spin(m, self))
+    {
+        m->stats.acquired++;
+        m->stats.contended++;
+        m->stats.spins++;
+        return;
+    }
+
+    flags = local_irq_save();
+    wait_entry_init(&wait, WAIT_EXCLUSIVE);
+    for (;;)
+    {
+        /* Queued before the retry, an unlock in between wakes us */
+        wait_prepare(&m->wait, &wait);
+        owner = cmpxchg_ptr(&m->owner, NULL, self);
+        if (owner == NULL)
+        {
+            break;
+        }
+        sched_pi_boost(owner, &m->pi, self);
+        sleeps++;
+        schedule();
+    }
+    wait_finish(&m->wait, &wait);
+    local_irq_restore(flags);
+
+    /* Counted once the mutex protects them */
+    m->stats.acquired++;
+    m->stats.contended++;
+    m->stats.sleeps += sleeps;
+}
+
+int mutex_trylock(MUTEX * m)
+{
+    if (cmpxchg_ptr(&m->owner, NULL, sched_current()) != NULL)
+    {
+        return 0;
+    }
+    m->stats.acquired++;
+    return 1;
+}
+
+void mutex_unlock(MUTEX * m)
+{
+    unsigned int flags;
+
+    flags = local_irq_save();
+    /* Takes back this mutex's boost only, others we hold keep theirs */
+    sched_pi_restore(sched_current(), &m->pi);
+    xchg_ptr(&m->owner, NULL);
+    if (waitqueue_active(&m->wait))
+    {
+        wake_up(&m->wait);
+    }
+    local_irq_restore(flags);
+}
+
+int mutex_is_locked(const MUTEX * m)
+{
+    return m->owner != NULL;
+}
@@ -0,0 +1,261 @@
+/**
+ * @file pmm.c
+ *
+ * @brief Implementation of the physical page frame allocator
+ *
+ * @par One bit per 4 KiB page, set means used. Allocation is next-fit from
+ * the last allocated page, so the common single page case rarely rescans
+ * the low, full part of the bitmap.
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "kstring.h"
+#include "pmm.h"
+
+/******************************************* Defines */
+/** RAM assumed when the bootloader gives us no memory information */
+#define PMM_DEFAULT_MEMORY      0x02000000U
+
+/******************************************* Macros */
+#define PMM_BIT_WORD(pfn)       ((pfn) >> 5)
+#define PMM_BIT_MASK(pfn)       (1U << ((pfn) & 31U))
+
+/******************************************* Static global defines */
+/** Linker script symbols around the kernel image */
+extern char kernel_start[];
+extern char kernel_end[];
+
+static unsigned int pmm_bitmap[PMM_MAX_PAGES / 32U];
+
+/** Number of pages covered by the bitmap for this machine */
+static unsigned int pmm_nr_pages;
+
+/** Where the next search starts */
+static unsigned int pmm_next;
+
+static PMM_STATS pmm_stats;
+
+/******************************************* Functions */
+
+/**
+ * @name pmm_mark
+ *
+ * @brief Marks [start, end) used or free, partially covered pages count as used
+ */
+static void pmm_mark(unsigned int start, unsigned int end, int used)
+{
+    unsigned int pfn;
+    unsigned int last;
+
+    if (used)
+    {
+        pfn = start >> PAGE_SHIFT;
+        last = ALIGN_UP(end, PAGE_SIZE) >> PAGE_SHIFT;
+    }
+    else
+    {
+        pfn = ALIGN_UP(start, PAGE_SIZE) >> PAGE_SHIFT;
+        last = end >> PAGE_SHIFT;
+    }
+    if (last > pmm_nr_pages)
+    {
+        last = pmm_nr_pages;
+    }
+
+    for (; pfn < last; pfn++)
+    {
+        if (used && !(pmm_bitmap[PMM_BIT_WORD(pfn)] & PMM_BIT_MASK(pfn)))
+        {
+            pmm_bitmap[PMM_BIT_WORD(pfn)] |= PMM_BIT_MASK(pfn);
+            pmm_stats.free_pages--;
+        }
+        else if (!used && (pmm_bitmap[PMM_BIT_WORD(pfn)] & PMM_BIT_MASK(pfn)))
+        {
+            pmm_bitmap[PMM_BIT_WORD(pfn)] &= ~PMM_BIT_MASK(pfn);
+            pmm_stats.free_pages++;
+        }
+    }
+}
+
+/**
+ * @name pmm_clip
+ *
+ * @brief Clips a 64 bit region to what the bitmap covers
+ *
+ * @return 0 if nothing is left
+ */
+static int pmm_clip(unsigned long long addr, unsigned long long len,
+                    unsigned int * start, unsigned int * end)
+{
+    unsigned long long last = addr + len;
+
+    if (addr >= PMM_MAX_MEMORY)
+    {
+        return 0;
+    }
+    if (last > PMM_MAX_MEMORY)
+    {
+        last = PMM_MAX_MEMORY;
+    }
+    *start = (unsigned int) addr;
+    *end = (unsigned int) last;
+    return *end > *start;
+}
+
+void pmm_init(const MULTIBOOT_INFO * mb_info)
+{
+    const MULTIBOOT_MMAP_ENTRY *entry;
+    const MULTIBOOT_MODULE *mods;
+    unsigned int mmap_end;
+    unsigned int mem_end = PMM_DEFAULT_MEMORY;
+    unsigned int start;
+    unsigned int end;
+    unsigned int i;
+
+    /* Pass 1: find the top of RAM */
+    if ((mb_info != NULL) && (mb_info->flags & MULTIBOOT_INFO_MEM_MAP))
+    {
+        mem_end = 0;
+        mmap_end = mb_info->mmap_addr + mb_info->mmap_length;
+        for (entry = (const MULTIBOOT_MMAP_ENTRY *) mb_info->mmap_addr;
+             (unsigned int) entry < mmap_end;
+             entry = (const MULTIBOOT_MMAP_ENTRY *) ((unsigned int) entry + entry->size + 4U))
+        {
+            if ((entry->type == MULTIBOOT_MEMORY_AVAILABLE) &&
+                pmm_clip(entry->addr, entry->len, &start, &end) && (end > mem_end))
+            {
+                mem_end = end;
+            }
+        }
+    }
+    else if ((mb_info != NULL) && (mb_info->flags & MULTIBOOT_INFO_MEMORY))
+    {
+        mem_end = PMM_LOW_MEMORY_END + (mb_info->mem_upper * 1024U);
+        if ((mem_end < PMM_LOW_MEMORY_END) || (mem_end > PMM_MAX_MEMORY))
+        {
+            mem_end = PMM_MAX_MEMORY;
+        }
+    }
+
+    /* Everything starts out used */
+    pmm_nr_pages = mem_end >> PAGE_SHIFT;
+    memset(pmm_bitmap, 0xFF, sizeof(pmm_bitmap));
+    pmm_stats.free_pages = 0;
+
+    /* Pass 2: free the usable regions */
+    if ((mb_info != NULL) && (mb_info->flags & MULTIBOOT_INFO_MEM_MAP))
+    {
+        mmap_end = mb_info->mmap_addr + mb_info->mmap_length;
+        for (entry = (const MULTIBOOT_MMAP_ENTRY *) mb_info->mmap_addr;
+             (unsigned int) entry < mmap_end;
+             entry = (const MULTIBOOT_MMAP_ENTRY *) ((unsigned int) entry + entry->size + 4U))
+        {
+            if ((entry->type == MULTIBOOT_MEMORY_AVAILABLE) &&
+                pmm_clip(entry->addr, entry->len, &start, &end))
+            {
+                pmm_mark(start, end, 0);
+            }
+        }
+    }
+    else
+    {
+        pmm_mark(PMM_LOW_MEMORY_END, mem_end, 0);
+    }
+
+    /* Pass 3: take back what is in use */
+    pmm_mark(0, PMM_LOW_MEMORY_END, 1);
+    pmm_mark((unsigned int) kernel_start, (unsigned int) kernel_end, 1);
+    if (mb_info != NULL)
+    {
+        pmm_mark((unsigned int) mb_info, (unsigned int) (mb_info + 1), 1);
+    }
+    if ((mb_info != NULL) && (mb_info->flags & MULTIBOOT_INFO_MODS))
+    {
+        mods = (const MULTIBOOT_MODULE *) mb_info->mods_addr;
+        pmm_mark(mb_info->mods_addr,
+                 mb_info->mods_addr + (mb_info->mods_count * sizeof(*mods)), 1);
+        for (i = 0; i < mb_info->mods_count; i++)
+        {
+            pmm_mark(mods[i].mod_start, mods[i].mod_end, 1);
+        }
+    }
+
+    pmm_stats.total_pages = pmm_stats.free_pages;
+    pmm_next = PMM_LOW_MEMORY_END >> PAGE_SHIFT;
+}
+
+void * pmm_alloc_pages(unsigned int count)
+{
+    unsigned int pfn;
+    unsigned int run = 0;
+    unsigned int scanned;
+
+    if ((count == 0) || (count > pmm_stats.free_pages))
+    {
+        return NULL;
+    }
+
+    /* Next-fit: one lap round the bitmap starting at pmm_next */
+    pfn = pmm_next;
+    for (scanned = 0; scanned < pmm_nr_pages + count; scanned++, pfn++)
+    {
+        if (pfn >= pmm_nr_pages)
+        {
+            /* A run can't wrap past the end */
+            pfn = 0;
+            run = 0;
+        }
+
+        /* Skip whole used words quickly */
+        if (((pfn & 31U) == 0) && (pmm_bitmap[PMM_BIT_WORD(pfn)] == 0xFFFFFFFFU))
+        {
+            run = 0;
+            pfn += 31U;
+            scanned += 31U;
+            continue;
+        }
+
+        if (pmm_bitmap[PMM_BIT_WORD(pfn)] & PMM_BIT_MASK(pfn))
+        {
+            run = 0;
+            continue;
+        }
+
+        if (++run == count)
+        {
+            pfn = pfn + 1U - count;
+            pmm_mark(pfn << PAGE_SHIFT, (pfn + count) << PAGE_SHIFT, 1);
+            pmm_next = pfn + count;
+            return (void *) (pfn << PAGE_SHIFT);
+        }
+    }
+    return NULL;
+}
+
+void * pmm_alloc_page(void)
+{
+    return pmm_alloc_pages(1);
+}
+
+void pmm_free_pages(void * addr, unsigned int count)
+{
+    unsigned int start = (unsigned int) addr;
+
+    pmm_mark(start, start + (count << PAGE_SHIFT), 0);
+}
+
+void pmm_free_page(void * addr)
+{
+    pmm_free_pages(addr, 1);
+}
+
+unsigned int pmm_memory_end(void)
+{
+    return pmm_nr_pages << PAGE_SHIFT;
+}
+
+const PMM_STATS * pmm_get_stats(void)
+{
+    return &pmm_stats;
+}
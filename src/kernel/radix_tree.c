@@ -0,0 +1,155 @@
+/**
+ * @file radix_tree.c
+ *
+ * @brief Implementation of the radix tree (page cache index)
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "kmalloc.h"
+#include "radix_tree.h"
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+/** Slot of index at a level, level 1 being the leaves */
+#define RADIX_SLOT(index, level) \
+        (((index) >> (((level) - 1U) * RADIX_TREE_MAP_SHIFT)) & RADIX_TREE_MAP_MASK)
+
+/******************************************* Functions */
+
+/**
+ * @name radix_tree_max_index
+ *
+ * @brief Largest index a tree of the given height can hold
+ */
+static unsigned int radix_tree_max_index(unsigned int height)
+{
+    if (height * RADIX_TREE_MAP_SHIFT >= 32U)
+    {
+        return 0xFFFFFFFFU;
+    }
+    return (1U << (height * RADIX_TREE_MAP_SHIFT)) - 1U;
+}
+
+void * radix_tree_lookup(const RADIX_TREE * tree, unsigned int index)
+{
+    void **node = tree->root;
+    unsigned int level;
+
+    if ((tree->height == 0) || (index > radix_tree_max_index(tree->height)))
+    {
+        return NULL;
+    }
+
+    for (level = tree->height; (level > 1U) && (node != NULL); level--)
+    {
+        node = node[RADIX_SLOT(index, level)];
+    }
+    return (node != NULL) ? node[RADIX_SLOT(index, 1U)] : NULL;
+}
+
+int radix_tree_insert(RADIX_TREE * tree, unsigned int index, void * item)
+{
+    void **node;
+    void **child;
+    unsigned int level;
+
+    /* Grow upwards until index fits, the old root becomes slot 0 */
+    while ((tree->height == 0) || (index > radix_tree_max_index(tree->height)))
+    {
+        node = kzalloc(RADIX_TREE_MAP_SIZE * sizeof(void *));
+        if (node == NULL)
+        {
+            return RADIX_TREE_ERR_NOMEM;
+        }
+        node[0] = tree->root;
+        tree->root = node;
+        tree->height++;
+    }
+
+    node = tree->root;
+    for (level = tree->height; level > 1U; level--)
+    {
+        child = node[RADIX_SLOT(index, level)];
+        if (child == NULL)
+        {
+            child = kzalloc(RADIX_TREE_MAP_SIZE * sizeof(void *));
+            if (child == NULL)
+            {
+                return RADIX_TREE_ERR_NOMEM;
+            }
+            node[RADIX_SLOT(index, level)] = child;
+        }
+        node = child;
+    }
+
+    if (node[RADIX_SLOT(index, 1U)] != NULL)
+    {
+        return RADIX_TREE_ERR_EXIST;
+    }
+    node[RADIX_SLOT(index, 1U)] = item;
+    return RADIX_TREE_OK;
+}
+
+void * radix_tree_delete(RADIX_TREE * tree, unsigned int index)
+{
+    void **node = tree->root;
+    void *item;
+    unsigned int level;
+
+    if ((tree->height == 0) || (index > radix_tree_max_index(tree->height)))
+    {
+        return NULL;
+    }
+
+    for (level = tree->height; (level > 1U) && (node != NULL); level--)
+    {
+        node = node[RADIX_SLOT(index, level)];
+    }
+    if (node == NULL)
+    {
+        return NULL;
+    }
+    item = node[RADIX_SLOT(index, 1U)];
+    node[RADIX_SLOT(index, 1U)] = NULL;
+    return item;
+}
+
+/**
+ * @name radix_tree_free_node
+ *
+ * @brief Frees a node and everything below it
+ */
+static void radix_tree_free_node(void ** node, unsigned int level,
+                                 void (*release)(void * item))
+{
+    unsigned int i;
+
+    for (i = 0; i < RADIX_TREE_MAP_SIZE; i++)
+    {
+        if (node[i] == NULL)
+        {
+            continue;
+        }
+        if (level > 1U)
+        {
+            radix_tree_free_node(node[i], level - 1U, release);
+        }
+        else if (release != NULL)
+        {
+            release(node[i]);
+        }
+    }
+    kfree(node);
+}
+
+void radix_tree_destroy(RADIX_TREE * tree, void (*release)(void * item))
+{
+    if (tree->root != NULL)
+    {
+        radix_tree_free_node(tree->root, tree->height, release);
+    }
+    tree->root = NULL;
+    tree->height = 0;
+}
@@ -0,0 +1,334 @@
+/**
+ * @file rcu.c
+ *
+ * @brief Implementation of quiescent state based RCU
+ *
+ * @par A grace period starts by setting a bit per CPU in rcu_gp.pending;
+ * each CPU clears its bit at its next quiescent state and the one clearing
+ * the last bit ends it. Callbacks move through three per-CPU lists: next
+ * (queued), wait (waiting for grace period wait_gp) and done (ready for the
+ * CPU's rcu thread). A callback only waits for a grace period that started
+ * after it was queued.
+ *
+ * The callbacks get a thread of their own rather than a kworker, so work
+ * items may wait for a grace period too.
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "kprintf.h"
+#include "sched.h"
+#include "wait.h"
+#include "initcall.h"
+#include "rcu.h"
+
+/******************************************* Defines */
+/** Bits of rcu_gp.pending, every CPU takes part */
+#define RCU_CPUS_ALL            ((1U << CPU_MAX) - 1U)
+
+#define RCU_NAME_MAX            16U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct RCU_LIST
+ * @brief Callbacks in queueing order
+ */
+typedef struct _RCU_LIST
+{
+    RCU_HEAD           *head;
+    RCU_HEAD           *last;
+} RCU_LIST;
+
+/**
+ * @struct RCU_CPU
+ * @brief Per-CPU callback lists, touched by their CPU only
+ */
+typedef struct _RCU_CPU
+{
+    RCU_LIST            next;         /**< Not waiting for a grace period yet */
+    RCU_LIST            wait;         /**< Waiting for wait_gp to end */
+    unsigned int        wait_gp;
+    RCU_LIST            done;         /**< Taken by the rcu thread */
+    TASK               *thread;       /**< Runs the done callbacks */
+    char                name[RCU_NAME_MAX];
+} RCU_CPU;
+
+/**
+ * @struct RCU_GP
+ * @brief Grace period state shared by the CPUs
+ */
+typedef struct _RCU_GP
+{
+    volatile unsigned int cur;        /**< Last grace period started */
+    volatile unsigned int completed;  /**< Last grace period ended */
+    volatile unsigned int pending;    /**< CPUs that still owe cur a quiescent state */
+    unsigned long long    start;
+} RCU_GP;
+
+/**
+ * @struct RCU_SYNC
+ * @brief A callback that wakes a thread, for synchronize_rcu()
+ */
+typedef struct _RCU_SYNC
+{
+    RCU_HEAD            head;
+    COMPLETION          done;
+} RCU_SYNC;
+
+/******************************************* Macros */
+/** Sequence a has been reached by b, with wrap around */
+#define RCU_SEQ_DONE(a, b)      ((int) ((b) - (a)) >= 0)
+
+/******************************************* Static global defines */
+static RCU_CPU rcu_cpus[CPU_MAX];
+
+static RCU_GP rcu_gp;
+
+static RCU_STATS rcu_stats;
+
+/******************************************* Functions */
+/**
+ * @name rcu_list_splice
+ *
+ * @brief Moves every callback of from to the end of to
+ */
+static void rcu_list_splice(RCU_LIST * to, RCU_LIST * from)
+{
+    if (from->head == NULL)
+    {
+        return;
+    }
+    if (to->head == NULL)
+    {
+        to->head = from->head;
+    }
+    else
+    {
+        to->last->next = from->head;
+    }
+    to->last = from->last;
+    from->head = NULL;
+    from->last = NULL;
+}
+
+/**
+ * @name rcu_gp_start
+ *
+ * @brief Starts a grace period unless another CPU just did
+ */
+static void rcu_gp_start(void)
+{
+    unsigned int completed = rcu_gp.completed;
+
+    if (cmpxchg(&rcu_gp.cur, completed, completed + 1U) != completed)
+    {
+        return;
+    }
+    rcu_gp.start = rdtsc();
+    rcu_gp.pending = RCU_CPUS_ALL;
+    rcu_stats.gp_started++;
+}
+
+/**
+ * @name rcu_gp_end
+ *
+ * @brief Ends grace period gp, by the CPU that reported last
+ */
+static void rcu_gp_end(unsigned int gp)
+{
+    unsigned long long cycles = rdtsc() - rcu_gp.start;
+
+    rcu_stats.gp_completed++;
+    rcu_stats.gp_sum += cycles;
+    if (cycles > rcu_stats.gp_max)
+    {
+        rcu_stats.gp_max = cycles;
+    }
+
+    /* Readers of the old version are gone before anyone sees the end */
+    mb();
+    rcu_gp.completed = gp;
+}
+
+/**
+ * @name rcu_advance
+ *
+ * @brief Hands finished callbacks to the thread and lets the queued ones
+ * wait for the next grace period, starting it if none runs
+ *
+ * @note Called with interrupts disabled.
+ */
+static void rcu_advance(RCU_CPU * rc)
+{
+    if ((rc->wait.head != NULL) && RCU_SEQ_DONE(rc->wait_gp, rcu_gp.completed))
+    {
+        rcu_list_splice(&rc->done, &rc->wait);
+        if (rc->thread != NULL)
+        {
+            sched_wake(rc->thread);
+        }
+    }
+
+    /* The first grace period to start from now on covers them */
+    if ((rc->wait.head == NULL) && (rc->next.head != NULL))
+    {
+        rcu_list_splice(&rc->wait, &rc->next);
+        rc->wait_gp = rcu_gp.cur + 1U;
+    }
+
+    if ((rc->wait.head != NULL) && (rcu_gp.cur == rcu_gp.completed) &&
+        !RCU_SEQ_DONE(rc->wait_gp, rcu_gp.cur))
+    {
+        rcu_gp_start();
+    }
+}
+
+void rcu_note_qs(void)
+{
+    unsigned int bit = 1U << cpu_id();
+    unsigned int gp = rcu_gp.cur;
+    unsigned int pending;
+
+    if ((gp != rcu_gp.completed) && (rcu_gp.pending & bit))
+    {
+        do
+        {
+            pending = rcu_gp.pending;
+        } while (cmpxchg(&rcu_gp.pending, pending, pending & ~bit) != pending);
+
+        rcu_stats.qs++;
+        if ((pending & ~bit) == 0)
+        {
+            rcu_gp_end(gp);
+        }
+    }
+    rcu_advance(&rcu_cpus[cpu_id()]);
+}
+
+void call_rcu(RCU_HEAD * head, RCU_FUNC func)
+{
+    RCU_CPU *rc = &rcu_cpus[cpu_id()];
+    unsigned int flags;
+
+    head->next = NULL;
+    head->func = func;
+
+    flags = local_irq_save();
+    if (rc->next.head == NULL)
+    {
+        rc->next.head = head;
+    }
+    else
+    {
+        rc->next.last->next = head;
+    }
+    rc->next.last = head;
+    rcu_stats.queued++;
+    rcu_advance(rc);
+    local_irq_restore(flags);
+}
+
+/**
+ * @name rcu_thread
+ *
+ * @brief rcu/<cpu>, runs the callbacks whose grace period ended and sleeps
+ * until rcu_advance() hands it more
+ */
+static void rcu_thread(void * arg)
+{
+    RCU_CPU *rc = arg;
+    RCU_LIST list;
+    RCU_HEAD *head;
+    RCU_HEAD *next;
+    unsigned int flags;
+
+    while (1)
+    {
+        /* Recheck with interrupts off, a grace period ending after this
+         * check finds us sleeping and wakes us */
+        flags = local_irq_save();
+        if (rc->done.head == NULL)
+        {
+            sched_current()->state = TASK_SLEEPING;
+            schedule();
+        }
+        list.head = NULL;
+        list.last = NULL;
+        rcu_list_splice(&list, &rc->done);
+        local_irq_restore(flags);
+
+        for (head = list.head; head != NULL; head = next)
+        {
+            next = head->next;
+            head->func(head);
+            rcu_stats.invoked++;
+        }
+    }
+}
+
+/**
+ * @name rcu_sync_done
+ *
+ * @brief Callback of synchronize_rcu() and rcu_barrier()
+ */
+static void rcu_sync_done(RCU_HEAD * head)
+{
+    complete(&CONTAINER_OF(head, RCU_SYNC, head)->done);
+}
+
+/**
+ * @name rcu_wait_callback
+ *
+ * @brief Queues a callback and sleeps until it ran
+ */
+static void rcu_wait_callback(void)
+{
+    RCU_SYNC sync;
+
+    completion_init(&sync.done);
+    call_rcu(&sync.head, rcu_sync_done);
+    wait_for_completion(&sync.done);
+}
+
+void synchronize_rcu(void)
+{
+    rcu_stats.syncs++;
+    rcu_wait_callback();
+}
+
+void rcu_barrier(void)
+{
+    /* Callbacks of a CPU run in queueing order, ours is the last one */
+    rcu_wait_callback();
+}
+
+const RCU_STATS * rcu_get_stats(void)
+{
+    return &rcu_stats;
+}
+
+/**
+ * @name rcu_initcall
+ *
+ * @brief Starts the per-CPU callback threads, callbacks whose grace period
+ * ended before wait in their done list
+ */
+static int rcu_initcall(void)
+{
+    RCU_CPU *rc;
+    unsigned int cpu;
+
+    for (cpu = 0; cpu < CPU_MAX; cpu++)
+    {
+        rc = &rcu_cpus[cpu];
+        ksnprintf(rc->name, sizeof(rc->name), "rcu/%u", cpu);
+        rc->thread = kthread_create(rc->name, rcu_thread, rc);
+        if (rc->thread == NULL)
+        {
+            return RCU_ERR_NOMEM;
+        }
+    }
+    return 0;
+}
+INITCALL_CORE(rcu_initcall);
@@ -0,0 +1,360 @@
+/**
+ * @file sched.c
+ *
+ * @brief Implementation of kernel threads and the cooperative scheduler
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "pmm.h"
+#include "kmalloc.h"
+#include "sched.h"
+#include "rcu.h"
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+/** kmain(), later the shell */
+static TASK sched_boot_task;
+
+static TASK *sched_cur;
+
+/** Set by sched_wake(), cleared when schedule() runs */
+static volatile unsigned int sched_resched;
+
+/** Context switches so far, lets sched_yield() tell if anyone else ran */
+static volatile unsigned int sched_switches;
+
+/** preempt_disable() nesting per CPU */
+static volatile unsigned int sched_preempt[CPU_MAX];
+
+/******************************************* Functions */
+void sched_init(void)
+{
+    sched_boot_task.name = "kmain";
+    sched_boot_task.state = TASK_RUNNABLE;
+    sched_boot_task.on_cpu = 1;
+    sched_boot_task.prio = SCHED_PRIO_DEFAULT;
+    sched_boot_task.base_prio = SCHED_PRIO_DEFAULT;
+    sched_boot_task.next = &sched_boot_task;
+    sched_boot_task.run_start = rdtsc();
+    sched_cur = &sched_boot_task;
+}
+
+TASK * sched_current(void)
+{
+    return sched_cur;
+}
+
+/**
+ * @name sched_task_start
+ *
+ * @brief First code of every new thread, entered from sched_switch()
+ */
+static void sched_task_start(void)
+{
+    TASK *self = sched_cur;
+
+    /* schedule() switched to us with interrupts disabled */
+    local_irq_enable();
+    self->fn(self->arg);
+
+    local_irq_disable();
+    self->state = TASK_DEAD;
+    schedule();
+}
+
+/**
+ * @name sched_reap
+ *
+ * @brief Frees threads that returned
+ *
+ * @note Called with interrupts disabled.
+ */
+static void sched_reap(void)
+{
+    TASK *prev = sched_cur;
+    TASK *t = sched_cur->next;
+
+    while (t != sched_cur)
+    {
+        if (t->state == TASK_DEAD)
+        {
+            prev->next = t->next;
+            pmm_free_pages(t->stack, KTHREAD_STACK_PAGES);
+            kfree(t);
+            t = prev->next;
+            continue;
+        }
+        prev = t;
+        t = t->next;
+    }
+}
+
+TASK * kthread_create(const char * name, void (*fn)(void * arg), void * arg)
+{
+    unsigned int *sp;
+    unsigned int flags;
+    TASK *task;
+
+    task = kzalloc(sizeof(*task));
+    if (task == NULL)
+    {
+        return NULL;
+    }
+    task->stack = pmm_alloc_pages(KTHREAD_STACK_PAGES);
+    if (task->stack == NULL)
+    {
+        kfree(task);
+        return NULL;
+    }
+    task->name = name;
+    task->fn = fn;
+    task->arg = arg;
+    task->state = TASK_RUNNABLE;
+    task->prio = SCHED_PRIO_DEFAULT;
+    task->base_prio = SCHED_PRIO_DEFAULT;
+
+    /* What sched_switch() pops: edi, esi, ebx, ebp, then its return address.
+     * The last word stands in for the return address of sched_task_start */
+    sp = (unsigned int *) ((unsigned char *) task->stack + (KTHREAD_STACK_PAGES * PAGE_SIZE));
+    *--sp = 0;
+    *--sp = (unsigned int) sched_task_start;
+    *--sp = 0;
+    *--sp = 0;
+    *--sp = 0;
+    *--sp = 0;
+    task->esp = (unsigned int) sp;
+
+    flags = local_irq_save();
+    sched_reap();
+    task->next = sched_cur->next;
+    sched_cur->next = task;
+    local_irq_restore(flags);
+    return task;
+}
+
+/**
+ * @name sched_pick
+ *
+ * @brief Next runnable task after the current one, round robin
+ *
+ * @return The task (the current one last), or NULL if none is runnable
+ */
+static TASK * sched_pick(void)
+{
+    TASK *best = NULL;
+    TASK *t = sched_cur;
+
+    /* Starts after the current task and ends with it, so the first of
+     * equally urgent tasks is the next in round robin order */
+    do
+    {
+        t = t->next;
+        if ((t->state == TASK_RUNNABLE) && ((best == NULL) || (t->prio < best->prio)))
+        {
+            best = t;
+        }
+    } while (t != sched_cur);
+
+    return best;
+}
+
+void schedule(void)
+{
+    unsigned long long now;
+    unsigned int flags;
+    TASK *prev;
+    TASK *next;
+
+    flags = local_irq_save();
+    sched_resched = 0;
+
+    /* The caller holds no RCU references across this, unless it is in a
+     * reader; may make the RCU callback thread runnable */
+    if (sched_preempt[cpu_id()] == 0)
+    {
+        rcu_note_qs();
+    }
+
+    /* Nothing to run: halt on the current stack until an interrupt wakes a
+     * task. Interrupt handlers may run here, they do not need a task */
+    while ((next = sched_pick()) == NULL)
+    {
+        cpu_idle();
+        local_irq_disable();
+        if (sched_preempt[cpu_id()] == 0)
+        {
+            rcu_note_qs();
+        }
+    }
+
+    prev = sched_cur;
+    if (next != prev)
+    {
+        now = rdtsc();
+        prev->run_cycles += now - prev->run_start;
+        next->run_start = now;
+        next->switches++;
+        prev->on_cpu = 0;
+        next->on_cpu = 1;
+        sched_switches++;
+        sched_cur = next;
+        sched_switch(&prev->esp, next->esp);
+    }
+
+    local_irq_restore(flags);
+}
+
+int sched_yield(void)
+{
+    unsigned int before = sched_switches;
+
+    schedule();
+    return sched_switches != before;
+}
+
+void sched_wake(TASK * task)
+{
+    unsigned int flags;
+
+    flags = local_irq_save();
+    if (task->state == TASK_SLEEPING)
+    {
+        task->state = TASK_RUNNABLE;
+        sched_resched = 1;
+    }
+    local_irq_restore(flags);
+}
+
+int sched_need_resched(void)
+{
+    return sched_resched != 0;
+}
+
+void preempt_disable(void)
+{
+    sched_preempt[cpu_id()]++;
+    barrier();
+}
+
+void preempt_enable(void)
+{
+    barrier();
+    sched_preempt[cpu_id()]--;
+}
+
+unsigned int preempt_count(void)
+{
+    return sched_preempt[cpu_id()];
+}
+
+/**
+ * @name sched_pi_prio
+ *
+ * @brief The priority of task with the boosts of the locks it holds
+ */
+static unsigned int sched_pi_prio(const TASK * task)
+{
+    unsigned int prio = task->base_prio;
+    const SCHED_PI *pi;
+
+    for (pi = task->pi_held; pi != NULL; pi = pi->next)
+    {
+        if (pi->prio < prio)
+        {
+            prio = pi->prio;
+        }
+    }
+    return prio;
+}
+
+void sched_set_prio(TASK * task, unsigned int prio)
+{
+    unsigned int flags;
+
+    flags = local_irq_save();
+    /* A boost in force stays until sched_pi_restore() */
+    task->base_prio = prio;
+    task->prio = sched_pi_prio(task);
+    local_irq_restore(flags);
+}
+
+void sched_pi_boost(TASK * owner, SCHED_PI * pi, const TASK * waiter)
+{
+    if (!pi->lent)
+    {
+        pi->prio = waiter->prio;
+        pi->next = owner->pi_held;
+        owner->pi_held = pi;
+        pi->lent = 1;
+    }
+    else if (waiter->prio < pi->prio)
+    {
+        pi->prio = waiter->prio;
+    }
+
+    if (pi->prio < owner->prio)
+    {
+        owner->prio = pi->prio;
+        owner->pi_boosts++;
+        sched_resched = 1;
+    }
+}
+
+void sched_pi_restore(TASK * task, SCHED_PI * pi)
+{
+    SCHED_PI **link;
+    unsigned int prio;
+
+    if (!pi->lent)
+    {
+        return;
+    }
+    for (link = &task->pi_held; *link != NULL; link = &(*link)->next)
+    {
+        if (*link == pi)
+        {
+            *link = pi->next;
+            break;
+        }
+    }
+    pi->next = NULL;
+    pi->lent = 0;
+
+    prio = sched_pi_prio(task);
+    if (prio != task->prio)
+    {
+        task->prio = prio;
+        sched_resched = 1;
+    }
+}
+
+unsigned long long sched_task_cycles(const TASK * task)
+{
+    unsigned long long cycles;
+    unsigned int flags;
+
+    flags = local_irq_save();
+    cycles = task->run_cycles;
+    if (task == sched_cur)
+    {
+        cycles += rdtsc() - task->run_start;
+    }
+    local_irq_restore(flags);
+    return cycles;
+}
+
+void sched_for_each(void (*fn)(const TASK * task))
+{
+    TASK *t = sched_cur;
+
+    do
+    {
+        fn(t);
+        t = t->next;
+    } while (t != sched_cur);
+}
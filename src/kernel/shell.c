@@ -0,0 +1,531 @@
+/**
+ * @file shell.c
+ *
+ * @brief Implementation of the kernel console shell
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "tsc.h"
+#include "kstring.h"
+#include "kprintf.h"
+#include "console.h"
+#include "input.h"
+#include "irq.h"
+#include "pmm.h"
+#include "kmalloc.h"
+#include "vfs.h"
+#include "virtio_blk.h"
+#include "fbcon.h"
+#include "initcall.h"
+#include "sched.h"
+#include "softirq.h"
+#include "workqueue.h"
+#include "serial_port.h"
+#include "ftrace.h"
+#include "rcu.h"
+#include "bench.h"
+#include "shell.h"
+
+/******************************************* Defines */
+#define SHELL_PROMPT            "> "
+
+/* Line discipline control characters */
+#define SHELL_CHAR_INTR         INPUT_CHAR_CTRL('c')
+#define SHELL_CHAR_KILL         INPUT_CHAR_CTRL('u')
+
+/** Bytes read per vfs_read() by cat */
+#define SHELL_CAT_CHUNK         256U
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+static void shell_cmd_help(unsigned int argc, char ** argv);
+static void shell_cmd_stats(unsigned int argc, char ** argv);
+static void shell_cmd_bench(unsigned int argc, char ** argv);
+static void shell_cmd_cat(unsigned int argc, char ** argv);
+static void shell_cmd_boot(unsigned int argc, char ** argv);
+static void shell_cmd_trace(unsigned int argc, char ** argv);
+
+static const SHELL_COMMAND shell_commands[] =
+{
+    { "help",  "list commands",                                         shell_cmd_help  },
+    { "stats", "[input|irq|mem|vfs|blk|fb|defer|reset] dump counters",  shell_cmd_stats },
+    { "bench", "<blk|vfs|fb|defer|ipc|trace|lock|rcu> run a benchmark", shell_cmd_bench },
+    { "cat",   "<path> print a file",                                   shell_cmd_cat   },
+    { "boot",  "print the boot timeline",                               shell_cmd_boot  },
+    { "trace", "[on|off <glob>|reset] trace functions, or report",      shell_cmd_trace },
+};
+
+static const char * const shell_input_names[INPUT_NR_SOURCES] =
+{
+    "keyboard", "serial",
+};
+
+/******************************************* Functions */
+unsigned int shell_readline(char * buf, unsigned int size)
+{
+    unsigned int len = 0;
+    char c;
+
+    while (1)
+    {
+        c = (char) input_getc();
+
+        if (c == '\n')
+        {
+            console_write("\n", 1);
+            break;
+        }
+        if (c == INPUT_CHAR_BACKSPACE)
+        {
+            if (len > 0)
+            {
+                len--;
+                console_write("\b \b", 3);
+            }
+            continue;
+        }
+        if (c == SHELL_CHAR_KILL)
+        {
+            while (len > 0)
+            {
+                len--;
+                console_write("\b \b", 3);
+            }
+            continue;
+        }
+        if (c == SHELL_CHAR_INTR)
+        {
+            console_write("^C\n", 3);
+            len = 0;
+            break;
+        }
+        if ((c < ' ') || (c > '~') || (len + 1U >= size))
+        {
+            continue;
+        }
+        buf[len++] = c;
+        console_write(&c, 1);
+    }
+
+    buf[len] = '\0';
+    return len;
+}
+
+/**
+ * @name shell_split
+ *
+ * @brief Splits a line into words in place
+ */
+static unsigned int shell_split(char * line, char ** argv)
+{
+    unsigned int argc = 0;
+
+    while (*line != '\0')
+    {
+        while (*line == ' ')
+        {
+            *line++ = '\0';
+        }
+        if ((*line == '\0') || (argc == SHELL_MAX_ARGS))
+        {
+            break;
+        }
+        argv[argc++] = line;
+        while ((*line != ' ') && (*line != '\0'))
+        {
+            line++;
+        }
+    }
+    return argc;
+}
+
+static void shell_cmd_help(unsigned int argc, char ** argv)
+{
+    unsigned int i;
+
+    (void) argc;
+    (void) argv;
+
+    for (i = 0; i < ARRAY_SIZE(shell_commands); i++)
+    {
+        kprintf("  %s %s\n", shell_commands[i].name, shell_commands[i].help);
+    }
+}
+
+/**
+ * @name shell_stats_input
+ *
+ * @brief Prints event counts and interrupt-to-consumer latency per source
+ */
+static void shell_stats_input(void)
+{
+    const INPUT_STATS *st;
+    unsigned long long avg;
+    unsigned int src;
+
+    for (src = 0; src < INPUT_NR_SOURCES; src++)
+    {
+        st = input_get_stats(src);
+        avg = (st->events != 0) ? div_u64_rem(st->lat_sum, st->events, NULL) : 0;
+        kprintf("input %s: %u events %u chars %u dropped\n",
+                shell_input_names[src], st->events, st->chars, st->dropped);
+        kprintf("  wake latency cycles avg %u min %u max %u (avg %u us)\n",
+                (unsigned int) avg, (unsigned int) st->lat_min,
+                (unsigned int) st->lat_max, (unsigned int) tsc_cycles_to_us(avg));
+    }
+}
+
+/**
+ * @name shell_stats_irq
+ *
+ * @brief Prints the interrupt counters of the lines that fired
+ */
+static void shell_stats_irq(void)
+{
+    const IRQ_STATS *st = irq_get_stats();
+    unsigned int irq;
+
+    for (irq = 0; irq < IRQ_COUNT; irq++)
+    {
+        if (st->count[irq] != 0)
+        {
+            kprintf("irq %2u: %u\n", irq, st->count[irq]);
+        }
+    }
+    kprintf("irq spurious %u unhandled %u\n", st->spurious, st->unhandled);
+}
+
+/**
+ * @name shell_stats_mem
+ *
+ * @brief Prints page allocator and heap counters
+ */
+static void shell_stats_mem(void)
+{
+    const PMM_STATS *pmm = pmm_get_stats();
+    const KMALLOC_STATS *km = kmalloc_get_stats();
+
+    kprintf("pmm: %u of %u pages free\n", pmm->free_pages, pmm->total_pages);
+    kprintf("kmalloc: %u allocs %u frees, %u slab pages %u large pages\n",
+            km->allocs, km->frees, km->slab_pages, km->large_pages);
+}
+
+/**
+ * @name shell_stats_vfs
+ *
+ * @brief Prints dentry and page cache counters
+ */
+static void shell_stats_vfs(void)
+{
+    const VFS_STATS *st = vfs_get_stats();
+
+    kprintf("vfs: dcache %u hits (%u negative) %u misses, %u entries (%u negative)\n",
+            st->dcache_hits, st->dcache_neg_hits, st->dcache_misses,
+            st->dcache_entries, st->dcache_negative);
+    kprintf("vfs: page cache %u hits %u misses, %u cached, %u mapped\n",
+            st->page_hits, st->page_misses, st->page_cached, st->mmap_pages);
+}
+
+/**
+ * @name shell_stats_blk
+ *
+ * @brief Prints the virtio-blk queue counters
+ */
+static void shell_stats_blk(void)
+{
+    const VIRTIO_BLK_STATS *st = virtio_blk_get_stats();
+
+    kprintf("virtio-blk: %u submitted %u completed %u in flight, %u doorbells %u suppressed, %u irqs\n",
+            st->submitted, st->completed, virtio_blk_inflight(), st->kicks, st->kicks_skipped,
+            st->irqs);
+}
+
+/**
+ * @name shell_stats_fb
+ *
+ * @brief Prints the graphics console counters
+ */
+static void shell_stats_fb(void)
+{
+    const FBCON_STATS *st = fbcon_get_stats();
+
+    if (!fbcon_active())
+    {
+        kprintf("fb: VGA text mode\n");
+        return;
+    }
+    kprintf("fb: %ux%u write-combining %s, %u glyphs %u scrolls\n",
+            st->width, st->height, st->write_combining ? "on" : "off",
+            st->glyphs, st->scrolls);
+    kprintf("fb: %u flushes, %u KiB in %u us\n", st->flushes,
+            (unsigned int) (st->flushed_bytes >> 10),
+            (unsigned int) tsc_cycles_to_us(st->flush_cycles));
+}
+
+/**
+ * @name shell_stats_task
+ *
+ * @brief Prints one kernel thread
+ */
+static void shell_stats_task(const TASK * task)
+{
+    static const char * const states[] = { "run", "sleep", "dead" };
+
+    kprintf("  %s %s prio %u, %u switches, %u us, %u boosts\n", task->name,
+            states[task->state], task->prio, task->switches,
+            (unsigned int) tsc_cycles_to_us(task->run_cycles), task->pi_boosts);
+}
+
+/**
+ * @name shell_stats_defer
+ *
+ * @brief Prints softirq, workqueue, serial transmit, RCU and thread counters
+ */
+static void shell_stats_defer(void)
+{
+    const SOFTIRQ_CPU_STATS *cpu = softirq_get_cpu_stats(cpu_id());
+    static const char * const names[SOFTIRQ_NR] = { "serial", "blk" };
+    const WORKQUEUE_STATS *wq = workqueue_get_stats(cpu_id());
+    const SERIAL_TX_STATS *tx = serial_get_tx_stats();
+    const RCU_STATS *rcu = rcu_get_stats();
+    const SOFTIRQ_STATS *sirq;
+    unsigned int nr;
+
+    for (nr = 0; nr < SOFTIRQ_NR; nr++)
+    {
+        sirq = softirq_get_stats(nr);
+        kprintf("softirq %s: %u raised %u runs, latency avg %u max %u us\n",
+                names[nr], sirq->raised, sirq->runs,
+                (unsigned int) tsc_cycles_to_us((sirq->runs != 0) ?
+                                                div_u64_rem(sirq->lat_sum, sirq->runs, NULL) : 0),
+                (unsigned int) tsc_cycles_to_us(sirq->lat_max));
+    }
+    kprintf("softirq cpu%u: %u irq exits %u restarts %u handoffs %u ksoftirqd runs\n",
+            cpu_id(), cpu->irq_exits, cpu->restarts, cpu->handoffs, cpu->thread_runs);
+    kprintf("workqueue cpu%u: %u queued %u merged %u run, depth %u max %u\n",
+            cpu_id(), wq->queued, wq->merged, wq->run, wq->depth, wq->max_depth);
+    kprintf("  latency avg %u max %u us, run avg %u max %u us\n",
+            (unsigned int) tsc_cycles_to_us((wq->run != 0) ?
+                                            div_u64_rem(wq->lat_sum, wq->run, NULL) : 0),
+            (unsigned int) tsc_cycles_to_us(wq->lat_max),
+            (unsigned int) tsc_cycles_to_us((wq->run != 0) ?
+                                            div_u64_rem(wq->run_sum, wq->run, NULL) : 0),
+            (unsigned int) tsc_cycles_to_us(wq->run_max));
+    kprintf("serial tx: %u queued %u polled, %u refills %u full waits, %u pending\n",
+            tx->queued, tx->polled, tx->refills, tx->full_waits, serial_tx_pending());
+    kprintf("rcu: %u grace periods, avg %u max %u us, %u/%u callbacks run, %u syncs\n",
+            rcu->gp_completed,
+            (unsigned int) tsc_cycles_to_us((rcu->gp_completed != 0) ?
+                                            div_u64_rem(rcu->gp_sum, rcu->gp_completed, NULL) : 0),
+            (unsigned int) tsc_cycles_to_us(rcu->gp_max),
+            rcu->invoked, rcu->queued, rcu->syncs);
+    kprintf("threads:\n");
+    sched_for_each(shell_stats_task);
+}
+
+static void shell_cmd_stats(unsigned int argc, char ** argv)
+{
+    const char *what = (argc > 1U) ? argv[1] : NULL;
+
+    initcall_sync_all();
+    if ((what != NULL) && (strcmp(what, "reset") == 0))
+    {
+        input_reset_stats();
+        softirq_reset_stats();
+        workqueue_reset_stats();
+        return;
+    }
+    if ((what == NULL) || (strcmp(what, "input") == 0))
+    {
+        shell_stats_input();
+    }
+    if ((what == NULL) || (strcmp(what, "irq") == 0))
+    {
+        shell_stats_irq();
+    }
+    if ((what == NULL) || (strcmp(what, "mem") == 0))
+    {
+        shell_stats_mem();
+    }
+    if ((what == NULL) || (strcmp(what, "vfs") == 0))
+    {
+        shell_stats_vfs();
+    }
+    if ((what == NULL) || (strcmp(what, "blk") == 0))
+    {
+        shell_stats_blk();
+    }
+    if ((what == NULL) || (strcmp(what, "fb") == 0))
+    {
+        shell_stats_fb();
+    }
+    if ((what == NULL) || (strcmp(what, "defer") == 0))
+    {
+        shell_stats_defer();
+    }
+}
+
+static void shell_cmd_bench(unsigned int argc, char ** argv)
+{
+    initcall_sync_all();
+
+    if (argc < 2U)
+    {
+        kprintf("usage: bench <blk|vfs|fb|defer|ipc|trace|lock|rcu>\n");
+    }
+    else if (strcmp(argv[1], "blk") == 0)
+    {
+        bench_blk_qd_sweep();
+    }
+    else if (strcmp(argv[1], "vfs") == 0)
+    {
+        bench_vfs_read();
+    }
+    else if (strcmp(argv[1], "fb") == 0)
+    {
+        bench_fb_console();
+    }
+    else if (strcmp(argv[1], "defer") == 0)
+    {
+        bench_defer();
+    }
+    else if (strcmp(argv[1], "ipc") == 0)
+    {
+        bench_ipc();
+    }
+    else if (strcmp(argv[1], "trace") == 0)
+    {
+        bench_trace();
+    }
+    else if (strcmp(argv[1], "lock") == 0)
+    {
+        bench_lock();
+    }
+    else if (strcmp(argv[1], "rcu") == 0)
+    {
+        bench_rcu();
+    }
+    else
+    {
+        kprintf("bench: unknown benchmark %s\n", argv[1]);
+    }
+}
+
+static void shell_cmd_cat(unsigned int argc, char ** argv)
+{
+    char buf[SHELL_CAT_CHUNK];
+    VFS_FILE *file;
+    int err;
+    int len;
+
+    if (argc < 2U)
+    {
+        kprintf("usage: cat <path>\n");
+        return;
+    }
+
+    /* The disk is mounted at its first use */
+    initcall_sync_all();
+
+    file = vfs_open(argv[1], &err);
+    if (file == NULL)
+    {
+        kprintf("cat: %s: error %d\n", argv[1], err);
+        return;
+    }
+    while ((len = vfs_read(file, buf, sizeof(buf))) > 0)
+    {
+        console_write(buf, (unsigned int) len);
+    }
+    vfs_close(file);
+}
+
+static void shell_cmd_boot(unsigned int argc, char ** argv)
+{
+    (void) argc;
+    (void) argv;
+
+    initcall_report(console_write);
+}
+
+/**
+ * @name shell_trace_func
+ *
+ * @brief Prints the counters of one traced function
+ */
+static void shell_trace_func(const FTRACE_FUNC * func)
+{
+    kprintf("  %8u calls %10u us %8u cycles/call  %s\n", func->calls,
+            (unsigned int) tsc_cycles_to_us(func->cycles),
+            (unsigned int) div_u64_rem(func->cycles, func->calls, NULL), func->name);
+}
+
+static void shell_cmd_trace(unsigned int argc, char ** argv)
+{
+    const FTRACE_STATS *st = ftrace_get_stats();
+    int ret;
+
+    if (argc == 1U)
+    {
+        kprintf("trace: %u of %u functions traced, %u calls too deep\n",
+                st->enabled, st->sites, st->overflows);
+        ftrace_for_each(shell_trace_func);
+        return;
+    }
+    if ((argc == 2U) && (strcmp(argv[1], "reset") == 0))
+    {
+        ftrace_reset();
+        return;
+    }
+    if ((argc != 3U) || ((strcmp(argv[1], "on") != 0) && (strcmp(argv[1], "off") != 0)))
+    {
+        kprintf("usage: trace [on|off <glob>|reset]\n");
+        return;
+    }
+
+    ret = (strcmp(argv[1], "on") == 0) ? ftrace_enable(argv[2]) : ftrace_disable(argv[2]);
+    if (ret < 0)
+    {
+        kprintf("trace: no function matches %s\n", argv[2]);
+        return;
+    }
+    kprintf("trace: %d functions matched\n", ret);
+}
+
+void shell_run(void)
+{
+    char line[SHELL_LINE_MAX];
+    char *argv[SHELL_MAX_ARGS];
+    unsigned int argc;
+    unsigned int i;
+
+    kprintf("\nType 'help' for a list of commands.\n");
+
+    while (1)
+    {
+        console_write(SHELL_PROMPT, sizeof(SHELL_PROMPT) - 1U);
+        shell_readline(line, sizeof(line));
+
+        argc = shell_split(line, argv);
+        if (argc == 0)
+        {
+            continue;
+        }
+
+        for (i = 0; i < ARRAY_SIZE(shell_commands); i++)
+        {
+            if (strcmp(argv[0], shell_commands[i].name) == 0)
+            {
+                shell_commands[i].run(argc, argv);
+                break;
+            }
+        }
+        if (i == ARRAY_SIZE(shell_commands))
+        {
+            kprintf("%s: unknown command\n", argv[0]);
+        }
+    }
+}
@@ -0,0 +1,256 @@
+/**
+ * @file softirq.c
+ *
+ * @brief Implementation of softirq bottom halves and ksoftirqd
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "tsc.h"
+#include "kstring.h"
+#include "kprintf.h"
+#include "sched.h"
+#include "initcall.h"
+#include "softirq.h"
+
+/******************************************* Defines */
+/** Budget in cycles while the TSC is not calibrated yet */
+#define SOFTIRQ_BUDGET_FALLBACK 4000000ULL
+
+#define SOFTIRQ_THREAD_NAME_MAX 16U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct SOFTIRQ_CPU
+ * @brief Per-CPU softirq state
+ */
+typedef struct _SOFTIRQ_CPU
+{
+    volatile unsigned int pending;            /**< Bit per raised softirq */
+    unsigned int          irq_depth;          /**< Nesting of hardware interrupts */
+    unsigned int          active;             /**< Softirqs running */
+    unsigned long long    raise_tsc[SOFTIRQ_NR]; /**< First raise since the last run */
+    TASK                 *thread;             /**< ksoftirqd */
+    char                  name[SOFTIRQ_THREAD_NAME_MAX];
+    SOFTIRQ_CPU_STATS     stats;
+} SOFTIRQ_CPU;
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+static SOFTIRQ_HANDLER softirq_handlers[SOFTIRQ_NR];
+
+static SOFTIRQ_STATS softirq_stats[SOFTIRQ_NR];
+
+static SOFTIRQ_CPU softirq_cpus[CPU_MAX];
+
+/******************************************* Functions */
+void softirq_open(unsigned int nr, SOFTIRQ_HANDLER handler)
+{
+    softirq_handlers[nr] = handler;
+}
+
+void softirq_raise(unsigned int nr)
+{
+    SOFTIRQ_CPU *sc = &softirq_cpus[cpu_id()];
+    unsigned int bit = 1U << nr;
+
+    /* Latency counts from the first raise, later ones are merged into it */
+    if (!(sc->pending & bit))
+    {
+        sc->raise_tsc[nr] = rdtsc();
+    }
+    atomic_add(&softirq_stats[nr].raised, 1);
+    atomic_or(&sc->pending, bit);
+}
+
+/**
+ * @name softirq_budget
+ *
+ * @brief SOFTIRQ_BUDGET_US in TSC cycles
+ */
+static unsigned long long softirq_budget(void)
+{
+    if (tsc_khz() == 0)
+    {
+        return SOFTIRQ_BUDGET_FALLBACK;
+    }
+    return div_u64_rem((unsigned long long) tsc_khz() * SOFTIRQ_BUDGET_US, 1000U, NULL);
+}
+
+/**
+ * @name softirq_run
+ *
+ * @brief Runs pending softirqs until none are left or the budget is spent
+ *
+ * @note Called and returns with interrupts disabled, enables them while the
+ * handlers run.
+ *
+ * @return 1 if softirqs are still pending
+ */
+static int softirq_run(SOFTIRQ_CPU * sc)
+{
+    unsigned long long raised[SOFTIRQ_NR];
+    unsigned long long budget = softirq_budget();
+    unsigned long long start = rdtsc();
+    unsigned long long begin;
+    unsigned long long run;
+    unsigned int passes = 0;
+    unsigned int pending;
+    unsigned int nr;
+    SOFTIRQ_STATS *st;
+
+    sc->active = 1;
+    do
+    {
+        /* Interrupts are off, nothing can raise between the copy and the
+         * swap on this CPU */
+        memcpy(raised, sc->raise_tsc, sizeof(raised));
+        pending = xchg(&sc->pending, 0);
+        local_irq_enable();
+
+        for (nr = 0; pending != 0; nr++, pending >>= 1)
+        {
+            if (!(pending & 1U) || (softirq_handlers[nr] == NULL))
+            {
+                continue;
+            }
+
+            st = &softirq_stats[nr];
+            begin = rdtsc();
+            softirq_handlers[nr]();
+            run = rdtsc() - begin;
+
+            st->runs++;
+            st->lat_sum += begin - raised[nr];
+            if (begin - raised[nr] > st->lat_max)
+            {
+                st->lat_max = begin - raised[nr];
+            }
+            st->run_sum += run;
+            if (run > st->run_max)
+            {
+                st->run_max = run;
+            }
+        }
+
+        local_irq_disable();
+        passes++;
+    } while ((sc->pending != 0) && (passes < SOFTIRQ_MAX_RESTART) &&
+             (rdtsc() - start < budget));
+
+    sc->stats.restarts += passes - 1U;
+    sc->active = 0;
+    return sc->pending != 0;
+}
+
+void irq_enter(void)
+{
+    softirq_cpus[cpu_id()].irq_depth++;
+}
+
+void irq_exit(void)
+{
+    SOFTIRQ_CPU *sc = &softirq_cpus[cpu_id()];
+
+    sc->irq_depth--;
+
+    /* A nested interrupt leaves the work to the softirq run it interrupted */
+    if ((sc->irq_depth != 0) || sc->active || (sc->pending == 0))
+    {
+        return;
+    }
+
+    sc->stats.irq_exits++;
+    if (softirq_run(sc) && (sc->thread != NULL))
+    {
+        sc->stats.handoffs++;
+        sched_wake(sc->thread);
+    }
+}
+
+int in_interrupt(void)
+{
+    SOFTIRQ_CPU *sc = &softirq_cpus[cpu_id()];
+
+    return (sc->irq_depth != 0) || sc->active;
+}
+
+/**
+ * @name softirq_thread
+ *
+ * @brief ksoftirqd, runs what interrupt exits left over, between threads
+ */
+static void softirq_thread(void * arg)
+{
+    SOFTIRQ_CPU *sc = arg;
+    unsigned int flags;
+
+    while (1)
+    {
+        flags = local_irq_save();
+        if ((sc->pending != 0) && !sc->active)
+        {
+            sc->stats.thread_runs++;
+            softirq_run(sc);
+            local_irq_restore(flags);
+
+            /* Still a budget per pass, give the other threads a turn */
+            sched_yield();
+            continue;
+        }
+
+        sched_current()->state = TASK_SLEEPING;
+        schedule();
+        local_irq_restore(flags);
+    }
+}
+
+const SOFTIRQ_STATS * softirq_get_stats(unsigned int nr)
+{
+    return &softirq_stats[nr];
+}
+
+const SOFTIRQ_CPU_STATS * softirq_get_cpu_stats(unsigned int cpu)
+{
+    return &softirq_cpus[cpu].stats;
+}
+
+void softirq_reset_stats(void)
+{
+    unsigned int flags;
+    unsigned int cpu;
+
+    flags = local_irq_save();
+    memset(softirq_stats, 0, sizeof(softirq_stats));
+    for (cpu = 0; cpu < CPU_MAX; cpu++)
+    {
+        memset(&softirq_cpus[cpu].stats, 0, sizeof(softirq_cpus[cpu].stats));
+    }
+    local_irq_restore(flags);
+}
+
+/**
+ * @name softirq_initcall
+ *
+ * @brief Starts a ksoftirqd per CPU
+ */
+static int softirq_initcall(void)
+{
+    SOFTIRQ_CPU *sc;
+    unsigned int cpu;
+
+    for (cpu = 0; cpu < CPU_MAX; cpu++)
+    {
+        sc = &softirq_cpus[cpu];
+        ksnprintf(sc->name, sizeof(sc->name), "ksoftirqd/%u", cpu);
+        sc->thread = kthread_create(sc->name, softirq_thread, sc);
+        if (sc->thread == NULL)
+        {
+            return SCHED_ERR_NOMEM;
+        }
+    }
+    return 0;
+}
+INITCALL_CORE(softirq_initcall);
@@ -0,0 +1,85 @@
+/**
+ * @file tsc.c
+ *
+ * @brief Implementation of time stamp counter calibration
+ */
+
+/******************************************* Includes */
+#include "io.h"
+#include "os_common.h"
+#include "cpu.h"
+#include "tsc.h"
+#include "initcall.h"
+
+/******************************************* Defines */
+/** Speaker port: bit 0 gates channel 2, bit 1 drives the speaker, bit 5 is OUT2 */
+#define PIT_SPEAKER_GATE2           0x01U
+#define PIT_SPEAKER_DATA            0x02U
+#define PIT_SPEAKER_OUT2            0x20U
+
+/** Channel 2, lobyte/hibyte access, mode 0 (interrupt on terminal count) */
+#define PIT_CMD_CH2_MODE0           0xB0U
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+static unsigned int tsc_freq_khz;
+
+/******************************************* Functions */
+unsigned int tsc_calibrate(void)
+{
+    unsigned int count = (PIT_FREQUENCY_HZ * TSC_CALIBRATE_MS) / 1000U;
+    unsigned char speaker;
+    unsigned long long start;
+    unsigned long long end;
+
+    /* Gate off and speaker off while we program the counter */
+    speaker = inb(PIT_SPEAKER_PORT) & ~(PIT_SPEAKER_GATE2 | PIT_SPEAKER_DATA);
+    outb(PIT_SPEAKER_PORT, speaker);
+
+    outb(PIT_COMMAND_PORT, PIT_CMD_CH2_MODE0);
+    outb(PIT_CHANNEL2_DATA_PORT, count & 0xFFU);
+    outb(PIT_CHANNEL2_DATA_PORT, (count >> 8) & 0xFFU);
+
+    /* Opening the gate starts the count down, OUT2 goes high at zero */
+    outb(PIT_SPEAKER_PORT, speaker | PIT_SPEAKER_GATE2);
+    start = rdtsc();
+    while (!(inb(PIT_SPEAKER_PORT) & PIT_SPEAKER_OUT2))
+    {
+    }
+    end = rdtsc();
+
+    outb(PIT_SPEAKER_PORT, speaker);
+
+    tsc_freq_khz = (unsigned int) div_u64_rem(end - start, TSC_CALIBRATE_MS, NULL);
+    return tsc_freq_khz;
+}
+
+unsigned int tsc_khz(void)
+{
+    return tsc_freq_khz;
+}
+
+unsigned long long tsc_cycles_to_us(unsigned long long cycles)
+{
+    if (tsc_freq_khz < 1000U)
+    {
+        return 0;
+    }
+    return div_u64_rem(cycles, tsc_freq_khz / 1000U, NULL);
+}
+
+/**
+ * @name tsc_initcall
+ *
+ * @brief Calibrates in the background, the PIT wait would stall the boot
+ */
+static int tsc_initcall(void)
+{
+    if (tsc_freq_khz == 0)
+    {
+        tsc_calibrate();
+    }
+    return 0;
+}
+INITCALL_DEFINE(INITCALL_LEVEL_LATE, tsc_initcall, INITCALL_ASYNC);
@@ -0,0 +1,170 @@
+/**
+ * @file wait.c
+ *
+ * @brief Implementation of wait queues and completions
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "sched.h"
+#include "wait.h"
+
+/******************************************* Defines */
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+
+/******************************************* Functions */
+void wait_queue_init(WAIT_QUEUE * wq)
+{
+    wq->head = NULL;
+}
+
+void wait_entry_init(WAIT_ENTRY * entry, unsigned int flags)
+{
+    entry->next = NULL;
+    entry->task = sched_current();
+    entry->flags = flags;
+    entry->queued = 0;
+}
+
+void wait_prepare(WAIT_QUEUE * wq, WAIT_ENTRY * entry)
+{
+    WAIT_ENTRY **link = &wq->head;
+
+    if (!entry->queued)
+    {
+        if (entry->flags & WAIT_EXCLUSIVE)
+        {
+            /* Behind everyone, exclusive waiters are served in order */
+            while (*link != NULL)
+            {
+                link = &(*link)->next;
+            }
+        }
+        entry->next = *link;
+        *link = entry;
+        entry->queued = 1;
+    }
+    entry->task->state = TASK_SLEEPING;
+}
+
+void wait_finish(WAIT_QUEUE * wq, WAIT_ENTRY * entry)
+{
+    WAIT_ENTRY **link;
+
+    entry->task->state = TASK_RUNNABLE;
+    if (!entry->queued)
+    {
+        return;
+    }
+
+    /* The condition came true without a wakeup for us */
+    for (link = &wq->head; *link != NULL; link = &(*link)->next)
+    {
+        if (*link == entry)
+        {
+            *link = entry->next;
+            break;
+        }
+    }
+    entry->queued = 0;
+}
+
+unsigned int wake_up_nr(WAIT_QUEUE * wq, unsigned int nr)
+{
+    WAIT_ENTRY **link = &wq->head;
+    WAIT_ENTRY *entry;
+    unsigned int exclusive = 0;
+    unsigned int woken = 0;
+    unsigned int flags;
+
+    flags = local_irq_save();
+    while (((entry = *link) != NULL) && (exclusive < nr))
+    {
+        *link = entry->next;
+        entry->queued = 0;
+        if (entry->flags & WAIT_EXCLUSIVE)
+        {
+            exclusive++;
+        }
+        sched_wake(entry->task);
+        woken++;
+    }
+    local_irq_restore(flags);
+    return woken;
+}
+
+int waitqueue_active(const WAIT_QUEUE * wq)
+{
+    return wq->head != NULL;
+}
+
+void completion_init(COMPLETION * c)
+{
+    c->done = 0;
+    wait_queue_init(&c->wait);
+}
+
+void reinit_completion(COMPLETION * c)
+{
+    c->done = 0;
+}
+
+void complete(COMPLETION * c)
+{
+    unsigned int flags;
+
+    flags = local_irq_save();
+    if (c->done != COMPLETION_DONE_ALL)
+    {
+        c->done++;
+    }
+    wake_up(&c->wait);
+    local_irq_restore(flags);
+}
+
+void complete_all(COMPLETION * c)
+{
+    unsigned int flags;
+
+    flags = local_irq_save();
+    c->done = COMPLETION_DONE_ALL;
+    wake_up_all(&c->wait);
+    local_irq_restore(flags);
+}
+
+void wait_for_completion(COMPLETION * c)
+{
+    unsigned int flags;
+
+    /* Waiting and consuming in one go, another waiter may be woken by the
+     * same count otherwise */
+    flags = local_irq_save();
+    wait_event_exclusive(&c->wait, c->done != 0);
+    if (c->done != COMPLETION_DONE_ALL)
+    {
+        c->done--;
+    }
+    local_irq_restore(flags);
+}
+
+int try_wait_for_completion(COMPLETION * c)
+{
+    unsigned int flags;
+    int ret = 0;
+
+    flags = local_irq_save();
+    if (c->done != 0)
+    {
+        if (c->done != COMPLETION_DONE_ALL)
+        {
+            c->done--;
+        }
+        ret = 1;
+    }
+    local_irq_restore(flags);
+    return ret;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file workqueue.c
+ *
+ * @brief Implementation of the per-CPU workqueues and their workers
+ */
+
+/******************************************* Includes */
+#include "os_common.h"
+#include "cpu.h"
+#include "kstring.h"
+#include "kprintf.h"
+#include "sched.h"
+#include "initcall.h"
+#include "workqueue.h"
+
+/******************************************* Defines */
+#define WORKQUEUE_NAME_MAX      16U
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct WORKQUEUE
+ * @brief A CPU's queue and its worker
+ */
+typedef struct _WORKQUEUE
+{
+    void * volatile  head;            /**< Newest WORK, pushed with cmpxchg */
+    TASK            *worker;
+    char             name[WORKQUEUE_NAME_MAX];
+    WORKQUEUE_STATS  stats;
+} WORKQUEUE;
+
+/******************************************* Macros */
+
+/******************************************* Static global defines */
+static WORKQUEUE workqueues[CPU_MAX];
+
+/******************************************* Functions */
+void work_init(WORK * work, WORK_FUNC fn)
+{
+    work->next = NULL;
+    work->fn = fn;
+    work->pending = 0;
+    work->queued = 0;
+}
+
+int queue_work_on(unsigned int cpu, WORK * work)
+{
+    WORKQUEUE *wq = &workqueues[cpu];
+    WORKQUEUE_STATS *st = &wq->stats;
+    unsigned int depth;
+    void *old;
+
+    if (xchg(&work->pending, 1) != 0)
+    {
+        atomic_add(&st->merged, 1);
+        return 0;
+    }
+    work->queued = rdtsc();
+
+    do
+    {
+        old = wq->head;
+        work->next = old;
+    } while (cmpxchg_ptr(&wq->head, old, work) != old);
+
+    atomic_add(&st->queued, 1);
+    depth = atomic_add(&st->depth, 1);
+    if (depth > st->max_depth)
+    {
+        st->max_depth = depth;
+    }
+
+    if (wq->worker != NULL)
+    {
+        sched_wake(wq->worker);
+    }
+    return 1;
+}
+
+int queue_work(WORK * work)
+{
+    return queue_work_on(cpu_id(), work);
+}
+
+/**
+ * @name workqueue_run
+ *
+ * @brief Runs a batch taken off the queue, in the order it was queued
+ */
+static void workqueue_run(WORKQUEUE * wq, WORK * list)
+{
+    WORKQUEUE_STATS *st = &wq->stats;
+    unsigned long long start;
+    unsigned long long lat;
+    unsigned long long run;
+    WORK *prev = NULL;
+    WORK *next;
+    WORK *work;
+
+    /* Reverse into queueing order */
+    while (list != NULL)
+    {
+        next = list->next;
+        list->next = prev;
+        prev = list;
+        list = next;
+    }
+
+    for (work = prev; work != NULL; work = next)
+    {
+        next = work->next;
+        start = rdtsc();
+        lat = start - work->queued;
+
+        /* From here on it may be queued again, and then runs again */
+        barrier();
+        work->pending = 0;
+        atomic_add(&st->depth, (unsigned int) -1);
+
+        work->fn(work);
+        run = rdtsc() - start;
+
+        st->run++;
+        st->lat_sum += lat;
+        if (lat > st->lat_max)
+        {
+            st->lat_max = lat;
+        }
+        st->run_sum += run;
+        if (run > st->run_max)
+        {
+            st->run_max = run;
+        }
+    }
+}
+
+/**
+ * @name workqueue_thread
+ *
+ * @brief kworker, sleeps until work is queued
+ */
+static void workqueue_thread(void * arg)
+{
+    WORKQUEUE *wq = arg;
+    unsigned int flags;
+    WORK *list;
+
+    while (1)
+    {
+        list = xchg_ptr(&wq->head, NULL);
+        if (list != NULL)
+        {
+            workqueue_run(wq, list);
+            sched_yield();
+            continue;
+        }
+
+        /* Recheck with interrupts off, a queue_work() from an interrupt
+         * after this check finds us sleeping and wakes us */
+        flags = local_irq_save();
+        if (wq->head == NULL)
+        {
+            sched_current()->state = TASK_SLEEPING;
+            schedule();
+        }
+        local_irq_restore(flags);
+    }
+}
+
+const WORKQUEUE_STATS * workqueue_get_stats(unsigned int cpu)
+{
+    return &workqueues[cpu].stats;
+}
+
+void workqueue_reset_stats(void)
+{
+    WORKQUEUE_STATS *st;
+    unsigned int flags;
+    unsigned int depth;
+    unsigned int cpu;
+
+    flags = local_irq_save();
+    for (cpu = 0; cpu < CPU_MAX; cpu++)
+    {
+        st = &workqueues[cpu].stats;
+        depth = st->depth;
+        memset(st, 0, sizeof(*st));
+        st->depth = depth;
+    }
+    local_irq_restore(flags);
+}
+
+/**
+ * @name workqueue_initcall
+ *
+ * @brief Starts a kworker per CPU
+ */
+static int workqueue_initcall(void)
+{
+    WORKQUEUE *wq;
+    unsigned int cpu;
+
+    for (cpu = 0; cpu < CPU_MAX; cpu++)
+    {
+        wq = &workqueues[cpu];
+        ksnprintf(wq->name, sizeof(wq->name), "kworker/%u", cpu);
+        wq->worker = kthread_create(wq->name, workqueue_thread, wq);
+        if (wq->worker == NULL)
+        {
+            return WORKQUEUE_ERR_NOMEM;
+        }
+    }
+    return 0;
+}
+INITCALL_CORE(workqueue_initcall);
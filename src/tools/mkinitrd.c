@@ -0,0 +1,211 @@
+/**
+ * @file mkinitrd.c
+ *
+ * @brief Host tool that packs a directory tree into an initramfs archive
+ *
+ * @par Usage: mkinitrd <root dir> <output image>
+ *
+ * Every regular file below the root dir is stored under its path relative
+ * to it (e.g. root/etc/motd becomes "etc/motd"). See initramfs.h for the
+ * archive layout.
+ */
+
+/******************************************* Includes */
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define INITRAMFS_HOST_TOOL
+#include "initramfs.h"
+
+/******************************************* Defines */
+#define MKINITRD_MAX_PATH   4096
+
+/******************************************* Typedefs/structures */
+/**
+ * @struct MKINITRD_FILE
+ * @brief A file collected from the root dir
+ */
+typedef struct _MKINITRD_FILE
+{
+    char          *name;          /**< Path relative to the root */
+    char          *src;           /**< Path on the host */
+    unsigned int   size;          /**< File size */
+} MKINITRD_FILE;
+
+/******************************************* Static global defines */
+static MKINITRD_FILE *files;
+static unsigned int nr_files;
+static unsigned int max_files;
+
+/******************************************* Functions */
+
+/**
+ * @name add_file
+ *
+ * @brief Appends a file to the list
+ */
+static void add_file(const char * name, const char * src, unsigned int size)
+{
+    if (nr_files == max_files)
+    {
+        max_files = max_files ? (max_files * 2) : 64;
+        files = realloc(files, max_files * sizeof(*files));
+        if (files == NULL)
+        {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    files[nr_files].name = strdup(name);
+    files[nr_files].src = strdup(src);
+    files[nr_files].size = size;
+    nr_files++;
+}
+
+/**
+ * @name walk
+ *
+ * @brief Recursively collects the regular files below dir
+ *
+ * @param dir    Host directory
+ * @param prefix Archive path of dir ("" for the root)
+ */
+static void walk(const char * dir, const char * prefix)
+{
+    char src[MKINITRD_MAX_PATH];
+    char name[MKINITRD_MAX_PATH];
+    struct dirent *de;
+    struct stat st;
+    DIR *d;
+
+    d = opendir(dir);
+    if (d == NULL)
+    {
+        perror(dir);
+        exit(1);
+    }
+
+    while ((de = readdir(d)) != NULL)
+    {
+        if ((strcmp(de->d_name, ".") == 0) || (strcmp(de->d_name, "..") == 0))
+        {
+            continue;
+        }
+        snprintf(src, sizeof(src), "%s/%s", dir, de->d_name);
+        snprintf(name, sizeof(name), "%s%s", prefix, de->d_name);
+        if (stat(src, &st) != 0)
+        {
+            perror(src);
+            exit(1);
+        }
+
+        if (S_ISDIR(st.st_mode))
+        {
+            strncat(name, "/", sizeof(name) - strlen(name) - 1);
+            walk(src, name);
+        }
+        else if (S_ISREG(st.st_mode))
+        {
+            add_file(name, src, (unsigned int) st.st_size);
+        }
+    }
+    closedir(d);
+}
+
+/**
+ * @name compare_files
+ *
+ * @brief Sorts by name: the image is reproducible and the kernel binary
+ * searches the entries for directories
+ */
+static int compare_files(const void * a, const void * b)
+{
+    return strcmp(((const MKINITRD_FILE *) a)->name, ((const MKINITRD_FILE *) b)->name);
+}
+
+int main(int argc, char ** argv)
+{
+    INITRAMFS_HEADER hdr;
+    INITRAMFS_ENTRY *entries;
+    unsigned char *image;
+    unsigned int offset;
+    unsigned int i;
+    FILE *in;
+    FILE *out;
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <root dir> <output image>\n", argv[0]);
+        return 1;
+    }
+
+    walk(argv[1], "");
+    qsort(files, nr_files, sizeof(*files), compare_files);
+
+    entries = calloc(nr_files ? nr_files : 1, sizeof(*entries));
+    if (entries == NULL)
+    {
+        perror("calloc");
+        return 1;
+    }
+
+    /* Names follow the entry table, then the page aligned file data */
+    offset = sizeof(hdr) + (nr_files * sizeof(INITRAMFS_ENTRY));
+    for (i = 0; i < nr_files; i++)
+    {
+        entries[i].name_len = strlen(files[i].name);
+        entries[i].name_offset = offset;
+        entries[i].hash = initramfs_hash(files[i].name, entries[i].name_len);
+        entries[i].next = INITRAMFS_NO_ENTRY;
+        offset += entries[i].name_len + 1;
+    }
+    for (i = 0; i < nr_files; i++)
+    {
+        offset = (offset + INITRAMFS_DATA_ALIGN - 1) & ~(INITRAMFS_DATA_ALIGN - 1);
+        entries[i].data_offset = offset;
+        entries[i].data_len = files[i].size;
+        offset += files[i].size;
+    }
+    /* The last file's final page stays inside the archive */
+    offset = (offset + INITRAMFS_DATA_ALIGN - 1) & ~(INITRAMFS_DATA_ALIGN - 1);
+
+    hdr.magic = INITRAMFS_MAGIC;
+    hdr.version = INITRAMFS_VERSION;
+    hdr.nr_entries = nr_files;
+    hdr.total_size = offset;
+
+    image = calloc(1, offset);
+    if (image == NULL)
+    {
+        perror("calloc");
+        return 1;
+    }
+    memcpy(image, &hdr, sizeof(hdr));
+    memcpy(image + sizeof(hdr), entries, nr_files * sizeof(INITRAMFS_ENTRY));
+    for (i = 0; i < nr_files; i++)
+    {
+        memcpy(image + entries[i].name_offset, files[i].name, entries[i].name_len + 1);
+
+        in = fopen(files[i].src, "rb");
+        if ((in == NULL) ||
+            (fread(image + entries[i].data_offset, 1, files[i].size, in) != files[i].size))
+        {
+            perror(files[i].src);
+            return 1;
+        }
+        fclose(in);
+    }
+
+    out = fopen(argv[2], "wb");
+    if ((out == NULL) || (fwrite(image, 1, offset, out) != offset) || (fclose(out) != 0))
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    printf("mkinitrd: %u files, %u bytes\n", nr_files, offset);
+    return 0;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file mkksyms.c
+ *
+ * @brief Host tool that turns nm output into the kernel symbol table
+ *
+ * @par Usage: nm -n kernel.elf | mkksyms > ksyms.c
+ *
+ * Keeps the text symbols (functions, nm type t or T) and writes them as the
+ * ksym_table of ksyms.h. With no input the table is empty, which is what
+ * the first of the two kernel links uses.
+ */
+
+/******************************************* Includes */
+#include <stdio.h>
+#include <string.h>
+
+/******************************************* Defines */
+#define MKKSYMS_MAX_LINE    512
+
+/******************************************* Functions */
+
+/**
+ * @name is_local_label
+ *
+ * @brief Returns 1 for assembler labels that are not functions
+ */
+static int is_local_label(const char * name)
+{
+    return (name[0] == '.') || (strncmp(name, "__x86.get_pc_thunk", 18) == 0);
+}
+
+int main(void)
+{
+    char line[MKKSYMS_MAX_LINE];
+    char name[MKKSYMS_MAX_LINE];
+    unsigned int addr;
+    unsigned int count = 0;
+    char type;
+
+    printf("/* Generated by mkksyms, do not edit */\n");
+    printf("#include \"ksyms.h\"\n\n");
+    printf("const KSYM ksym_table[] =\n{\n");
+
+    while (fgets(line, sizeof(line), stdin) != NULL)
+    {
+        if (sscanf(line, "%x %c %511s", &addr, &type, name) != 3)
+        {
+            continue;
+        }
+        if (((type != 't') && (type != 'T')) || is_local_label(name))
+        {
+            continue;
+        }
+        printf("    { 0x%08xU, \"%s\" },\n", addr, name);
+        count++;
+    }
+
+    /* Keeps the array non-empty, not counted */
+    printf("    { 0xFFFFFFFFU, \"\" },\n");
+    printf("};\n\n");
+    printf("const unsigned int ksym_count = %uU;\n", count);
+    return 0;
+}